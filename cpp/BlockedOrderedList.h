@@ -0,0 +1,221 @@
+#ifndef BLOCKED_ORDERED_LIST_H
+#define BLOCKED_ORDERED_LIST_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * BlockedOrderedList - Order-statistic list of unique keys
+ * Keys are kept in sorted blocks of at most BLOCK_MAX keys, and a Fenwick
+ * tree over the block sizes gives the number of keys ahead of any block.
+ * Finding a key's block is a binary search over the block ends, so position
+ * queries are O(log n), inserts and erases O(log n + BLOCK_MAX) with a short
+ * contiguous shift instead of a pointer chase per tree level, and reading k
+ * consecutive keys is O(log n + k).
+ *
+ * Not synchronized; owners guard it with their own lock.
+ * @tparam Key Key type (copied into the blocks)
+ * @tparam Before Strict weak ordering of keys; keys ordered neither way are equal
+ */
+template <typename Key, typename Before>
+class BlockedOrderedList {
+public:
+    static constexpr size_t BLOCK_MAX = 256; // A fuller block is split in half
+    static constexpr size_t BLOCK_MIN = 32;  // An emptier block is merged into a neighbour
+
+private:
+    std::vector<std::vector<Key>> blocks; // Each sorted; together in key order
+    std::vector<Key> lastKeys;            // Last key of each block, for the block search
+    std::vector<uint32_t> fenwick;        // Block sizes, 1-based Fenwick tree
+    size_t count = 0;
+
+    static bool before(const Key& a, const Key& b) { return Before()(a, b); }
+
+    // First block whose last key is not before the key (blocks.size() if none)
+    size_t blockFor(const Key& key) const {
+        return static_cast<size_t>(std::lower_bound(lastKeys.begin(), lastKeys.end(), key, before) -
+                                   lastKeys.begin());
+    }
+
+    size_t keysBefore(size_t block) const {
+        size_t total = 0;
+        for (size_t i = block; i > 0; i -= i & (~i + 1)) {
+            total += fenwick[i];
+        }
+        return total;
+    }
+
+    void addToBlock(size_t block, int delta) {
+        for (size_t i = block + 1; i < fenwick.size(); i += i & (~i + 1)) {
+            fenwick[i] += static_cast<uint32_t>(delta);
+        }
+    }
+
+    void reindex() {
+        // Only block headers are read, so this stays cheap with many blocks
+        fenwick.assign(blocks.size() + 1, 0);
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            // Linear Fenwick construction: each node passes its sum to its parent
+            fenwick[b + 1] += static_cast<uint32_t>(blocks[b].size());
+            size_t parent = (b + 1) + ((b + 1) & (~(b + 1) + 1));
+            if (parent < fenwick.size()) {
+                fenwick[parent] += fenwick[b + 1];
+            }
+        }
+    }
+
+    // Split, merge or drop a block after it changed size, then re-index
+    void rebalance(size_t block) {
+        std::vector<Key>& keys = blocks[block];
+        if (keys.size() > BLOCK_MAX) {
+            std::vector<Key> upper(keys.begin() + keys.size() / 2, keys.end());
+            keys.resize(keys.size() / 2);
+            lastKeys[block] = keys.back();
+            lastKeys.insert(lastKeys.begin() + block + 1, upper.back());
+            blocks.insert(blocks.begin() + block + 1, std::move(upper));
+        } else if (keys.empty()) {
+            lastKeys.erase(lastKeys.begin() + block);
+            blocks.erase(blocks.begin() + block);
+        } else if (keys.size() < BLOCK_MIN && blocks.size() > 1) {
+            // Fold into a neighbour so sparse regions do not leave many tiny blocks
+            size_t into = (block + 1 < blocks.size()) ? block + 1 : block - 1;
+            std::vector<Key>& other = blocks[into];
+            if (into > block) {
+                other.insert(other.begin(), keys.begin(), keys.end());
+            } else {
+                other.insert(other.end(), keys.begin(), keys.end());
+                lastKeys[into] = keys.back();
+            }
+            lastKeys.erase(lastKeys.begin() + block);
+            blocks.erase(blocks.begin() + block);
+            size_t merged = (into > block) ? block : into;
+            if (blocks[merged].size() > BLOCK_MAX) {
+                rebalance(merged);
+                return;
+            }
+        } else {
+            lastKeys[block] = keys.back();
+            return;
+        }
+        reindex();
+    }
+
+public:
+    /**
+     * Replace the contents in O(n log n), without per-key inserts
+     * @param keys Distinct keys, in any order
+     */
+    void assign(std::vector<Key> keys) {
+        std::sort(keys.begin(), keys.end(), before);
+        blocks.clear();
+        lastKeys.clear();
+        // Half-full blocks leave room for inserts before the first splits
+        const size_t fill = BLOCK_MAX / 2;
+        for (size_t first = 0; first < keys.size(); first += fill) {
+            size_t last = std::min(first + fill, keys.size());
+            blocks.emplace_back(keys.begin() + first, keys.begin() + last);
+            lastKeys.push_back(keys[last - 1]);
+        }
+        count = keys.size();
+        reindex();
+    }
+
+    /**
+     * Add a key (must not already be present)
+     */
+    void insert(const Key& key) {
+        if (blocks.empty()) {
+            blocks.push_back({key});
+            lastKeys.push_back(key);
+            reindex();
+            count = 1;
+            return;
+        }
+        size_t block = std::min(blockFor(key), blocks.size() - 1);
+        std::vector<Key>& keys = blocks[block];
+        keys.insert(std::lower_bound(keys.begin(), keys.end(), key, before), key);
+        addToBlock(block, 1);
+        count++;
+        rebalance(block);
+    }
+
+    /**
+     * Remove a key
+     * @return True if the key was present
+     */
+    bool erase(const Key& key) {
+        size_t block = blockFor(key);
+        if (block == blocks.size()) {
+            return false;
+        }
+        std::vector<Key>& keys = blocks[block];
+        auto it = std::lower_bound(keys.begin(), keys.end(), key, before);
+        if (it == keys.end() || before(key, *it)) {
+            return false;
+        }
+        keys.erase(it);
+        addToBlock(block, -1);
+        count--;
+        rebalance(block);
+        return true;
+    }
+
+    /**
+     * Number of keys ordered before a key
+     * @return 0-based position the key has or would have
+     */
+    size_t countBefore(const Key& key) const {
+        size_t block = blockFor(key);
+        if (block == blocks.size()) {
+            return count;
+        }
+        const std::vector<Key>& keys = blocks[block];
+        return keysBefore(block) +
+               static_cast<size_t>(std::lower_bound(keys.begin(), keys.end(), key, before) - keys.begin());
+    }
+
+    /**
+     * Visit keys in order, starting at the first key not before a bound
+     * @param from Lower bound
+     * @param visit Called with each key; return false to stop
+     */
+    template <typename Visitor>
+    void collect(const Key& from, Visitor visit) const {
+        for (size_t block = blockFor(from); block < blocks.size(); ++block) {
+            const std::vector<Key>& keys = blocks[block];
+            for (auto it = std::lower_bound(keys.begin(), keys.end(), from, before); it != keys.end(); ++it) {
+                if (!visit(*it)) {
+                    return;
+                }
+            }
+        }
+    }
+
+    /**
+     * Visit keys in order from the first
+     * @param visit Called with each key; return false to stop
+     */
+    template <typename Visitor>
+    void collect(Visitor visit) const {
+        for (const std::vector<Key>& keys : blocks) {
+            for (const Key& key : keys) {
+                if (!visit(key)) {
+                    return;
+                }
+            }
+        }
+    }
+
+    size_t size() const { return count; }
+
+    void clear() {
+        blocks.clear();
+        lastKeys.clear();
+        fenwick.clear();
+        count = 0;
+    }
+};
+
+#endif // BLOCKED_ORDERED_LIST_H
@@ -0,0 +1,103 @@
+#ifndef CHUNK_DIRECTORY_H
+#define CHUNK_DIRECTORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * ChunkDirectory - Lazily allocated two-level table of fixed-size chunks
+ * Maps an index below CAPACITY to a slot in a chunk of CHUNK_SIZE slots.
+ * Chunks are reached through pages of chunk pointers, and both pages and
+ * chunks are only allocated when an index inside them is first used, so the
+ * whole index range is covered up front for a few KiB (the page directory)
+ * and tables grow without ever moving a slot. Reading is two acquire loads
+ * and never blocks.
+ *
+ * Thread safety: chunk() may run concurrently with anything; allocate()
+ * calls must be serialized by the owner.
+ * @tparam T Slot type (value-initialized when its chunk is allocated)
+ * @tparam CHUNK_BITS log2 of the slots per chunk
+ * @tparam INDEX_BITS log2 of the number of addressable indices
+ */
+template <typename T, size_t CHUNK_BITS, size_t INDEX_BITS>
+class ChunkDirectory {
+public:
+    static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static constexpr size_t CAPACITY = size_t(1) << INDEX_BITS; // Valid indices are 0 .. CAPACITY - 1
+
+private:
+    static_assert(INDEX_BITS > CHUNK_BITS, "a directory holds more than one chunk");
+    static constexpr size_t PAGE_BITS = (INDEX_BITS - CHUNK_BITS) / 2;
+    static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS; // Chunk pointers per page
+    static constexpr size_t PAGE_COUNT = CAPACITY >> (CHUNK_BITS + PAGE_BITS);
+
+    using ChunkPointer = std::atomic<T*>;
+
+    std::unique_ptr<std::atomic<ChunkPointer*>[]> pages;
+
+public:
+    ChunkDirectory() : pages(new std::atomic<ChunkPointer*>[PAGE_COUNT]) {
+        for (size_t i = 0; i < PAGE_COUNT; ++i) {
+            pages[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~ChunkDirectory() {
+        for (size_t i = 0; i < PAGE_COUNT; ++i) {
+            ChunkPointer* page = pages[i].load(std::memory_order_relaxed);
+            if (!page) {
+                continue;
+            }
+            for (size_t c = 0; c < PAGE_SIZE; ++c) {
+                delete[] page[c].load(std::memory_order_relaxed);
+            }
+            delete[] page;
+        }
+    }
+
+    ChunkDirectory(const ChunkDirectory&) = delete;
+    ChunkDirectory& operator=(const ChunkDirectory&) = delete;
+
+    /**
+     * Position of an index within its chunk
+     */
+    static size_t offset(size_t index) { return index & (CHUNK_SIZE - 1); }
+
+    /**
+     * Chunk holding an index, without allocating (lock-free)
+     * @param index Index below CAPACITY
+     * @return First slot of the chunk, or nullptr if not allocated yet
+     */
+    T* chunk(size_t index) const {
+        const ChunkPointer* page = pages[index >> (CHUNK_BITS + PAGE_BITS)].load(std::memory_order_acquire);
+        return page ? page[(index >> CHUNK_BITS) & (PAGE_SIZE - 1)].load(std::memory_order_acquire) : nullptr;
+    }
+
+    /**
+     * Chunk holding an index, allocating its page and chunk if needed
+     * Callers serialize allocate() among themselves
+     * @param index Index below CAPACITY
+     * @return First slot of the chunk
+     */
+    T* allocate(size_t index) {
+        std::atomic<ChunkPointer*>& pageSlot = pages[index >> (CHUNK_BITS + PAGE_BITS)];
+        ChunkPointer* page = pageSlot.load(std::memory_order_relaxed);
+        if (!page) {
+            page = new ChunkPointer[PAGE_SIZE];
+            for (size_t c = 0; c < PAGE_SIZE; ++c) {
+                page[c].store(nullptr, std::memory_order_relaxed);
+            }
+            pageSlot.store(page, std::memory_order_release);
+        }
+        ChunkPointer& chunkSlot = page[(index >> CHUNK_BITS) & (PAGE_SIZE - 1)];
+        T* cells = chunkSlot.load(std::memory_order_relaxed);
+        if (!cells) {
+            cells = new T[CHUNK_SIZE]();
+            chunkSlot.store(cells, std::memory_order_release);
+        }
+        return cells;
+    }
+};
+
+#endif // CHUNK_DIRECTORY_H
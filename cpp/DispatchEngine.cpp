@@ -0,0 +1,253 @@
+#include "DispatchEngine.h"
+#include "Logger.h"
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+std::vector<int> solveAssignment(size_t rows, size_t columns,
+                                 const std::vector<CandidateEdge>& edges, double unassignedCost) {
+    // Adjacency in CSR form; column (columns + r) is row r's private "unassigned" option
+    const size_t total = columns + rows;
+    std::vector<size_t> first(rows + 1, 0);
+    for (const CandidateEdge& edge : edges) {
+        first[edge.row + 1]++;
+    }
+    for (size_t r = 0; r < rows; ++r) {
+        first[r + 1] += first[r] + 1;
+    }
+    std::vector<std::pair<size_t, double>> adjacent(first[rows]);
+    std::vector<size_t> fill(first.begin(), first.end() - 1);
+    for (const CandidateEdge& edge : edges) {
+        adjacent[fill[edge.row]++] = {edge.column, edge.cost};
+    }
+    for (size_t r = 0; r < rows; ++r) {
+        adjacent[fill[r]++] = {columns + r, unassignedCost};
+    }
+
+    // Dual potentials keep every reduced cost non-negative so Dijkstra applies
+    const double INF = std::numeric_limits<double>::infinity();
+    std::vector<double> rowPotential(rows, 0.0);
+    std::vector<double> columnPotential(total, 0.0);
+    std::vector<int> rowMatch(rows, -1);
+    std::vector<int> columnMatch(total, -1);
+    std::vector<double> dist(total, INF);
+    std::vector<int> pred(total, -1);
+    std::vector<char> done(total, 0);
+    std::vector<size_t> touched;
+    std::vector<size_t> finalized;
+    std::vector<std::pair<size_t, double>> visitedRows;
+    using QueueEntry = std::pair<double, size_t>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+
+    auto relax = [&](size_t row, double base) {
+        for (size_t e = first[row]; e < first[row + 1]; ++e) {
+            size_t column = adjacent[e].first;
+            if (done[column]) {
+                continue;
+            }
+            double candidate = base + adjacent[e].second + rowPotential[row] - columnPotential[column];
+            if (candidate < dist[column]) {
+                if (dist[column] == INF) {
+                    touched.push_back(column);
+                }
+                dist[column] = candidate;
+                pred[column] = static_cast<int>(row);
+                queue.push({candidate, column});
+            }
+        }
+    };
+
+    for (size_t root = 0; root < rows; ++root) {
+        // Shortest augmenting path from the root to any free column
+        visitedRows.push_back({root, 0.0});
+        relax(root, 0.0);
+        size_t sink = total;
+        double sinkDist = 0.0;
+        while (!queue.empty()) {
+            QueueEntry top = queue.top();
+            queue.pop();
+            size_t column = top.second;
+            if (done[column] || top.first > dist[column]) {
+                continue;
+            }
+            done[column] = 1;
+            finalized.push_back(column);
+            if (columnMatch[column] < 0) {
+                sink = column;
+                sinkDist = top.first;
+                break;
+            }
+            size_t row = static_cast<size_t>(columnMatch[column]);
+            visitedRows.push_back({row, top.first});
+            relax(row, top.first);
+        }
+
+        // The root's own unassigned column is always free, so a sink exists
+        for (size_t column : finalized) {
+            columnPotential[column] += dist[column] - sinkDist;
+        }
+        for (const auto& visited : visitedRows) {
+            rowPotential[visited.first] += visited.second - sinkDist;
+        }
+
+        // Flip the path: every row on it takes the column it was reached through
+        size_t column = sink;
+        while (true) {
+            size_t row = static_cast<size_t>(pred[column]);
+            int previous = rowMatch[row];
+            rowMatch[row] = static_cast<int>(column);
+            columnMatch[column] = static_cast<int>(row);
+            if (row == root) {
+                break;
+            }
+            column = static_cast<size_t>(previous);
+        }
+
+        for (size_t c : touched) {
+            dist[c] = INF;
+            pred[c] = -1;
+            done[c] = 0;
+        }
+        touched.clear();
+        finalized.clear();
+        visitedRows.clear();
+        queue = decltype(queue)();
+    }
+
+    for (int& match : rowMatch) {
+        if (match >= static_cast<int>(columns)) {
+            match = -1;
+        }
+    }
+    return rowMatch;
+}
+
+DispatchEngine::DispatchEngine(RideSharingSystem& rideSystem, std::chrono::milliseconds batchWindow,
+                               size_t candidates, double maxPickup)
+    : system(rideSystem), window(batchWindow),
+      candidatesPerRequest(std::max<size_t>(1, candidates)), maxPickupMiles(maxPickup) {}
+
+bool DispatchEngine::submit(const DispatchRequest& request) {
+    RideType type;
+    if (!RideSharingSystem::parseRideType(request.rideType, type)) {
+        LOG_ERROR("Unknown ride type: " << request.rideType);
+        return false;
+    }
+    if (!request.rider) {
+        LOG_ERROR("Ride request is missing a rider");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back({request, type, std::chrono::steady_clock::now()});
+    return true;
+}
+
+std::vector<std::shared_ptr<Ride>> DispatchEngine::poll() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.empty() ||
+            std::chrono::steady_clock::now() - pending.front().submitted < window) {
+            return {};
+        }
+    }
+    return dispatch();
+}
+
+std::vector<std::shared_ptr<Ride>> DispatchEngine::dispatch() {
+    std::vector<Pending> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch.swap(pending);
+    }
+    std::vector<std::shared_ptr<Ride>> created;
+    if (batch.empty()) {
+        return created;
+    }
+
+    // Sparse candidate graph: each request only sees its k nearest available drivers
+    std::vector<CandidateEdge> edges;
+    std::vector<Driver*> columns;
+    std::unordered_map<Driver*, uint32_t> columnOf;
+    edges.reserve(batch.size() * candidatesPerRequest);
+    for (size_t row = 0; row < batch.size(); ++row) {
+        GeoPoint pickupPoint = batch[row].request.pickupPoint;
+        for (Driver* driver : system.findNearestDrivers(pickupPoint, candidatesPerRequest)) {
+            GeoPoint location;
+            if (!driver->getLocation(location)) {
+                continue;
+            }
+            double miles = distanceBetween(pickupPoint, location);
+            if (miles > maxPickupMiles) {
+                break; // Candidates come closest first
+            }
+            auto inserted = columnOf.emplace(driver, static_cast<uint32_t>(columns.size()));
+            if (inserted.second) {
+                columns.push_back(driver);
+            }
+            edges.push_back({static_cast<uint32_t>(row), inserted.first->second, miles});
+        }
+    }
+
+    // Leaving a request unmatched costs more than any augmenting path can add,
+    // so the solver matches as many requests as possible before minimizing distance
+    double unassignedCost = maxPickupMiles * static_cast<double>(batch.size() + 1);
+    auto solveStart = std::chrono::steady_clock::now();
+    std::vector<int> assignment = solveAssignment(batch.size(), columns.size(), edges, unassignedCost);
+    auto solveEnd = std::chrono::steady_clock::now();
+
+    std::vector<double> pickupCost(batch.size(), 0.0);
+    for (const CandidateEdge& edge : edges) {
+        if (assignment[edge.row] == static_cast<int>(edge.column)) {
+            pickupCost[edge.row] = edge.cost;
+        }
+    }
+
+    DispatchStats stats;
+    stats.requests = batch.size();
+    stats.solveMicros = std::chrono::duration<double, std::micro>(solveEnd - solveStart).count();
+    std::vector<Pending> retry;
+    for (size_t row = 0; row < batch.size(); ++row) {
+        const DispatchRequest& request = batch[row].request;
+        Driver* driver = (assignment[row] >= 0) ? columns[static_cast<size_t>(assignment[row])] : nullptr;
+        // Another dispatcher may have taken the driver since the candidates were read
+        if (!driver || !system.claimDriver(driver->getDriverID())) {
+            retry.push_back(std::move(batch[row]));
+            continue;
+        }
+        auto ride = system.createRide(batch[row].type, request.pickup, request.pickupPoint,
+                                      request.dropoff, request.distance, driver, request.rider);
+        if (!ride) {
+            system.setDriverAvailable(driver->getDriverID(), true); // The request was refused, not the driver
+            continue;
+        }
+        stats.matched++;
+        stats.pickupMiles += pickupCost[row];
+        created.push_back(std::move(ride));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Unmatched requests keep their place ahead of anything submitted meanwhile
+        pending.insert(pending.begin(), std::make_move_iterator(retry.begin()),
+                       std::make_move_iterator(retry.end()));
+        lastStats = stats;
+    }
+
+    LOG_INFO("Dispatched batch: " << stats.matched << " of " << stats.requests << " requests matched ("
+             << std::fixed << std::setprecision(2) << stats.pickupMiles << " pickup miles)");
+    return created;
+}
+
+size_t DispatchEngine::pendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+}
+
+DispatchStats DispatchEngine::lastBatch() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastStats;
+}
@@ -0,0 +1,118 @@
+#ifndef DISPATCH_ENGINE_H
+#define DISPATCH_ENGINE_H
+
+#include "RideSharingSystem.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * A ride request waiting for the next dispatch batch
+ */
+struct DispatchRequest {
+    Rider* rider;
+    std::string pickup;
+    GeoPoint pickupPoint;
+    std::string dropoff;
+    double distance;
+    std::string rideType = "standard";
+};
+
+/**
+ * Summary of the most recent dispatch batch
+ */
+struct DispatchStats {
+    size_t requests = 0;      // Requests in the batch
+    size_t matched = 0;       // Requests that received a driver
+    double pickupMiles = 0.0; // Total driver-to-pickup distance of the matches
+    double solveMicros = 0.0; // Time spent in the assignment solver
+};
+
+/**
+ * One allowed (request, driver) pairing and its cost
+ */
+struct CandidateEdge {
+    uint32_t row;    // Request index
+    uint32_t column; // Driver index
+    double cost;
+};
+
+/**
+ * Minimum-cost assignment on a sparse bipartite graph
+ * Successive shortest augmenting paths (Dijkstra with dual potentials, the
+ * sparse form of the Hungarian method). Every row may also stay unassigned
+ * at unassignedCost, so the solver first maximizes the number of matches
+ * (when unassignedCost exceeds any path cost) and then minimizes total cost.
+ * @param rows Number of rows (requests)
+ * @param columns Number of columns (drivers)
+ * @param edges Allowed pairings with non-negative costs
+ * @param unassignedCost Cost of leaving a row unmatched
+ * @return Column assigned to each row, or -1 if unmatched
+ */
+std::vector<int> solveAssignment(size_t rows, size_t columns,
+                                 const std::vector<CandidateEdge>& edges, double unassignedCost);
+
+/**
+ * DispatchEngine - Batched global matching on top of RideSharingSystem
+ * Requests are collected for a short window and then assigned together so
+ * the total pickup distance of the batch is minimized, instead of each
+ * request greedily taking whichever driver is nearest when it arrives.
+ * Each request only considers its k nearest available drivers, which keeps
+ * the assignment graph sparse. Matches are committed through createRide.
+ */
+class DispatchEngine {
+private:
+    struct Pending {
+        DispatchRequest request;
+        RideType type; // Parsed once at submit
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    RideSharingSystem& system;
+    std::chrono::milliseconds window;
+    size_t candidatesPerRequest;
+    double maxPickupMiles;
+    std::vector<Pending> pending;
+    DispatchStats lastStats;
+    mutable std::mutex mutex; // Guards pending and lastStats
+
+public:
+    /**
+     * @param rideSystem System that owns the drivers and receives the rides
+     * @param batchWindow How long the oldest request may wait before dispatch
+     * @param candidates Nearest drivers considered per request
+     * @param maxPickup Drivers farther than this (miles) are never matched
+     */
+    explicit DispatchEngine(RideSharingSystem& rideSystem,
+                            std::chrono::milliseconds batchWindow = std::chrono::milliseconds(2000),
+                            size_t candidates = 8,
+                            double maxPickup = 10.0);
+
+    /**
+     * Queue a request for the next batch
+     * @param request Ride request
+     * @return False if the request is invalid (unknown ride type or no rider)
+     */
+    bool submit(const DispatchRequest& request);
+
+    /**
+     * Dispatch the pending batch if its oldest request has waited a full window
+     * @return Rides created (empty if the window has not elapsed)
+     */
+    std::vector<std::shared_ptr<Ride>> poll();
+
+    /**
+     * Solve and commit every pending request now
+     * Requests that get no driver stay queued for the next batch
+     * @return Rides created, in submission order
+     */
+    std::vector<std::shared_ptr<Ride>> dispatch();
+
+    size_t pendingCount() const;
+    DispatchStats lastBatch() const;
+};
+
+#endif // DISPATCH_ENGINE_H
@@ -1,52 +1,224 @@
 #include "Driver.h"
+#include "Logger.h"
+#include "FareKernel.h"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
-Driver::Driver(int id, const std::string& driverName, double initialRating)
-    : driverID(id), name(driverName), rating(initialRating) {
-    std::cout << "[LOG] Created driver: " << name << " (ID: " << driverID << ")" << std::endl;
+Driver::Driver(int id, const std::string& driverName, double initialRating, const RideTable* rides)
+    : driverID(id), name(driverName), rating(initialRating), rideTable(rides),
+      leaderboard(nullptr), hasLocation(false), available(true) {
+    LOG_INFO("Created driver: " << name << " (ID: " << driverID << ")");
 }
 
-void Driver::addRide(std::shared_ptr<Ride> ride) {
-    if (ride) {
-        assignedRides.push_back(ride);
-        std::cout << "[LOG] Driver " << name << " assigned to ride ID: " << ride->getRideID() << std::endl;
+void Driver::addRide(const Ride& ride, double fare) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assignedRides.push_back(ride.getRideID());
+        totals.add(ride.getType(), fare);
+        publishLocked();
+    }
+    LOG_INFO("Driver " << name << " assigned to ride ID: " << ride.getRideID());
+}
+
+bool Driver::removeRide(const Ride& ride) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find(assignedRides.begin(), assignedRides.end(), ride.getRideID());
+    if (it == assignedRides.end()) {
+        return false;
+    }
+    totals.remove(ride.getType(), ride.computeFare());
+    assignedRides.erase(it);
+    publishLocked();
+    return true;
+}
+
+void Driver::updateRideFare(RideType type, double oldFare, double newFare) {
+    std::lock_guard<std::mutex> lock(mutex);
+    totals.reprice(type, oldFare, newFare);
+    publishLocked();
+}
+
+void Driver::recomputeTotals() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!rideTable) {
+        return;
+    }
+    // The system releases a ride only after removing it here, so every listed ID
+    // should resolve; one that does not is left out of the totals rather than read
+    std::vector<const Ride*> rides;
+    std::vector<double> distances;
+    std::vector<RideType> types;
+    rides.reserve(assignedRides.size());
+    distances.reserve(assignedRides.size());
+    types.reserve(assignedRides.size());
+    for (int rideID : assignedRides) {
+        const Ride* ride = rideTable->find(rideID);
+        if (!ride) {
+            LOG_ERROR("Driver " << driverID << " lists unknown ride ID " << rideID);
+            continue;
+        }
+        rides.push_back(ride);
+        distances.push_back(ride->getDistance());
+        types.push_back(ride->getType());
+    }
+    std::vector<double> fares(distances.size());
+    FareKernel::computeFares(distances.data(), types.data(), fares.data(), fares.size());
+    
+    totals = RideTotals();
+    for (size_t i = 0; i < fares.size(); ++i) {
+        // Extension rides have no static policy and are priced virtually
+        double fare = (types[i] == RideType::Custom) ? rides[i]->computeFare()
+                                                     : fares[i] * rides[i]->getSurgeMultiplier();
+        totals.add(types[i], fare);
+    }
+    publishLocked();
+}
+
+void Driver::restoreRides(std::vector<int> rideIDs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assignedRides = std::move(rideIDs);
+    }
+    recomputeTotals();
+}
+
+std::vector<int> Driver::getRideIDs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return assignedRides;
+}
+
+void Driver::reserveRides(size_t additional) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t needed = assignedRides.size() + additional;
+    if (needed > assignedRides.capacity()) {
+        // Keep geometric growth so repeated small batches stay amortized O(1)
+        assignedRides.reserve(std::max(needed, assignedRides.capacity() * 2));
     }
 }
 
 void Driver::getDriverInfo() const {
-    std::cout << "\n=== Driver Information ===" << std::endl;
-    std::cout << "Driver ID: " << driverID << std::endl;
-    std::cout << "Name: " << name << std::endl;
-    std::cout << "Rating: " << std::fixed << std::setprecision(1) << rating << "/5.0" << std::endl;
-    std::cout << "Total Rides: " << assignedRides.size() << std::endl;
-    std::cout << "Total Earnings: $" << std::fixed << std::setprecision(2) << getTotalEarnings() << std::endl;
+    Logger::instance().flush(); // Keep queued log records ahead of the report
+    ReportWriter out(std::cout);
+    writeInfo(out);
+}
+
+ReportCursor Driver::writeInfo(ReportWriter& out, const ReportPage& page) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    ReportBuffer& text = out.buffer();
+    text << "\n=== Driver Information ===\n";
+    text << "Driver ID: " << driverID << '\n';
+    text << "Name: " << name << '\n';
+    text << "Rating: " << fixed(rating, 1) << "/5.0\n";
+    text << "Total Rides: " << assignedRides.size() << '\n';
+    text << "Total Earnings: $" << fixed(totals.total(), 2) << '\n';
+    if (hasLocation) {
+        text << "Location: (" << fixed(location.x, 2) << ", " << fixed(location.y, 2) << ")"
+             << (available ? " - available" : " - on a ride") << '\n';
+    }
     
     if (!assignedRides.empty()) {
-        std::cout << "\n--- Assigned Rides ---" << std::endl;
-        for (const auto& ride : assignedRides) {
-            std::cout << "Ride " << ride->getRideID() << ": " 
-                     << ride->getPickupLocation() << " → " << ride->getDropoffLocation()
-                     << " ($" << std::fixed << std::setprecision(2) << ride->fare() << ")" << std::endl;
+        text << "\n--- Assigned Rides ---\n";
+    }
+    return writeRideLines(out, page);
+}
+
+ReportCursor Driver::writeRides(ReportWriter& out, const ReportPage& page) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return writeRideLines(out, page);
+}
+
+ReportCursor Driver::writeRideLines(ReportWriter& out, const ReportPage& page) const {
+    ReportBuffer& text = out.buffer();
+    ReportRange range(assignedRides, page);
+    for (size_t i = range.first; i < range.last; ++i) {
+        int rideID = assignedRides[i];
+        const Ride* ride = rideTable ? rideTable->find(rideID) : nullptr;
+        if (!ride) {
+            text << "Ride " << rideID << '\n';
+        } else {
+            text << "Ride " << rideID << ": " << ride->getPickupLocation() << " → " << ride->getDropoffLocation()
+                 << " ($" << fixed(ride->computeFare(), 2) << ")\n";
         }
+        out.endRecord();
     }
+    return range.cursor(assignedRides, page.limit);
 }
 
 double Driver::getTotalEarnings() const {
-    double total = 0.0;
-    for (const auto& ride : assignedRides) {
-        total += ride->fare();
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals.total();
+}
+
+double Driver::getRating() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rating;
+}
+
+size_t Driver::getRideCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return assignedRides.size();
+}
+
+RideTotals Driver::getTotals() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals;
+}
+
+void Driver::setLocation(GeoPoint point) {
+    std::lock_guard<std::mutex> lock(mutex);
+    location = point;
+    hasLocation = true;
+}
+
+void Driver::setAvailable(bool isAvailable) {
+    std::lock_guard<std::mutex> lock(mutex);
+    available = isAvailable;
+}
+
+bool Driver::getLocation(GeoPoint& point) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    point = location;
+    return hasLocation;
+}
+
+bool Driver::isAvailable() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return available;
+}
+
+void Driver::setRating(double value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    rating = value;
+    publishLocked();
+}
+
+void Driver::setLeaderboard(Leaderboard* board) {
+    std::lock_guard<std::mutex> lock(mutex);
+    leaderboard = board;
+    publishLocked();
+}
+
+void Driver::publishLocked() const {
+    if (leaderboard) {
+        leaderboard->update(driverID, totals.total(), assignedRides.size(), rating);
     }
-    return total;
 }
 
-void Driver::updateRating(double newRating) {
+bool Driver::updateRating(double newRating) {
     if (newRating >= 1.0 && newRating <= 5.0) {
-        // Simple average of current and new rating
-        rating = (rating + newRating) / 2.0;
-        std::cout << "[LOG] Driver " << name << " rating updated to " 
-                 << std::fixed << std::setprecision(1) << rating << std::endl;
-    } else {
-        std::cout << "[ERROR] Invalid rating. Must be between 1.0 and 5.0" << std::endl;
+        double updated;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // Simple average of current and new rating
+            rating = (rating + newRating) / 2.0;
+            updated = rating;
+            publishLocked();
+        }
+        LOG_INFO("Driver " << name << " rating updated to " 
+                 << std::fixed << std::setprecision(1) << updated);
+        return true;
     }
+    LOG_ERROR("Invalid rating. Must be between 1.0 and 5.0");
+    return false;
 }
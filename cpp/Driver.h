@@ -2,9 +2,14 @@
 #define DRIVER_H
 
 #include "Ride.h"
+#include "RideTable.h"
+#include "Leaderboard.h"
+#include "RideTotals.h"
+#include "GeoPoint.h"
 #include <vector>
 #include <memory>
 #include <string>
+#include <mutex>
 
 /**
  * Driver class representing a driver in the ride sharing system
@@ -15,8 +20,30 @@ private:
     int driverID;
     std::string name;
     double rating;
-    // Using smart pointers for automatic memory management
-    std::vector<std::shared_ptr<Ride>> assignedRides; // Encapsulated - private access only
+    // Rides are owned by the system's RideTable; the driver keeps 4-byte ride IDs
+    std::vector<int> assignedRides; // Encapsulated - private access only
+    const RideTable* rideTable;     // Resolves assignedRides, nullptr for a standalone driver
+    Leaderboard* leaderboard;       // Receives every change to earnings, ride count or rating
+    RideTotals totals; // Maintained incrementally as rides are added or changed
+    GeoPoint location;
+    bool hasLocation;  // False until the driver reports a position
+    bool available;    // Open for automatic matching
+    mutable std::mutex mutex; // Guards rating, location, assignedRides and totals across dispatcher threads
+    
+    // Position and availability change through the system so its spatial index stays in sync
+    friend class RideSharingSystem;
+    void setLocation(GeoPoint point);
+    void setAvailable(bool isAvailable);
+    // Attach the system leaderboard and publish the current figures to it
+    void setLeaderboard(Leaderboard* board);
+    // Ride lines of a page of assignedRides (caller holds mutex)
+    ReportCursor writeRideLines(ReportWriter& out, const ReportPage& page) const;
+    // Push earnings, ride count and rating to the leaderboard (caller holds mutex)
+    void publishLocked() const;
+    // Snapshot and journal replay support: restore state wholesale and list rides by ID
+    void setRating(double value);
+    void restoreRides(std::vector<int> rideIDs);
+    std::vector<int> getRideIDs() const;
     
 public:
     /**
@@ -24,23 +51,48 @@ public:
      * @param id Unique driver identifier
      * @param driverName Name of the driver
      * @param initialRating Initial rating (default 5.0)
+     * @param rides Table owning the driver's rides (needed to list or re-price them)
      */
-    Driver(int id, const std::string& driverName, double initialRating = 5.0);
+    Driver(int id, const std::string& driverName, double initialRating = 5.0, const RideTable* rides = nullptr);
     
     /**
      * Add a ride to the driver's assigned rides list
-     * Demonstrates controlled access to private data
-     * @param ride Shared pointer to the ride object
+     * Only the ride ID is kept; the ride itself stays in the ride table
+     * @param ride Ride to assign
+     */
+    void addRide(const Ride& ride) { addRide(ride, ride.computeFare()); }
+    
+    /**
+     * Add a ride at the fare it was logged with
+     * @param ride Ride to assign
+     * @param fare Fare recorded for the ride in the ride log
      */
-    void addRide(std::shared_ptr<Ride> ride);
+    void addRide(const Ride& ride, double fare);
     
     /**
      * Display driver information including all assigned rides
+     * Without a ride table only the ride IDs are listed
      */
     void getDriverInfo() const;
     
     /**
-     * Calculate total earnings from all assigned rides
+     * Write driver information and a page of assigned rides
+     * @param out Report destination
+     * @param page Rides to list (default: all)
+     * @return Cursor for the following page
+     */
+    ReportCursor writeInfo(ReportWriter& out, const ReportPage& page = ReportPage()) const;
+    
+    /**
+     * Write only the ride lines of a page of assigned rides
+     * @param out Report destination
+     * @param page Rides to list
+     * @return Cursor for the following page
+     */
+    ReportCursor writeRides(ReportWriter& out, const ReportPage& page) const;
+    
+    /**
+     * Total earnings from all assigned rides (O(1), kept up to date incrementally)
      * @return Total earnings
      */
     double getTotalEarnings() const;
@@ -48,14 +100,56 @@ public:
     /**
      * Update driver rating based on ride feedback
      * @param newRating New rating value (1.0 - 5.0)
+     * @return True if the rating was in range and applied
+     */
+    bool updateRating(double newRating);
+    
+    /**
+     * Pre-allocate room for additional rides (used by batch creation)
+     * @param additional Number of rides about to be added
+     */
+    void reserveRides(size_t additional);
+    
+    /**
+     * Remove a cancelled ride and subtract it from the running totals
+     * @param ride Ride to remove (still priced at its current fare)
+     * @return True if the ride was assigned to this driver
+     */
+    bool removeRide(const Ride& ride);
+    
+    /**
+     * Adjust running totals after a ride's fare changed
+     * @param type Ride type
+     * @param oldFare Fare before re-pricing
+     * @param newFare Fare after re-pricing
+     */
+    void updateRideFare(RideType type, double oldFare, double newFare);
+    
+    /**
+     * Rebuild the running totals from the ride list using the batch fare kernel
+     * Used to audit or refresh totals after fare policy changes
+     * Needs the ride table; a standalone driver keeps its totals as they are
      */
-    void updateRating(double newRating);
+    void recomputeTotals();
     
     // Getter methods for controlled access
     int getDriverID() const { return driverID; }
     std::string getName() const { return name; }
-    double getRating() const { return rating; }
-    size_t getRideCount() const { return assignedRides.size(); }
+    double getRating() const;
+    size_t getRideCount() const;
+    RideTotals getTotals() const; // Consistent snapshot of the running totals
+    
+    /**
+     * Last reported position
+     * @param point Receives the position if known
+     * @return True if the driver has reported a position
+     */
+    bool getLocation(GeoPoint& point) const;
+    
+    /**
+     * Whether the driver can be matched to new ride requests
+     */
+    bool isAvailable() const;
 };
 
 #endif // DRIVER_H
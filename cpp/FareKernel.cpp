@@ -0,0 +1,159 @@
+#include "FareKernel.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FARE_KERNEL_X86 1
+#endif
+
+namespace {
+
+// Fare policies laid out per column for the vector kernels, indexed by RideType.
+// The Custom row is zero and masked out, so Custom rows come out as +0.0 like rideFare().
+// Columns hold at least four entries so that one AVX2 register can carry a whole column.
+constexpr size_t COLUMN_SLOTS = RIDE_TYPE_COUNT > 4 ? RIDE_TYPE_COUNT : 4;
+
+struct PolicyColumns {
+    alignas(32) double rates[COLUMN_SLOTS] = {};
+    alignas(32) double multipliers[COLUMN_SLOTS] = {};
+    alignas(32) double minimums[COLUMN_SLOTS] = {};
+    alignas(32) int64_t masks[COLUMN_SLOTS] = {};
+};
+
+constexpr PolicyColumns buildColumns() {
+    PolicyColumns columns;
+    for (size_t i = 0; i < BUILTIN_RIDE_TYPE_COUNT; ++i) {
+        columns.rates[i] = RIDE_TYPES[i].policy.rate;
+        columns.multipliers[i] = RIDE_TYPES[i].policy.multiplier;
+        columns.minimums[i] = RIDE_TYPES[i].policy.minimumFare;
+        columns.masks[i] = -1;
+    }
+    return columns;
+}
+
+constexpr PolicyColumns COLUMNS = buildColumns();
+
+void computeScalar(const double* distances, const RideType* types, double* fares, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        fares[i] = rideFare(types[i], distances[i]);
+    }
+}
+
+#ifdef FARE_KERNEL_X86
+
+#ifdef __SSE2__
+void computeSse2(const double* distances, const RideType* types, double* fares, size_t count) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        size_t t0 = static_cast<size_t>(types[i]);
+        size_t t1 = static_cast<size_t>(types[i + 1]);
+        __m128d rate = _mm_set_pd(COLUMNS.rates[t1], COLUMNS.rates[t0]);
+        __m128d multiplier = _mm_set_pd(COLUMNS.multipliers[t1], COLUMNS.multipliers[t0]);
+        __m128d minimum = _mm_set_pd(COLUMNS.minimums[t1], COLUMNS.minimums[t0]);
+        __m128d mask = _mm_castsi128_pd(_mm_set_epi64x(COLUMNS.masks[t1], COLUMNS.masks[t0]));
+        __m128d fare = _mm_mul_pd(_mm_mul_pd(rate, _mm_loadu_pd(distances + i)), multiplier);
+        // max(minimum, fare) returns fare unless minimum > fare, like FarePolicy (NaN included)
+        _mm_storeu_pd(fares + i, _mm_and_pd(_mm_max_pd(minimum, fare), mask));
+    }
+    computeScalar(distances + i, types + i, fares + i, count - i);
+}
+#endif
+
+// Column entries for four rides. While there are at most four type tags a
+// column is one register and a lane permute replaces the (much slower) gather.
+__attribute__((target("avx2")))
+inline __m256d lookupAvx2(const double* column, __m128i index, __m256i lanes) {
+    if constexpr (RIDE_TYPE_COUNT <= 4) {
+        __m256 table = _mm256_castpd_ps(_mm256_load_pd(column));
+        return _mm256_castps_pd(_mm256_permutevar8x32_ps(table, lanes));
+    } else {
+        return _mm256_i32gather_pd(column, index, 8);
+    }
+}
+
+__attribute__((target("avx2")))
+void computeAvx2(const double* distances, const RideType* types, double* fares, size_t count) {
+    const __m256i one = _mm256_set1_epi64x(1);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32_t packed;
+        std::memcpy(&packed, types + i, sizeof(packed));
+        __m128i bytes = _mm_cvtsi32_si128(packed);
+        __m128i index = _mm_cvtepu8_epi32(bytes);
+        // 32-bit lane pair (2t, 2t + 1) selects double t of a column register
+        __m256i twice = _mm256_slli_epi64(_mm256_cvtepu8_epi64(bytes), 1);
+        __m256i lanes = _mm256_or_si256(twice, _mm256_slli_epi64(_mm256_add_epi64(twice, one), 32));
+        __m256d rate = lookupAvx2(COLUMNS.rates, index, lanes);
+        __m256d multiplier = lookupAvx2(COLUMNS.multipliers, index, lanes);
+        __m256d minimum = lookupAvx2(COLUMNS.minimums, index, lanes);
+        __m256d mask = lookupAvx2(reinterpret_cast<const double*>(COLUMNS.masks), index, lanes);
+        __m256d fare = _mm256_mul_pd(_mm256_mul_pd(rate, _mm256_loadu_pd(distances + i)), multiplier);
+        _mm256_storeu_pd(fares + i, _mm256_and_pd(_mm256_max_pd(minimum, fare), mask));
+    }
+    computeScalar(distances + i, types + i, fares + i, count - i);
+}
+
+#endif // FARE_KERNEL_X86
+
+using KernelFn = void (*)(const double*, const RideType*, double*, size_t);
+
+struct Selection {
+    KernelFn kernel;
+    const char* name;
+};
+
+Selection select() {
+#ifdef FARE_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {computeAvx2, "avx2"};
+    }
+#ifdef __SSE2__
+    return {computeSse2, "sse2"};
+#endif
+#endif
+    return {computeScalar, "scalar"};
+}
+
+const Selection& selected() {
+    static const Selection selection = select();
+    return selection;
+}
+
+} // namespace
+
+namespace FareKernel {
+
+void computeFares(const double* distances, const RideType* types, double* fares, size_t count) {
+    selected().kernel(distances, types, fares, count);
+}
+
+void computeFares(const double* distances, const RideType* types, const uint16_t* surgePercents,
+                  double* fares, size_t count) {
+    selected().kernel(distances, types, fares, count);
+    for (size_t i = 0; i < count; ++i) {
+        fares[i] *= surgePercents[i] / 100.0; // Same operation as Ride::computeFare()
+    }
+}
+
+double sumFares(const double* distances, const RideType* types, size_t count) {
+    constexpr size_t BLOCK = 256;
+    double block[BLOCK];
+    double total = 0.0;
+    KernelFn kernel = selected().kernel;
+    for (size_t start = 0; start < count; start += BLOCK) {
+        size_t n = (count - start < BLOCK) ? count - start : BLOCK;
+        kernel(distances + start, types + start, block, n);
+        for (size_t i = 0; i < n; ++i) {
+            total += block[i];
+        }
+    }
+    return total;
+}
+
+const char* implementation() {
+    return selected().name;
+}
+
+} // namespace FareKernel
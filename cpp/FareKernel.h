@@ -0,0 +1,56 @@
+#ifndef FARE_KERNEL_H
+#define FARE_KERNEL_H
+
+#include "Ride.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Batch pricing for the built-in ride types
+ * Evaluates each type's FarePolicy (rate * distance * multiplier, floored
+ * at the minimum fare) over whole arrays with AVX2 or SSE2 when available
+ * (chosen at runtime) and a scalar loop otherwise. Every vector path
+ * performs the same IEEE operations in the same order as the scalar
+ * fare(), so results match it bit for bit.
+ */
+namespace FareKernel {
+
+/**
+ * Price an array of rides
+ * @param distances Ride distances in miles
+ * @param types Ride type tags (Custom rows get 0.0, like rideFare)
+ * @param fares Output array, may not alias the inputs
+ * @param count Number of rides
+ */
+void computeFares(const double* distances, const RideType* types, double* fares, size_t count);
+
+/**
+ * Price an array of rides and apply each ride's quoted surge multiplier
+ * Matches Ride::computeFare() bit for bit for built-in types
+ * @param distances Ride distances in miles
+ * @param types Ride type tags (Custom rows get 0.0, like rideFare)
+ * @param surgePercents Surge multiplier of each ride in percent (100 = none)
+ * @param fares Output array, may not alias the inputs
+ * @param count Number of rides
+ */
+void computeFares(const double* distances, const RideType* types, const uint16_t* surgePercents,
+                  double* fares, size_t count);
+
+/**
+ * Sum of fares for an array of rides, accumulated in array order so the
+ * result equals summing the scalar fares one by one
+ * @param distances Ride distances in miles
+ * @param types Ride type tags (Custom rows contribute 0.0)
+ * @param count Number of rides
+ * @return Total fare
+ */
+double sumFares(const double* distances, const RideType* types, size_t count);
+
+/**
+ * Name of the implementation selected for this CPU ("avx2", "sse2" or "scalar")
+ */
+const char* implementation();
+
+} // namespace FareKernel
+
+#endif // FARE_KERNEL_H
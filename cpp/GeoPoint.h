@@ -0,0 +1,45 @@
+#ifndef GEO_POINT_H
+#define GEO_POINT_H
+
+#include <cmath>
+
+/**
+ * Position on the service area's planar grid, in miles from its origin
+ */
+struct GeoPoint {
+    double x = 0.0;
+    double y = 0.0;
+};
+
+/**
+ * Whether both coordinates are finite numbers (not NaN or infinite)
+ * @param point Point to check
+ * @return True if the point can be placed on the grid
+ */
+inline bool isFinite(GeoPoint point) {
+    return std::isfinite(point.x) && std::isfinite(point.y);
+}
+
+/**
+ * Squared straight-line distance (cheap comparisons without sqrt)
+ * @param a First point
+ * @param b Second point
+ * @return Squared distance in square miles
+ */
+inline double squaredDistance(GeoPoint a, GeoPoint b) {
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+/**
+ * Straight-line distance between two points
+ * @param a First point
+ * @param b Second point
+ * @return Distance in miles
+ */
+inline double distanceBetween(GeoPoint a, GeoPoint b) {
+    return std::sqrt(squaredDistance(a, b));
+}
+
+#endif // GEO_POINT_H
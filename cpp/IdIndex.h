@@ -0,0 +1,150 @@
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+#include "ChunkDirectory.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <cstddef>
+
+/**
+ * IdIndex - O(1) lookup table from integer IDs to objects
+ * IDs handed out by the system are dense (they only increment), so most
+ * entries live in a direct-mapped slot table indexed by ID. IDs that would
+ * make the table too sparse (negative or far past the end) go to a hash map.
+ *
+ * Thread safety: writers (insert/erase) are serialized internally. Slots live
+ * in fixed-size chunks that never move, so find() on a dense ID is wait-free
+ * and never blocks behind a writer; only sparse IDs take a shared lock. The
+ * chunk directory spans every non-negative int, so dense IDs never spill
+ * into the hash map however many objects are registered.
+ */
+template <typename T>
+class IdIndex {
+private:
+    using Chunk = std::atomic<T*>;
+    using SlotDirectory = ChunkDirectory<Chunk, 12, 31>; // Slots for IDs 0 .. INT_MAX
+    static constexpr size_t CHUNK_SIZE = SlotDirectory::CHUNK_SIZE;
+
+    // Largest gap past the end of the slot table that is still direct-mapped
+    static constexpr size_t MAX_SLOT_GAP = 1024;
+
+    SlotDirectory chunks;
+    std::atomic<size_t> slotLimit{0};             // Slots allocated so far
+    std::unordered_map<int, T*> overflow;          // Fallback for sparse IDs
+    std::atomic<size_t> overflowCount{0};          // Lets find() skip the lock when empty
+    std::atomic<size_t> count{0};
+    mutable std::shared_mutex mutex;               // Writers exclusive, sparse readers shared
+
+    bool isDense(int id) const {
+        size_t limit = slotLimit.load(std::memory_order_relaxed);
+        return id >= 0 && static_cast<size_t>(id) < limit + MAX_SLOT_GAP;
+    }
+
+    // Caller holds the exclusive lock
+    Chunk& slotFor(size_t slot) {
+        Chunk* cells = chunks.allocate(slot);
+        if (slot >= slotLimit.load(std::memory_order_relaxed)) {
+            slotLimit.store((slot / CHUNK_SIZE + 1) * CHUNK_SIZE, std::memory_order_release);
+        }
+        return cells[SlotDirectory::offset(slot)];
+    }
+
+    T* findDense(int id) const {
+        size_t slot = static_cast<size_t>(id);
+        if (slot >= slotLimit.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        const Chunk* cells = chunks.chunk(slot);
+        return cells ? cells[SlotDirectory::offset(slot)].load(std::memory_order_acquire) : nullptr;
+    }
+
+public:
+    IdIndex() = default;
+
+    IdIndex(const IdIndex&) = delete;
+    IdIndex& operator=(const IdIndex&) = delete;
+
+    /**
+     * Register an object under an ID, replacing any previous entry
+     * @param id Object ID
+     * @param value Pointer to the object (must not be nullptr)
+     */
+    void insert(int id, T* value) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (isDense(id)) {
+            Chunk& cell = slotFor(static_cast<size_t>(id));
+            // The ID may have been stored sparsely before the table grew over it
+            if (!overflow.empty() && overflow.erase(id) > 0) {
+                overflowCount.fetch_sub(1, std::memory_order_release);
+                count.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (!cell.load(std::memory_order_relaxed)) {
+                count.fetch_add(1, std::memory_order_relaxed);
+            }
+            cell.store(value, std::memory_order_release);
+        } else if (overflow.insert_or_assign(id, value).second) {
+            overflowCount.fetch_add(1, std::memory_order_release);
+            count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Remove an ID from the index
+     * @param id Object ID
+     * @return True if an entry was removed
+     */
+    bool erase(int id) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (id >= 0 && findDense(id)) {
+            slotFor(static_cast<size_t>(id)).store(nullptr, std::memory_order_release);
+            count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        if (overflow.erase(id) > 0) {
+            overflowCount.fetch_sub(1, std::memory_order_release);
+            count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Look up an object by ID (wait-free unless sparse IDs are registered)
+     * @param id Object ID
+     * @return Pointer to the object or nullptr if not registered
+     */
+    T* find(int id) const {
+        if (id >= 0) {
+            if (T* value = findDense(id)) {
+                return value;
+            }
+        }
+        if (overflowCount.load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = overflow.find(id);
+        return (it != overflow.end()) ? it->second : nullptr;
+    }
+
+    /**
+     * Pre-allocate slot chunks for IDs up to maxID
+     * @param maxID Largest ID expected
+     */
+    void reserve(int maxID) {
+        if (maxID < 0) {
+            return;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        for (size_t slot = 0; slot <= static_cast<size_t>(maxID); slot += CHUNK_SIZE) {
+            slotFor(slot);
+        }
+    }
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+};
+
+#endif // ID_INDEX_H
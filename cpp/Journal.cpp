@@ -0,0 +1,438 @@
+#include "Journal.h"
+#include "Logger.h"
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[8] = {'R', 'S', 'J', 'R', 'N', 'L', 0, 0};
+const uint32_t VERSION = 1;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const size_t HEADER_SIZE = sizeof(MAGIC) + 2 * sizeof(uint32_t);
+
+uint32_t crc32(const char* data, size_t size) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+template <typename T>
+void putRaw(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+void putString(std::string& out, std::string_view text) {
+    putVarint(out, text.size());
+    out += text;
+}
+
+/**
+ * Bounds-checked cursor over one record; any overrun clears ok
+ */
+struct Reader {
+    const char* pos;
+    const char* end;
+    bool ok = true;
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == end) {
+                break;
+            }
+            uint8_t byte = static_cast<uint8_t>(*pos++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    int id() {
+        uint64_t value = varint();
+        if (value > static_cast<uint64_t>(INT32_MAX)) {
+            ok = false;
+        }
+        return static_cast<int>(value);
+    }
+
+    template <typename T>
+    T raw() {
+        T value{};
+        if (static_cast<size_t>(end - pos) < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string_view text() {
+        uint64_t length = varint();
+        if (!ok || length > static_cast<uint64_t>(end - pos)) {
+            ok = false;
+            return std::string_view();
+        }
+        std::string_view value(pos, static_cast<size_t>(length));
+        pos += length;
+        return value;
+    }
+
+    void point(JournalEvent& event) {
+        event.hasPoint = raw<uint8_t>() != 0;
+        if (event.hasPoint) {
+            event.point.x = raw<double>();
+            event.point.y = raw<double>();
+        }
+    }
+};
+
+void putPoint(std::string& out, const JournalEvent& event) {
+    putRaw<uint8_t>(out, event.hasPoint ? 1 : 0);
+    if (event.hasPoint) {
+        putRaw(out, event.point.x);
+        putRaw(out, event.point.y);
+    }
+}
+
+bool decode(const char* data, size_t size, JournalEvent& event) {
+    Reader in{data, data + size};
+    uint8_t type = in.raw<uint8_t>();
+    event = JournalEvent();
+    event.type = static_cast<JournalEventType>(type);
+    event.id = in.id();
+    switch (event.type) {
+        case JournalEventType::AddDriver:
+            event.name = in.text();
+            event.value = in.raw<double>();
+            in.point(event);
+            break;
+        case JournalEventType::AddRider:
+            event.name = in.text();
+            event.paymentMethod = in.text();
+            break;
+        case JournalEventType::CreateRide: {
+            uint8_t rideType = in.raw<uint8_t>();
+            if (rideType >= static_cast<uint8_t>(RideType::Custom)) {
+                return false;
+            }
+            event.rideType = static_cast<RideType>(rideType);
+            event.pickup = in.text();
+            event.dropoff = in.text();
+            event.value = in.raw<double>();
+            event.driverID = in.id();
+            event.riderID = in.id();
+            in.point(event);
+            if (in.pos != in.end) {
+                // Optional trailer, absent from unsurged rides and older records
+                uint64_t surge = in.varint();
+                if (surge == 0 || surge > UINT16_MAX) {
+                    return false;
+                }
+                event.surgePercent = static_cast<uint16_t>(surge);
+            }
+            break;
+        }
+        case JournalEventType::UpdateRating:
+        case JournalEventType::RepriceRide:
+            event.value = in.raw<double>();
+            break;
+        case JournalEventType::CancelRide:
+            break;
+        default:
+            return false;
+    }
+    return in.ok && in.pos == in.end;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseSyncPolicy(const std::string& name, SyncPolicy& policy) {
+    if (name == "always") {
+        policy = SyncPolicy::Always;
+    } else if (name == "group") {
+        policy = SyncPolicy::Group;
+    } else if (name == "periodic") {
+        policy = SyncPolicy::Periodic;
+    } else if (name == "none") {
+        policy = SyncPolicy::None;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void Journal::encode(const JournalEvent& event, std::string& out) {
+    // Frame: varint payload length, payload, CRC32 of the payload
+    thread_local std::string payload;
+    payload.clear();
+    putRaw<uint8_t>(payload, static_cast<uint8_t>(event.type));
+    putVarint(payload, static_cast<uint32_t>(event.id));
+    switch (event.type) {
+        case JournalEventType::AddDriver:
+            putString(payload, event.name);
+            putRaw(payload, event.value);
+            putPoint(payload, event);
+            break;
+        case JournalEventType::AddRider:
+            putString(payload, event.name);
+            putString(payload, event.paymentMethod);
+            break;
+        case JournalEventType::CreateRide:
+            putRaw<uint8_t>(payload, static_cast<uint8_t>(event.rideType));
+            putString(payload, event.pickup);
+            putString(payload, event.dropoff);
+            putRaw(payload, event.value);
+            putVarint(payload, static_cast<uint32_t>(event.driverID));
+            putVarint(payload, static_cast<uint32_t>(event.riderID));
+            putPoint(payload, event);
+            if (event.surgePercent != 100) {
+                putVarint(payload, event.surgePercent);
+            }
+            break;
+        case JournalEventType::UpdateRating:
+        case JournalEventType::RepriceRide:
+            putRaw(payload, event.value);
+            break;
+        case JournalEventType::CancelRide:
+            break;
+    }
+    putVarint(out, payload.size());
+    out += payload;
+    putRaw(out, crc32(payload.data(), payload.size()));
+}
+
+Journal::Journal(int file, const JournalOptions& journalOptions)
+    : fd(file), options(journalOptions) {
+    writer = std::thread(&Journal::writerLoop, this);
+}
+
+Journal::~Journal() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWriter.notify_one();
+    writer.join();
+    ::fsync(fd);
+    ::close(fd);
+}
+
+std::unique_ptr<Journal> Journal::open(const std::string& path, const JournalOptions& journalOptions,
+                                       const std::function<void(const JournalEvent&)>& replay) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Cannot open journal: " << path << " (" << std::strerror(errno) << ")");
+        return nullptr;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        LOG_ERROR("Cannot stat journal: " << path << " (" << std::strerror(errno) << ")");
+        ::close(fd);
+        return nullptr;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        std::string header(MAGIC, sizeof(MAGIC));
+        putRaw(header, VERSION);
+        putRaw(header, BYTE_ORDER_MARK);
+        if (!writeAll(fd, header.data(), header.size()) || ::fsync(fd) != 0) {
+            LOG_ERROR("Cannot initialize journal: " << path << " (" << std::strerror(errno) << ")");
+            ::close(fd);
+            return nullptr;
+        }
+        return std::unique_ptr<Journal>(new Journal(fd, journalOptions));
+    }
+
+    std::string data(size, '\0');
+    size_t done = 0;
+    while (done < size) {
+        ssize_t got = ::pread(fd, &data[done], size - done, static_cast<off_t>(done));
+        if (got <= 0) {
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Cannot read journal: " << path);
+            ::close(fd);
+            return nullptr;
+        }
+        done += static_cast<size_t>(got);
+    }
+
+    Reader header{data.data(), data.data() + size};
+    bool magicOk = size >= HEADER_SIZE && std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) == 0;
+    header.pos += sizeof(MAGIC);
+    if (!magicOk || header.raw<uint32_t>() != VERSION || header.raw<uint32_t>() != BYTE_ORDER_MARK) {
+        LOG_ERROR("Not a journal or from an incompatible version: " << path);
+        ::close(fd);
+        return nullptr;
+    }
+
+    // Replay up to the first record that is incomplete or fails its checksum
+    size_t pos = HEADER_SIZE;
+    JournalEvent event;
+    while (pos < size) {
+        Reader frame{data.data() + pos, data.data() + size};
+        uint64_t length = frame.varint();
+        size_t available = static_cast<size_t>(frame.end - frame.pos);
+        if (!frame.ok || available < sizeof(uint32_t) || length > available - sizeof(uint32_t)) {
+            break;
+        }
+        const char* payload = frame.pos;
+        uint32_t stored;
+        std::memcpy(&stored, payload + length, sizeof(stored));
+        if (stored != crc32(payload, length) || !decode(payload, length, event)) {
+            break;
+        }
+        if (replay) {
+            replay(event);
+        }
+        pos = static_cast<size_t>(payload + length + sizeof(uint32_t) - data.data());
+    }
+    if (pos < size) {
+        LOG_WARN("Journal " << path << " has a damaged tail; discarding " << (size - pos) << " bytes");
+        if (::ftruncate(fd, static_cast<off_t>(pos)) != 0 || ::fsync(fd) != 0) {
+            LOG_ERROR("Cannot truncate journal: " << path << " (" << std::strerror(errno) << ")");
+            ::close(fd);
+            return nullptr;
+        }
+    }
+    return std::unique_ptr<Journal>(new Journal(fd, journalOptions));
+}
+
+uint64_t Journal::append(const JournalEvent& event) {
+    thread_local std::string record;
+    record.clear();
+    encode(event, record);
+    uint64_t sequence;
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (buffer.empty()) {
+            oldestPending = std::chrono::steady_clock::now();
+        }
+        buffer += record;
+        sequence = ++appendedSeq;
+        // Batching policies only need the writer at the start of a batch or when it is full
+        wake = options.sync == SyncPolicy::Always || options.sync == SyncPolicy::None ||
+               buffer.size() == record.size() || buffer.size() >= options.maxBatchBytes;
+    }
+    if (wake) {
+        wakeWriter.notify_one();
+    }
+    return sequence;
+}
+
+bool Journal::commit(uint64_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (options.sync == SyncPolicy::Always || options.sync == SyncPolicy::Group) {
+        committed.wait(lock, [this, sequence] { return durableSeq >= sequence; });
+    }
+    return !failed;
+}
+
+bool Journal::flush() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        flushRequest = appendedSeq;
+        wakeWriter.notify_one();
+        committed.wait(lock, [this] { return durableSeq >= flushRequest; });
+        if (failed) {
+            return false;
+        }
+    }
+    // SyncPolicy::None writes never fsync on their own
+    return ::fsync(fd) == 0;
+}
+
+bool Journal::truncate() {
+    std::unique_lock<std::mutex> lock(mutex);
+    // Wait for the writer to catch up with every append, including any made while waiting,
+    // then cut the file without letting go of the lock: an append can only follow the cut
+    flushRequest = appendedSeq;
+    wakeWriter.notify_one();
+    committed.wait(lock, [this] { return durableSeq >= appendedSeq; });
+    if (failed) {
+        return false;
+    }
+    return ::ftruncate(fd, static_cast<off_t>(HEADER_SIZE)) == 0 && ::fsync(fd) == 0;
+}
+
+void Journal::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeWriter.wait(lock, [this] { return stopping || !buffer.empty(); });
+        if (buffer.empty()) {
+            break; // Stopping with nothing left to write
+        }
+
+        // Hold the batch open until the latency bound unless it is full or someone is flushing
+        if (options.sync == SyncPolicy::Group || options.sync == SyncPolicy::Periodic) {
+            wakeWriter.wait_until(lock, oldestPending + options.commitWindow, [this] {
+                return stopping || buffer.size() >= options.maxBatchBytes || flushRequest > durableSeq;
+            });
+        }
+
+        std::string batch;
+        batch.swap(buffer);
+        uint64_t batchSeq = appendedSeq;
+        lock.unlock();
+        bool ok = writeAll(fd, batch.data(), batch.size()) &&
+                  (options.sync == SyncPolicy::None || ::fsync(fd) == 0);
+        int error = errno;
+        lock.lock();
+
+        if (!ok && !failed) {
+            LOG_ERROR("Journal write failed (" << std::strerror(error) << "); later events are not durable");
+        }
+        failed = failed || !ok;
+        durableSeq = batchSeq;
+        committed.notify_all();
+    }
+}
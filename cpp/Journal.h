@@ -0,0 +1,160 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "Ride.h"
+#include "GeoPoint.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * Kinds of state change recorded in the journal
+ */
+enum class JournalEventType : uint8_t {
+    AddDriver = 1,
+    AddRider,
+    CreateRide,
+    UpdateRating,
+    RepriceRide,
+    CancelRide
+};
+
+/**
+ * One journaled state change; only the fields of its type are encoded
+ * Values are absolute (a rating or distance after the change), so replaying
+ * an event that is already reflected in a snapshot leaves the state unchanged.
+ * Text fields view memory owned by the caller (or by the journal's read
+ * buffer for the duration of a replay callback).
+ */
+struct JournalEvent {
+    JournalEventType type = JournalEventType::AddDriver;
+    int id = 0;                   // Driver, rider or ride ID
+    std::string_view name;             // AddDriver, AddRider
+    std::string_view paymentMethod;    // AddRider
+    std::string_view pickup;           // CreateRide
+    std::string_view dropoff;          // CreateRide
+    RideType rideType = RideType::Standard; // CreateRide
+    int driverID = 0;             // CreateRide
+    int riderID = 0;              // CreateRide
+    double value = 0.0;           // Rating (AddDriver, UpdateRating) or distance (CreateRide, RepriceRide)
+    bool hasPoint = false;        // AddDriver location or CreateRide pickup point
+    GeoPoint point;
+    uint16_t surgePercent = 100;  // CreateRide quoted surge; only encoded when not 100
+};
+
+/**
+ * When appended events reach stable storage
+ */
+enum class SyncPolicy : uint8_t {
+    Always,   // Callers wait for fsync; concurrent callers share one fsync
+    Group,    // Callers wait for fsync; the writer gathers a batch for up to the commit window first
+    Periodic, // Callers return at once; the batch is written and fsynced each commit window
+    None      // Callers return at once; written without fsync (the OS decides)
+};
+
+/**
+ * Journal configuration
+ */
+struct JournalOptions {
+    SyncPolicy sync = SyncPolicy::Group;
+    std::chrono::microseconds commitWindow{2000}; // Latency bound for Group and Periodic batches
+    size_t maxBatchBytes = 1 << 20;               // A batch this large is committed without waiting
+};
+
+/**
+ * Journal - Append-only write-ahead log of system events
+ * Each event is encoded compactly (varint IDs and lengths, raw doubles)
+ * and framed with its length and a CRC32, so a record torn by a crash is
+ * detected and cut off on the next open. Appends only copy the encoded
+ * record into a buffer; a writer thread performs the write and fsync for
+ * everything buffered at once (group commit), and waiting callers are
+ * released together when their batch is durable.
+ */
+class Journal {
+private:
+    int fd;
+    JournalOptions options;
+    std::string buffer;        // Encoded records not yet handed to write()
+    uint64_t appendedSeq = 0;  // Sequence number of the last appended record
+    uint64_t durableSeq = 0;   // Last record written (and fsynced, unless SyncPolicy::None)
+    uint64_t flushRequest = 0; // Commit up to here without waiting for the window
+    std::chrono::steady_clock::time_point oldestPending;
+    bool failed = false;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable wakeWriter;
+    std::condition_variable committed;
+    std::thread writer;
+
+    Journal(int file, const JournalOptions& journalOptions);
+    void writerLoop();
+
+    /**
+     * Encode one event as a framed record
+     * @param event Event to encode
+     * @param out Receives the record, appended to its end
+     */
+    static void encode(const JournalEvent& event, std::string& out);
+
+public:
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    /**
+     * Open (or create) a journal, replaying the events already in it
+     * A torn or corrupt tail is truncated so new records follow valid data
+     * @param path Journal file
+     * @param journalOptions Sync policy and batching limits
+     * @param replay Called for every stored event, in order (may be empty)
+     * @return Journal ready for appends, or nullptr on I/O error or a foreign file
+     */
+    static std::unique_ptr<Journal> open(const std::string& path, const JournalOptions& journalOptions,
+                                         const std::function<void(const JournalEvent&)>& replay);
+
+    /**
+     * Buffer an event without waiting for it to be written
+     * @param event Event to record
+     * @return Sequence number to pass to commit()
+     */
+    uint64_t append(const JournalEvent& event);
+
+    /**
+     * Wait until a buffered event is durable, as the sync policy requires
+     * Returns at once under SyncPolicy::Periodic and SyncPolicy::None
+     * @param sequence Value returned by append()
+     * @return False if the journal failed to write
+     */
+    bool commit(uint64_t sequence);
+
+    /**
+     * Write and fsync everything appended so far, regardless of policy
+     * @return False if the journal failed to write
+     */
+    bool flush();
+
+    /**
+     * Discard every record (after a snapshot has captured the state)
+     * Appends block until the file is cut, so none is written and then lost
+     * @return False on I/O error
+     */
+    bool truncate();
+
+    SyncPolicy policy() const { return options.sync; }
+};
+
+/**
+ * Parse a sync policy name ("always", "group", "periodic", "none")
+ * @param name Policy name
+ * @param policy Receives the parsed policy
+ * @return True if the name is known
+ */
+bool parseSyncPolicy(const std::string& name, SyncPolicy& policy);
+
+#endif // JOURNAL_H
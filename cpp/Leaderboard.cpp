@@ -0,0 +1,95 @@
+#include "Leaderboard.h"
+#include <algorithm>
+
+void Leaderboard::update(int driverID, double earnings, size_t rideCount, double rating) {
+    if (driverID < 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t slot = static_cast<size_t>(driverID);
+    if (slot >= drivers.size()) {
+        drivers.resize(std::max(slot + 1, drivers.size() * 2));
+    }
+    Scores& scores = drivers[slot];
+    scores.latest[static_cast<size_t>(LeaderboardMetric::Earnings)] = earnings;
+    scores.latest[static_cast<size_t>(LeaderboardMetric::RideCount)] = static_cast<double>(rideCount);
+    scores.latest[static_cast<size_t>(LeaderboardMetric::Rating)] = rating;
+    if (!scores.listed) {
+        scores.listed = true;
+        listedCount++;
+    }
+    if (!scores.queued) {
+        scores.queued = true;
+        pending.push_back(driverID);
+    }
+}
+
+void Leaderboard::applyPendingLocked() {
+    for (int driverID : pending) {
+        Scores& scores = drivers[static_cast<size_t>(driverID)];
+        if (!scores.queued) {
+            continue; // Removed after it was queued
+        }
+        scores.queued = false;
+        for (size_t m = 0; m < LEADERBOARD_METRIC_COUNT; ++m) {
+            if (!scores.filed) {
+                lists[m].insert({scores.latest[m], driverID});
+            } else if (scores.filedValues[m] != scores.latest[m]) {
+                // Only metrics that actually changed are moved
+                lists[m].erase({scores.filedValues[m], driverID});
+                lists[m].insert({scores.latest[m], driverID});
+            }
+            scores.filedValues[m] = scores.latest[m];
+        }
+        scores.filed = true;
+    }
+    pending.clear();
+}
+
+bool Leaderboard::remove(int driverID) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t slot = static_cast<size_t>(driverID);
+    if (driverID < 0 || slot >= drivers.size() || !drivers[slot].listed) {
+        return false;
+    }
+    if (drivers[slot].filed) {
+        for (size_t m = 0; m < LEADERBOARD_METRIC_COUNT; ++m) {
+            lists[m].erase({drivers[slot].filedValues[m], driverID});
+        }
+    }
+    drivers[slot] = Scores();
+    listedCount--;
+    return true;
+}
+
+std::vector<LeaderboardEntry> Leaderboard::top(LeaderboardMetric metric, size_t k) {
+    std::lock_guard<std::mutex> lock(mutex);
+    applyPendingLocked();
+    const RankList& list = lists[static_cast<size_t>(metric)];
+    std::vector<LeaderboardEntry> result;
+    result.reserve(std::min(k, list.size()));
+    list.collect([&](const RankKey& key) {
+        if (result.size() == k) {
+            return false;
+        }
+        result.push_back({key.id, key.score});
+        return true;
+    });
+    return result;
+}
+
+size_t Leaderboard::rank(LeaderboardMetric metric, int driverID) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t slot = static_cast<size_t>(driverID);
+    if (driverID < 0 || slot >= drivers.size() || !drivers[slot].listed) {
+        return 0;
+    }
+    applyPendingLocked();
+    size_t m = static_cast<size_t>(metric);
+    return lists[m].countBefore({drivers[slot].filedValues[m], driverID}) + 1;
+}
+
+size_t Leaderboard::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return listedCount;
+}
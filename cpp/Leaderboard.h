@@ -0,0 +1,125 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include "BlockedOrderedList.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * What a leaderboard ranking orders drivers by (highest first)
+ */
+enum class LeaderboardMetric : uint8_t {
+    Earnings,
+    RideCount,
+    Rating
+};
+
+/**
+ * Number of leaderboard metrics (size of per-metric tables)
+ */
+constexpr size_t LEADERBOARD_METRIC_COUNT = 3;
+
+/**
+ * One ranked driver
+ */
+struct LeaderboardEntry {
+    int driverID;
+    double score; // Earnings in dollars, ride count or rating
+};
+
+/**
+ * Position of a driver in one ranking
+ */
+struct RankKey {
+    double score;
+    int id;
+};
+
+/**
+ * Ranking order: score, highest first, with ties broken by the lower driver ID
+ */
+struct RankBefore {
+    bool operator()(const RankKey& a, const RankKey& b) const {
+        return a.score > b.score || (a.score == b.score && a.id < b.id);
+    }
+};
+
+/**
+ * RankList - One ranking, as an order-statistic list of (score, driver ID)
+ */
+using RankList = BlockedOrderedList<RankKey, RankBefore>;
+
+/**
+ * Leaderboard - Driver rankings by earnings, ride count and rating
+ * Drivers publish their new figures whenever a ride is added, re-priced or
+ * removed or their rating changes. Publishing is O(1): the figures are
+ * recorded and the driver is queued once; the next query moves each queued
+ * driver in the rankings whose figures changed, so a burst of rides for one
+ * driver costs a single move. Top-K and rank queries then cost O(log n)
+ * (plus k) and never scan drivers.
+ *
+ * Thread safety: all operations are serialized by an internal mutex, which
+ * is a leaf lock (drivers publish while holding their own lock, so updates
+ * of one driver reach the board in the order they were applied).
+ */
+class Leaderboard {
+private:
+    struct Scores {
+        bool listed = false;  // On the board (filed, or waiting to be filed)
+        bool filed = false;   // Present in the rank lists under filedValues
+        bool queued = false;  // In the pending list
+        double filedValues[LEADERBOARD_METRIC_COUNT] = {};
+        double latest[LEADERBOARD_METRIC_COUNT] = {};
+    };
+
+    RankList lists[LEADERBOARD_METRIC_COUNT];
+    std::vector<Scores> drivers; // Indexed by driver ID
+    std::vector<int> pending;    // Drivers published since the last query
+    size_t listedCount = 0;
+    std::mutex mutex;
+
+    // File every queued driver under its latest figures (caller holds mutex)
+    void applyPendingLocked();
+
+public:
+    /**
+     * Record a driver's current figures for every ranking
+     * @param driverID Driver ID (non-negative; IDs are expected to be dense)
+     * @param earnings Total earnings
+     * @param rideCount Number of rides
+     * @param rating Current rating
+     */
+    void update(int driverID, double earnings, size_t rideCount, double rating);
+
+    /**
+     * Drop a driver from every ranking
+     * @param driverID Driver ID
+     * @return True if the driver was ranked
+     */
+    bool remove(int driverID);
+
+    /**
+     * Best drivers for a metric
+     * @param metric Ranking to read
+     * @param k Maximum number of drivers
+     * @return Up to k drivers, best first
+     */
+    std::vector<LeaderboardEntry> top(LeaderboardMetric metric, size_t k);
+
+    /**
+     * Position of a driver in a ranking
+     * @param metric Ranking to read
+     * @param driverID Driver ID
+     * @return 1 for the best driver, 0 if the driver is not ranked
+     */
+    size_t rank(LeaderboardMetric metric, int driverID);
+
+    /**
+     * Number of ranked drivers
+     */
+    size_t size();
+};
+
+#endif // LEADERBOARD_H
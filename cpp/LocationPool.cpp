@@ -0,0 +1,89 @@
+#include "LocationPool.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+std::atomic<StringStorage> globalStorage{StringStorage::Heap};
+std::atomic<bool> globalCreated{false};
+
+} // namespace
+
+LocationPool::LocationPool(StringStorage textStorage) : count(0), storage(textStorage) {}
+
+LocationPool& LocationPool::global() {
+    static LocationPool pool(globalStorage.load());
+    globalCreated.store(true, std::memory_order_relaxed);
+    return pool;
+}
+
+bool LocationPool::configureGlobal(StringStorage textStorage) {
+    if (globalCreated.load()) {
+        return false;
+    }
+    globalStorage.store(textStorage);
+    return true;
+}
+
+std::string_view LocationPool::storeText(std::string_view name) {
+    if (storage == StringStorage::Heap) {
+        strings.emplace_back(name);
+        return strings.back();
+    }
+    if (name.empty()) {
+        return std::string_view(); // Nothing to copy, and the cursor may not point at a block yet
+    }
+    if (name.size() > arenaLeft) {
+        // Oversized names get a block of their own so the current block keeps its space
+        size_t blockSize = std::max(ARENA_BLOCK_SIZE, name.size());
+        arenaBlocks.emplace_back(new char[blockSize]);
+        if (blockSize == ARENA_BLOCK_SIZE) {
+            arenaCursor = arenaBlocks.back().get();
+            arenaLeft = blockSize;
+        } else {
+            std::memcpy(arenaBlocks.back().get(), name.data(), name.size());
+            return std::string_view(arenaBlocks.back().get(), name.size());
+        }
+    }
+    std::memcpy(arenaCursor, name.data(), name.size());
+    std::string_view stored(arenaCursor, name.size());
+    arenaCursor += name.size();
+    arenaLeft -= name.size();
+    return stored;
+}
+
+uint32_t LocationPool::intern(std::string_view name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = index.find(name);
+        if (it != index.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = index.find(name); // Another thread may have added it meanwhile
+    if (it != index.end()) {
+        return it->second;
+    }
+
+    // Every name costs far more than a byte, so memory runs out long before the 32-bit IDs do
+    uint32_t id = count.load(std::memory_order_relaxed);
+    std::string_view* names = chunks.allocate(id);
+
+    std::string_view stored = storeText(name);
+    names[NameDirectory::offset(id)] = stored;
+    index.emplace(stored, id);
+    count.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+bool LocationPool::find(std::string_view name, uint32_t& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = index.find(name);
+    if (it == index.end()) {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
@@ -0,0 +1,109 @@
+#ifndef LOCATION_POOL_H
+#define LOCATION_POOL_H
+
+#include "ChunkDirectory.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Where LocationPool keeps the text of interned names
+ */
+enum class StringStorage {
+    Heap,  // One std::string per name (names over 15 characters get their own allocation)
+    Arena  // Names packed back to back in 64 KiB blocks: no per-name allocation or header
+};
+
+/**
+ * LocationPool - Interning table for pickup/dropoff location names
+ * Each distinct name is stored once and referenced by a compact 32-bit ID,
+ * so rides carry two IDs instead of two std::string copies.
+ * Names are kept in fixed-size chunks that never move, which makes the
+ * returned string_views stable and lets name() run without locking. The
+ * chunk directory spans the whole 32-bit ID space, so the pool grows until
+ * memory runs out instead of stopping at a fixed number of names.
+ * Interning an already known name only takes a shared lock, so concurrent
+ * dispatchers reusing the same locations do not serialize on the pool.
+ * With StringStorage::Arena the text itself is bump-allocated in large
+ * blocks, which matters once there are millions of distinct long names.
+ */
+class LocationPool {
+private:
+    using NameDirectory = ChunkDirectory<std::string_view, 12, 32>;
+
+    static constexpr size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+    NameDirectory chunks;
+    std::unordered_map<std::string_view, uint32_t> index; // Keys view the stored text
+    std::atomic<uint32_t> count;
+    mutable std::shared_mutex mutex; // Exclusive only to add a name; lookups by ID are lock-free
+    const StringStorage storage;
+    std::deque<std::string> strings;                // StringStorage::Heap text
+    std::vector<std::unique_ptr<char[]>> arenaBlocks; // StringStorage::Arena text
+    char* arenaCursor = nullptr;
+    size_t arenaLeft = 0;
+
+    /**
+     * Copy a new name into the pool's text storage (exclusive lock held)
+     */
+    std::string_view storeText(std::string_view name);
+
+public:
+    /**
+     * @param textStorage How the text of interned names is stored
+     */
+    explicit LocationPool(StringStorage textStorage = StringStorage::Heap);
+    LocationPool(const LocationPool&) = delete;
+    LocationPool& operator=(const LocationPool&) = delete;
+
+    /**
+     * Process-wide pool shared by all rides
+     */
+    static LocationPool& global();
+
+    /**
+     * Choose the text storage of the global pool
+     * Only effective before the first use of global()
+     * @param textStorage Storage mode for global()
+     * @return False if the global pool already exists
+     */
+    static bool configureGlobal(StringStorage textStorage);
+
+    /**
+     * Intern a location name
+     * @param name Location name
+     * @return ID shared by every occurrence of this name
+     */
+    uint32_t intern(std::string_view name);
+
+    /**
+     * Look up an already interned name without adding it
+     * @param name Location name
+     * @param id Receives the ID if found
+     * @return True if the name has been interned
+     */
+    bool find(std::string_view name, uint32_t& id) const;
+
+    /**
+     * Resolve an ID returned by intern()
+     * @param id Location ID
+     * @return Stable view of the location name
+     */
+    std::string_view name(uint32_t id) const {
+        return chunks.chunk(id)[NameDirectory::offset(id)];
+    }
+
+    /**
+     * Number of distinct locations interned so far
+     */
+    size_t size() const { return count.load(std::memory_order_acquire); }
+};
+
+#endif // LOCATION_POOL_H
@@ -0,0 +1,185 @@
+#include "Logger.h"
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+// Size of the writer's output batch; records are copied here and written
+// with a single fwrite instead of one write per line
+constexpr size_t WRITE_BATCH = 64 * 1024;
+
+const char* levelPrefix(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "[DEBUG] ";
+        case LogLevel::Info:  return "[LOG] ";
+        case LogLevel::Warn:  return "[WARN] ";
+        case LogLevel::Error: return "[ERROR] ";
+        default:              return "";
+    }
+}
+
+} // namespace
+
+Logger::Logger()
+    : ring(new Slot[RING_CAPACITY]), enqueuePos(0), dequeuePos(0), writtenPos(0),
+      level(LogLevel::Info), writerIdle(false), running(true), output(stdout) {
+    for (size_t i = 0; i < RING_CAPACITY; ++i) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer = std::thread(&Logger::writerLoop, this);
+}
+
+Logger::~Logger() {
+    running.store(false);
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeWriter.notify_one();
+    }
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+void Logger::setOutput(FILE* file) {
+    flush();
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    output = file;
+}
+
+void Logger::submit(LogLevel messageLevel, const char* text, size_t length) {
+    if (length > MAX_MESSAGE) {
+        length = MAX_MESSAGE;
+    }
+
+    // Claim a slot (bounded MPMC ring, Vyukov-style sequence numbers)
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &ring[pos & (RING_CAPACITY - 1)];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Ring is full: make sure the writer is running and back off
+            wake();
+            std::this_thread::yield();
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = messageLevel;
+    slot->length = static_cast<uint16_t>(length);
+    std::memcpy(slot->text, text, length);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    wake();
+}
+
+void Logger::wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writerIdle.load(std::memory_order_relaxed) && writerIdle.exchange(false)) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeWriter.notify_one();
+    }
+}
+
+void Logger::flush() {
+    size_t target = enqueuePos.load(std::memory_order_acquire);
+    if (writtenPos.load(std::memory_order_acquire) >= target || !running.load()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    writerIdle.store(false);
+    wakeWriter.notify_one();
+    drained.wait(lock, [&]() {
+        return writtenPos.load(std::memory_order_acquire) >= target;
+    });
+}
+
+void Logger::writerLoop() {
+    std::unique_ptr<char[]> batch(new char[WRITE_BATCH]);
+    size_t used = 0;
+
+    while (true) {
+        FILE* out;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            out = output;
+        }
+
+        // Drain every published record into the batch buffer
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        size_t start = pos;
+        while (true) {
+            Slot& slot = ring[pos & (RING_CAPACITY - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+                break;
+            }
+            const char* prefix = levelPrefix(slot.level);
+            size_t prefixLength = std::strlen(prefix);
+            if (used + prefixLength + slot.length + 1 > WRITE_BATCH) {
+                std::fwrite(batch.get(), 1, used, out);
+                used = 0;
+            }
+            std::memcpy(batch.get() + used, prefix, prefixLength);
+            used += prefixLength;
+            std::memcpy(batch.get() + used, slot.text, slot.length);
+            used += slot.length;
+            batch[used++] = '\n';
+
+            slot.sequence.store(pos + RING_CAPACITY, std::memory_order_release);
+            ++pos;
+        }
+        dequeuePos.store(pos, std::memory_order_relaxed);
+
+        if (pos != start) {
+            std::fwrite(batch.get(), 1, used, out);
+            std::fflush(out);
+            used = 0;
+            writtenPos.store(pos, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            drained.notify_all();
+            continue; // Check again before sleeping
+        }
+
+        if (!running.load()) {
+            break;
+        }
+
+        // Idle: sleep until a producer or flush() wakes us
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        writerIdle.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Slot& next = ring[pos & (RING_CAPACITY - 1)];
+        if (next.sequence.load(std::memory_order_acquire) != pos + 1 && running.load()) {
+            wakeWriter.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        writerIdle.store(false);
+    }
+}
+
+LogMessage::ThreadState& LogMessage::threadState() {
+    static thread_local ThreadState state;
+    return state;
+}
+
+LogMessage::LogMessage(LogLevel level) : messageLevel(level), state(threadState()) {
+    state.buffer.reset();
+    state.stream.clear();
+    state.stream.flags(std::ios_base::dec | std::ios_base::skipws);
+    state.stream.precision(6);
+}
+
+LogMessage::~LogMessage() {
+    Logger::instance().submit(messageLevel, state.buffer.data, state.buffer.length());
+}
@@ -0,0 +1,174 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <memory>
+
+/**
+ * Severity levels, lowest to highest
+ */
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3,
+    Off = 4
+};
+
+/**
+ * Compile-time minimum level. Statements below it are removed entirely,
+ * e.g. build with -DLOG_COMPILE_LEVEL=4 to compile all logging out
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+/**
+ * Logger - Asynchronous, level-filtered logging subsystem
+ * Callers format a record into a thread-local buffer and push it into a
+ * bounded lock-free ring; a background writer thread drains the ring to the
+ * output in large writes, so logging never flushes stdout on the hot path.
+ */
+class Logger {
+public:
+    static constexpr size_t RING_CAPACITY = 4096; // Must be a power of two
+    static constexpr size_t MAX_MESSAGE = 240;    // Longer records are truncated
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        uint16_t length;
+        char text[MAX_MESSAGE];
+    };
+
+    std::unique_ptr<Slot[]> ring;
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+    alignas(64) std::atomic<size_t> writtenPos;   // Records written and flushed
+    std::atomic<LogLevel> level;
+    std::atomic<bool> writerIdle;
+    std::atomic<bool> running;
+    FILE* output;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeWriter;
+    std::condition_variable drained;
+    std::thread writer;
+
+    Logger();
+    void writerLoop();
+    void wake();
+
+public:
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /**
+     * Process-wide logger instance (writer thread starts on first use)
+     */
+    static Logger& instance();
+
+    /**
+     * Runtime level filter
+     * @param minLevel Records below this level are discarded
+     */
+    void setLevel(LogLevel minLevel) { level.store(minLevel, std::memory_order_relaxed); }
+    LogLevel getLevel() const { return level.load(std::memory_order_relaxed); }
+    bool isEnabled(LogLevel messageLevel) const {
+        return messageLevel >= level.load(std::memory_order_relaxed) && messageLevel != LogLevel::Off;
+    }
+
+    /**
+     * Redirect output (default stdout); pending records are flushed first
+     * @param file Destination stream
+     */
+    void setOutput(FILE* file);
+
+    /**
+     * Queue a formatted record for the writer thread
+     * Blocks only while the ring is full
+     * @param messageLevel Record severity
+     * @param text Message text (without prefix or newline)
+     * @param length Message length in bytes
+     */
+    void submit(LogLevel messageLevel, const char* text, size_t length);
+
+    /**
+     * Wait until every record queued so far has been written out
+     * Call before printing directly to stdout so output stays in order
+     */
+    void flush();
+};
+
+/**
+ * LogMessage - Formats one record into a reusable thread-local buffer
+ * and submits it on destruction. Used through the LOG_* macros.
+ */
+class LogMessage {
+private:
+    class FixedBuffer : public std::streambuf {
+    public:
+        char data[Logger::MAX_MESSAGE];
+        void reset() { setp(data, data + sizeof(data)); }
+        size_t length() const { return static_cast<size_t>(pptr() - pbase()); }
+    };
+
+    struct ThreadState {
+        FixedBuffer buffer;
+        std::ostream stream;
+        ThreadState() : stream(&buffer) {}
+    };
+
+    static ThreadState& threadState();
+
+    LogLevel messageLevel;
+    ThreadState& state;
+
+public:
+    explicit LogMessage(LogLevel messageLevel);
+    ~LogMessage();
+    std::ostream& stream() { return state.stream; }
+};
+
+#define LOG_AT(level, expr)                                   \
+    do {                                                      \
+        if (Logger::instance().isEnabled(level)) {            \
+            LogMessage logMessage_(level);                    \
+            logMessage_.stream() << expr;                     \
+        }                                                     \
+    } while (0)
+
+#if LOG_COMPILE_LEVEL <= 0
+#define LOG_DEBUG(expr) LOG_AT(LogLevel::Debug, expr)
+#else
+#define LOG_DEBUG(expr) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= 1
+#define LOG_INFO(expr) LOG_AT(LogLevel::Info, expr)
+#else
+#define LOG_INFO(expr) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= 2
+#define LOG_WARN(expr) LOG_AT(LogLevel::Warn, expr)
+#else
+#define LOG_WARN(expr) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= 3
+#define LOG_ERROR(expr) LOG_AT(LogLevel::Error, expr)
+#else
+#define LOG_ERROR(expr) do {} while (0)
+#endif
+
+#endif // LOGGER_H
@@ -0,0 +1,254 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+namespace {
+
+// Prometheus bucket bounds: powers of two from 64 ns to about 17 s
+const int FIRST_EXPORTED_POWER = 6;
+const int LAST_EXPORTED_POWER = 34;
+
+std::string formatNumber(double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.10g", value);
+    return text;
+}
+
+} // namespace
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const Stripe& stripe : stripes) {
+        total += stripe.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t HistogramSnapshot::quantile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::max(0.0, std::min(1.0, q)) * (count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            return std::min(Histogram::bucketUpperBound(b), max);
+        }
+    }
+    return max;
+}
+
+uint64_t HistogramSnapshot::countAtOrBelow(uint64_t nanos) const {
+    uint64_t total = 0;
+    for (size_t b = 0; b < buckets.size() && Histogram::bucketUpperBound(b) <= nanos; ++b) {
+        total += buckets[b];
+    }
+    return total;
+}
+
+Histogram::Histogram(uint32_t sampleInterval) {
+    setSampleInterval(sampleInterval);
+}
+
+size_t Histogram::bucketFor(uint64_t nanos) {
+    const uint64_t linear = 1ULL << SUB_BUCKET_BITS;
+    if (nanos < linear) {
+        return static_cast<size_t>(nanos);
+    }
+    // Keep the top SUB_BUCKET_BITS - 1 bits below the leading one as the sub-bucket
+    int exponent = 63 - __builtin_clzll(nanos);
+    uint64_t mantissa = nanos >> (exponent - (SUB_BUCKET_BITS - 1));
+    const uint64_t half = linear / 2;
+    return static_cast<size_t>((exponent - SUB_BUCKET_BITS + 2) * half + (mantissa - half));
+}
+
+uint64_t Histogram::bucketUpperBound(size_t bucket) {
+    const size_t linear = 1 << SUB_BUCKET_BITS;
+    if (bucket < linear) {
+        return bucket;
+    }
+    const size_t half = linear / 2;
+    int exponent = static_cast<int>(bucket / half) + SUB_BUCKET_BITS - 2;
+    uint64_t mantissa = bucket % half + half;
+    // The last bucket's bound wraps to 2^64 - 1, which is what it should be
+    return ((mantissa + 1) << (exponent - (SUB_BUCKET_BITS - 1))) - 1;
+}
+
+void Histogram::record(uint64_t nanos, uint64_t weight) {
+    buckets[bucketFor(nanos)].fetch_add(weight, std::memory_order_relaxed);
+    sum.fetch_add(nanos * weight, std::memory_order_relaxed);
+    uint64_t seen = max.load(std::memory_order_relaxed);
+    while (nanos > seen && !max.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::setSampleInterval(uint32_t sampleInterval) {
+    uint32_t interval = 1;
+    while (interval < sampleInterval && interval < (1u << 30)) {
+        interval <<= 1;
+    }
+    sampleMask.store(interval - 1, std::memory_order_relaxed);
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot result;
+    result.buckets.resize(BUCKET_COUNT);
+    for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+        result.buckets[b] = buckets[b].load(std::memory_order_relaxed);
+        result.count += result.buckets[b];
+    }
+    result.sum = sum.load(std::memory_order_relaxed);
+    result.max = max.load(std::memory_order_relaxed);
+    return result;
+}
+
+MetricsRegistry::MetricsRegistry(std::string namePrefix) : prefix(std::move(namePrefix)) {}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex);
+    metrics.push_back({name, help, Kind::Counter, std::make_unique<Counter>(), nullptr, nullptr});
+    return *metrics.back().counter;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex);
+    metrics.push_back({name, help, Kind::Histogram, nullptr, std::make_unique<Histogram>(), nullptr});
+    return *metrics.back().histogram;
+}
+
+void MetricsRegistry::gauge(const std::string& name, const std::string& help, std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mutex);
+    metrics.push_back({name, help, Kind::Gauge, nullptr, nullptr, std::move(read)});
+}
+
+void MetricsRegistry::setSampleInterval(uint32_t sampleInterval) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Metric& metric : metrics) {
+        if (metric.histogram) {
+            metric.histogram->setSampleInterval(sampleInterval);
+        }
+    }
+}
+
+double MetricsRegistry::value(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Metric& metric : metrics) {
+        if (metric.name != name) {
+            continue;
+        }
+        switch (metric.kind) {
+            case Kind::Counter: return static_cast<double>(metric.counter->value());
+            case Kind::Histogram: return static_cast<double>(metric.histogram->snapshot().count);
+            case Kind::Gauge: return metric.gauge();
+        }
+    }
+    return 0.0;
+}
+
+void MetricsRegistry::display(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    out << "Counters and gauges:" << std::endl;
+    for (const Metric& metric : metrics) {
+        if (metric.kind == Kind::Counter) {
+            out << "  " << std::left << std::setw(28) << metric.name << std::right << std::setw(14)
+                << metric.counter->value() << std::endl;
+        } else if (metric.kind == Kind::Gauge) {
+            out << "  " << std::left << std::setw(28) << metric.name << std::right << std::setw(14)
+                << std::fixed << std::setprecision(0) << metric.gauge() << std::endl;
+        }
+    }
+
+    out << "\nLatency (ns):" << std::endl;
+    out << "  " << std::left << std::setw(28) << "operation" << std::right << std::setw(12) << "calls"
+        << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p90"
+        << std::setw(10) << "p99" << std::setw(12) << "max" << std::endl;
+    for (const Metric& metric : metrics) {
+        if (metric.kind != Kind::Histogram) {
+            continue;
+        }
+        HistogramSnapshot snapshot = metric.histogram->snapshot();
+        out << "  " << std::left << std::setw(28) << metric.name << std::right << std::setw(12) << snapshot.count
+            << std::fixed << std::setprecision(0) << std::setw(10) << snapshot.mean()
+            << std::setw(10) << snapshot.quantile(0.5) << std::setw(10) << snapshot.quantile(0.9)
+            << std::setw(10) << snapshot.quantile(0.99) << std::setw(12) << snapshot.max << std::endl;
+    }
+}
+
+std::string MetricsRegistry::renderPrometheus() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream out;
+    for (const Metric& metric : metrics) {
+        std::string name = prefix + metric.name;
+        switch (metric.kind) {
+            case Kind::Counter:
+                name += "_total";
+                out << "# HELP " << name << " " << metric.help << "\n";
+                out << "# TYPE " << name << " counter\n";
+                out << name << " " << metric.counter->value() << "\n";
+                break;
+            case Kind::Gauge:
+                out << "# HELP " << name << " " << metric.help << "\n";
+                out << "# TYPE " << name << " gauge\n";
+                out << name << " " << formatNumber(metric.gauge()) << "\n";
+                break;
+            case Kind::Histogram: {
+                name += "_seconds";
+                HistogramSnapshot snapshot = metric.histogram->snapshot();
+                out << "# HELP " << name << " " << metric.help << "\n";
+                out << "# TYPE " << name << " histogram\n";
+                for (int power = FIRST_EXPORTED_POWER; power <= LAST_EXPORTED_POWER; ++power) {
+                    uint64_t bound = 1ULL << power;
+                    out << name << "_bucket{le=\"" << formatNumber(bound * 1e-9) << "\"} "
+                        << snapshot.countAtOrBelow(bound) << "\n";
+                }
+                out << name << "_bucket{le=\"+Inf\"} " << snapshot.count << "\n";
+                out << name << "_sum " << formatNumber(snapshot.sum * 1e-9) << "\n";
+                out << name << "_count " << snapshot.count << "\n";
+                break;
+            }
+        }
+    }
+    return out.str();
+}
+
+bool MetricsRegistry::writePrometheus(const std::string& path) const {
+    std::string text = renderPrometheus();
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out << text;
+        if (!out) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+size_t residentMemoryBytes() {
+#ifdef __APPLE__
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) ==
+        KERN_SUCCESS) {
+        return static_cast<size_t>(info.resident_size);
+    }
+    return 0;
+#else
+    std::ifstream statm("/proc/self/statm");
+    size_t totalPages = 0;
+    size_t residentPages = 0;
+    if (!(statm >> totalPages >> residentPages)) {
+        return 0;
+    }
+    return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
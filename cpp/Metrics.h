@@ -0,0 +1,249 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Counter - Monotonic event count, safe to bump from any thread without locks
+ * Increments land on one of several cache-line-sized stripes picked per
+ * thread, so concurrent writers do not bounce a shared line; reads sum them.
+ */
+class Counter {
+private:
+    static const size_t STRIPES = 16;
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Stripe, STRIPES> stripes;
+
+    static size_t stripeIndex() {
+        static std::atomic<size_t> nextStripe{0};
+        thread_local size_t index = nextStripe.fetch_add(1, std::memory_order_relaxed) % STRIPES;
+        return index;
+    }
+
+public:
+    void add(uint64_t amount = 1) {
+        stripes[stripeIndex()].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+};
+
+/**
+ * Point-in-time copy of a histogram, with the quantiles computed from it
+ */
+struct HistogramSnapshot {
+    uint64_t count = 0;   // Estimated calls (sampled observations times the sample interval)
+    uint64_t sum = 0;     // Estimated total nanoseconds
+    uint64_t max = 0;     // Largest observation, in nanoseconds
+    std::vector<uint64_t> buckets;
+
+    double mean() const { return count > 0 ? static_cast<double>(sum) / count : 0.0; }
+
+    /**
+     * Upper bound of the bucket holding a quantile
+     * @param q Quantile in [0, 1]
+     * @return Latency in nanoseconds, within about 3% of the true value
+     */
+    uint64_t quantile(double q) const;
+
+    /**
+     * Estimated number of observations at or below a latency
+     * @param nanos Bound in nanoseconds
+     */
+    uint64_t countAtOrBelow(uint64_t nanos) const;
+};
+
+/**
+ * Histogram - HDR-style latency histogram in nanoseconds
+ * Buckets are log-linear: 16 linear sub-buckets per power of two (plus an
+ * exact range below 32 ns), so every recorded value keeps roughly 3% relative
+ * precision from nanoseconds to hours with a fixed 976-bucket array.
+ *
+ * Reading a clock costs more than the operations being timed, so callers
+ * time a random sample of calls (see LatencyTimer); each sampled
+ * observation is recorded with the interval as its weight, which keeps
+ * count and sum unbiased estimates of the totals.
+ */
+class Histogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 2) * (1 << (SUB_BUCKET_BITS - 1));
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint32_t> sampleMask; // interval - 1, interval a power of two
+
+    // Per-thread xorshift generator; random sampling cannot alias with call patterns
+    static uint64_t nextRandom() {
+        static std::atomic<uint64_t> seeds{0x9E3779B97F4A7C15ULL};
+        thread_local uint64_t state = seeds.fetch_add(0x9E3779B97F4A7C15ULL, std::memory_order_relaxed) | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+public:
+    explicit Histogram(uint32_t sampleInterval = 64);
+
+    static size_t bucketFor(uint64_t nanos);
+    static uint64_t bucketUpperBound(size_t bucket);
+
+    /**
+     * Record one latency observation
+     * @param nanos Latency in nanoseconds
+     * @param weight Calls the observation stands for
+     */
+    void record(uint64_t nanos, uint64_t weight = 1);
+
+    /**
+     * Decide whether the calling thread should time this call
+     * @return The observation weight, or 0 to skip timing
+     */
+    uint32_t sample() const {
+        uint32_t mask = sampleMask.load(std::memory_order_relaxed);
+        if (mask == 0) {
+            return 1;
+        }
+        return (static_cast<uint32_t>(nextRandom() >> 32) & mask) == 0 ? mask + 1 : 0;
+    }
+
+    /**
+     * @param sampleInterval Time one in this many calls (rounded up to a power of two; 1 = every call)
+     */
+    void setSampleInterval(uint32_t sampleInterval);
+
+    HistogramSnapshot snapshot() const;
+};
+
+/**
+ * Times the enclosing scope into a histogram when the call is sampled
+ */
+class LatencyTimer {
+private:
+    Histogram& histogram;
+    uint32_t weight;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit LatencyTimer(Histogram& target) : histogram(target), weight(target.sample()) {
+        if (weight) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~LatencyTimer() {
+        if (weight) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            histogram.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), weight);
+        }
+    }
+
+    LatencyTimer(const LatencyTimer&) = delete;
+    LatencyTimer& operator=(const LatencyTimer&) = delete;
+};
+
+/**
+ * MetricsRegistry - Named counters, latency histograms and gauges
+ * Metrics are registered once (typically in a constructor) and then updated
+ * through the returned references, which stay valid for the registry's
+ * lifetime; updating never touches the registry itself. Gauges are
+ * callbacks evaluated only when the metrics are displayed or exported.
+ */
+class MetricsRegistry {
+private:
+    enum class Kind { Counter, Histogram, Gauge };
+
+    struct Metric {
+        std::string name;
+        std::string help;
+        Kind kind;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Histogram> histogram;
+        std::function<double()> gauge;
+    };
+
+    std::string prefix;
+    std::deque<Metric> metrics;
+    mutable std::mutex mutex; // Guards registration against concurrent reads of the list
+
+public:
+    /**
+     * @param namePrefix Prepended to every exported metric name
+     */
+    explicit MetricsRegistry(std::string namePrefix = "");
+
+    /**
+     * Register a counter
+     * @param name Metric name, exported with a _total suffix
+     * @param help One-line description
+     */
+    Counter& counter(const std::string& name, const std::string& help);
+
+    /**
+     * Register a latency histogram
+     * @param name Metric name, exported in seconds with a _seconds suffix
+     * @param help One-line description
+     */
+    Histogram& histogram(const std::string& name, const std::string& help);
+
+    /**
+     * Register a gauge
+     * @param name Metric name
+     * @param help One-line description
+     * @param read Called for the current value on every display or export
+     */
+    void gauge(const std::string& name, const std::string& help, std::function<double()> read);
+
+    /**
+     * Change the sampling of every registered histogram
+     * @param sampleInterval Time one in this many calls (1 = every call)
+     */
+    void setSampleInterval(uint32_t sampleInterval);
+
+    /**
+     * Current value of a counter or gauge (a histogram's estimated count)
+     * @param name Name it was registered under
+     * @return The value, or 0 if no such metric exists
+     */
+    double value(const std::string& name) const;
+
+    /**
+     * Human-readable table: counters, gauges, and count/mean/p50/p90/p99/max per histogram
+     */
+    void display(std::ostream& out) const;
+
+    /**
+     * Prometheus text exposition format (version 0.0.4)
+     */
+    std::string renderPrometheus() const;
+
+    /**
+     * Write renderPrometheus() to a file, replacing it atomically
+     * @param path Output file, e.g. for the node exporter's textfile collector
+     * @return False on I/O error
+     */
+    bool writePrometheus(const std::string& path) const;
+};
+
+/**
+ * Resident memory of this process in bytes (0 where unsupported)
+ */
+size_t residentMemoryBytes();
+
+#endif // METRICS_H
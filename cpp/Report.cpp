@@ -0,0 +1,93 @@
+#include "Report.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <unistd.h>
+
+ReportBuffer& ReportBuffer::operator<<(FixedPoint number) {
+    // Room for any finite double in fixed notation at report precisions
+    char digits[400];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number.value, std::chars_format::fixed,
+                                number.precision);
+    if (result.ec == std::errc()) {
+        text.append(digits, static_cast<size_t>(result.ptr - digits));
+    } else {
+        int length = std::snprintf(digits, sizeof(digits), "%.*e", number.precision, number.value);
+        text.append(digits, static_cast<size_t>(std::max(length, 0)));
+    }
+    return *this;
+}
+
+ReportWriter::ReportWriter(std::ostream& out) : stream(&out) {}
+
+ReportWriter::ReportWriter(int fileDescriptor) : fd(fileDescriptor) {}
+
+ReportWriter::~ReportWriter() {
+    flush();
+}
+
+void ReportWriter::drain() {
+    if (buf.empty()) {
+        return;
+    }
+    if (failed) {
+        buf.clear(); // Output is already incomplete; do not retry every block
+        return;
+    }
+    if (stream) {
+        stream->write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        stream->flush();
+        failed = !*stream;
+    } else {
+        const char* cursor = buf.data();
+        size_t remaining = buf.size();
+        while (remaining > 0) {
+            ssize_t n = ::write(fd, cursor, remaining);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOG_ERROR("Report write failed: " << std::strerror(errno));
+                failed = true;
+                break;
+            }
+            cursor += n;
+            remaining -= static_cast<size_t>(n);
+        }
+    }
+    if (!failed) {
+        written += buf.size();
+    }
+    buf.clear();
+}
+
+bool ReportWriter::flush() {
+    drain();
+    return !failed;
+}
+
+ReportRange::ReportRange(const std::vector<int>& rideIDs, const ReportPage& page) {
+    first = std::min(page.offset, rideIDs.size());
+    if (page.afterRideID != 0 && !(first > 0 && rideIDs[first - 1] == page.afterRideID)) {
+        auto it = std::find(rideIDs.begin(), rideIDs.end(), page.afterRideID);
+        if (it != rideIDs.end()) {
+            first = static_cast<size_t>(it - rideIDs.begin()) + 1;
+        } else if (first > 0) {
+            first--; // The anchor ride was cancelled, so the rides after it moved up one slot
+        }
+    }
+    last = first + std::min(page.limit, rideIDs.size() - first);
+}
+
+ReportCursor ReportRange::cursor(const std::vector<int>& rideIDs, size_t limit) const {
+    ReportCursor cursor;
+    cursor.next.offset = last;
+    cursor.next.limit = limit;
+    cursor.next.afterRideID = last > 0 ? rideIDs[last - 1] : 0;
+    cursor.listed = last - first;
+    cursor.total = rideIDs.size();
+    return cursor;
+}
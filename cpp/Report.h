@@ -0,0 +1,193 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Fixed-point number for ReportBuffer (like std::fixed with setprecision)
+ */
+struct FixedPoint {
+    double value;
+    int precision;
+};
+
+inline FixedPoint fixed(double value, int precision) {
+    return {value, precision};
+}
+
+/**
+ * ReportBuffer - Reusable text buffer for report formatting
+ * Text and numbers are appended without iostream state or locale lookups;
+ * numbers go through std::to_chars. clear() keeps the capacity, so a
+ * buffer reused across pages stops allocating after the first one.
+ */
+class ReportBuffer {
+private:
+    std::string text;
+
+public:
+    ReportBuffer& operator<<(std::string_view value) {
+        text.append(value.data(), value.size());
+        return *this;
+    }
+
+    ReportBuffer& operator<<(const char* value) {
+        return *this << std::string_view(value);
+    }
+
+    ReportBuffer& operator<<(char value) {
+        text.push_back(value);
+        return *this;
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, char>::value &&
+                                                      !std::is_same<T, bool>::value>>
+    ReportBuffer& operator<<(T value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text.append(digits, static_cast<size_t>(result.ptr - digits));
+        return *this;
+    }
+
+    ReportBuffer& operator<<(FixedPoint number);
+
+    const char* data() const { return text.data(); }
+    size_t size() const { return text.size(); }
+    bool empty() const { return text.empty(); }
+    void clear() { text.clear(); }
+    std::string_view view() const { return text; }
+};
+
+/**
+ * ReportWriter - Buffered report output to a stream or a file descriptor
+ * Reports are formatted into the writer's buffer and written out in blocks
+ * of about BLOCK_BYTES (at record boundaries) instead of one flush per
+ * line. A writer can be kept across pages so its buffer is reused.
+ *
+ * Not thread-safe; use one writer per thread. Writing to a descriptor
+ * bypasses stdio, so flush any FILE* or iostream sharing it first.
+ */
+class ReportWriter {
+public:
+    static constexpr size_t BLOCK_BYTES = 64 * 1024;
+
+private:
+    ReportBuffer buf;
+    std::ostream* stream = nullptr;
+    int fd = -1;
+    bool failed = false;
+    uint64_t written = 0;
+
+    // Hand the buffered text to the destination and empty the buffer
+    void drain();
+
+public:
+    /**
+     * Write through an iostream (flushed once per block and at the end)
+     * @param out Destination stream
+     */
+    explicit ReportWriter(std::ostream& out);
+
+    /**
+     * Write straight to a file descriptor with write(2)
+     * @param fileDescriptor Open descriptor; not closed by the writer
+     */
+    explicit ReportWriter(int fileDescriptor);
+
+    /**
+     * Flushes whatever is still buffered
+     */
+    ~ReportWriter();
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    ReportBuffer& buffer() { return buf; }
+
+    /**
+     * Mark the end of a record; writes the buffer out once it holds a full block
+     */
+    void endRecord() {
+        if (buf.size() >= BLOCK_BYTES) {
+            drain();
+        }
+    }
+
+    /**
+     * Write out everything buffered and flush the stream
+     * @return False if any write so far has failed
+     */
+    bool flush();
+
+    bool good() const { return !failed; }
+
+    /**
+     * Bytes handed to the destination so far (excluding the current buffer)
+     */
+    uint64_t bytesWritten() const { return written; }
+};
+
+template <typename T>
+ReportWriter& operator<<(ReportWriter& out, const T& value) {
+    out.buffer() << value;
+    return out;
+}
+
+/**
+ * Which rides of a history a report lists
+ * A page is an offset and limit into the history (in the order rides were
+ * added). Pages taken from a ReportCursor also carry the last ride already
+ * listed, so paging stays in step when earlier rides are cancelled between
+ * pages.
+ */
+struct ReportPage {
+    static constexpr size_t ALL = std::numeric_limits<size_t>::max();
+
+    size_t offset = 0;   // First ride listed, 0-based
+    size_t limit = ALL;  // Maximum rides listed
+    int afterRideID = 0; // Ride listed last on the previous page (0 = none; ride IDs start at 1)
+};
+
+/**
+ * Where a paged report stopped
+ */
+struct ReportCursor {
+    ReportPage next;    // Continues after the last ride listed, with the same limit
+    size_t listed = 0;  // Rides listed on this page
+    size_t total = 0;   // Rides in the history when the page was written
+
+    bool hasMore() const { return next.offset < total; }
+};
+
+/**
+ * Rows of a ride history selected by a page
+ */
+struct ReportRange {
+    size_t first; // Index of the first ride to list
+    size_t last;  // One past the last ride to list
+
+    /**
+     * Resolve a page against a history, re-anchoring on page.afterRideID
+     * when the rides before the offset have changed
+     * @param rideIDs Ride history
+     * @param page Requested page
+     */
+    ReportRange(const std::vector<int>& rideIDs, const ReportPage& page);
+
+    /**
+     * Cursor positioned after this range
+     * @param rideIDs Ride history the range was resolved against
+     * @param limit Page size of the following page
+     */
+    ReportCursor cursor(const std::vector<int>& rideIDs, size_t limit) const;
+};
+
+#endif // REPORT_H
@@ -1,66 +1,62 @@
 #include "Ride.h"
-
-// Static member definitions
-const double Ride::BASE_RATE = 2.5;
-const double PremiumRide::PREMIUM_MULTIPLIER = 1.8;
-const double EconomyRide::ECONOMY_DISCOUNT = 0.7;
+#include "Logger.h"
 
 // Base Ride class implementation
-Ride::Ride(int id, const std::string& pickup, const std::string& dropoff, double dist)
-    : rideID(id), pickupLocation(pickup), dropoffLocation(dropoff), distance(dist) {
-    std::cout << "[LOG] Created ride with ID: " << rideID << std::endl;
+Ride::Ride(int id, std::string_view pickup, std::string_view dropoff, double dist,
+           RideType rideType)
+    : rideID(id),
+      pickupID(LocationPool::global().intern(pickup)),
+      dropoffID(LocationPool::global().intern(dropoff)),
+      type(rideType),
+      hasPickup(false),
+      surgePercent(100),
+      distance(dist) {
+    LOG_INFO("Created ride with ID: " << rideID);
 }
 
 void Ride::rideDetails() const {
-    std::cout << "=== Ride Details ===" << std::endl;
-    std::cout << "Ride ID: " << rideID << std::endl;
-    std::cout << "From: " << pickupLocation << std::endl;
-    std::cout << "To: " << dropoffLocation << std::endl;
-    std::cout << "Distance: " << std::fixed << std::setprecision(2) << distance << " miles" << std::endl;
-    std::cout << "Fare: $" << std::fixed << std::setprecision(2) << fare() << std::endl;
+    ReportWriter out(std::cout);
+    writeDetails(out.buffer());
+}
+
+void Ride::writeDetails(ReportBuffer& out) const {
+    if (const RideTypeInfo* info = rideTypeInfo(type)) {
+        out << "Type: " << info->details << '\n';
+    }
+    out << "=== Ride Details ===\n";
+    out << "Ride ID: " << rideID << '\n';
+    out << "From: " << getPickupLocation() << '\n';
+    out << "To: " << getDropoffLocation() << '\n';
+    if (hasPickup) {
+        out << "Pickup Point: (" << fixed(pickupPoint.x, 2) << ", " << fixed(pickupPoint.y, 2) << ")\n";
+    }
+    out << "Distance: " << fixed(getDistance(), 2) << " miles\n";
+    if (surgePercent != 100) {
+        out << "Surge: " << fixed(getSurgeMultiplier(), 2) << "x\n";
+    }
+    out << "Fare: $" << fixed(computeFare(), 2) << '\n';
 }
 
 // StandardRide implementation
-StandardRide::StandardRide(int id, const std::string& pickup, const std::string& dropoff, double dist)
-    : Ride(id, pickup, dropoff, dist) {
-    std::cout << "[LOG] StandardRide created" << std::endl;
-}
-
-double StandardRide::fare() const {
-    return BASE_RATE * getDistance();
-}
-
-void StandardRide::rideDetails() const {
-    std::cout << "Type: Standard Ride" << std::endl;
-    Ride::rideDetails();
+StandardRide::StandardRide(int id, std::string_view pickup, std::string_view dropoff, double dist)
+    : Ride(id, pickup, dropoff, dist, TYPE) {
+    LOG_INFO("StandardRide created");
 }
 
 // PremiumRide implementation
-PremiumRide::PremiumRide(int id, const std::string& pickup, const std::string& dropoff, double dist)
-    : Ride(id, pickup, dropoff, dist) {
-    std::cout << "[LOG] PremiumRide created" << std::endl;
-}
-
-double PremiumRide::fare() const {
-    return BASE_RATE * getDistance() * PREMIUM_MULTIPLIER;
-}
-
-void PremiumRide::rideDetails() const {
-    std::cout << "Type: Premium Ride (Luxury vehicle, complimentary refreshments)" << std::endl;
-    Ride::rideDetails();
+PremiumRide::PremiumRide(int id, std::string_view pickup, std::string_view dropoff, double dist)
+    : Ride(id, pickup, dropoff, dist, TYPE) {
+    LOG_INFO("PremiumRide created");
 }
 
 // EconomyRide implementation
-EconomyRide::EconomyRide(int id, const std::string& pickup, const std::string& dropoff, double dist)
-    : Ride(id, pickup, dropoff, dist) {
-    std::cout << "[LOG] EconomyRide created" << std::endl;
-}
-
-double EconomyRide::fare() const {
-    return BASE_RATE * getDistance() * ECONOMY_DISCOUNT;
+EconomyRide::EconomyRide(int id, std::string_view pickup, std::string_view dropoff, double dist)
+    : Ride(id, pickup, dropoff, dist, TYPE) {
+    LOG_INFO("EconomyRide created");
 }
 
-void EconomyRide::rideDetails() const {
-    std::cout << "Type: Economy Ride (Budget-friendly option)" << std::endl;
-    Ride::rideDetails();
+std::shared_ptr<Ride> makeRide(RideType type, int id, std::string_view pickup,
+                               std::string_view dropoff, double dist) {
+    const RideTypeInfo* info = rideTypeInfo(type);
+    return info ? info->create(id, pickup, dropoff, dist) : nullptr;
 }
@@ -1,9 +1,57 @@
 #ifndef RIDE_H
 #define RIDE_H
 
+#include "LocationPool.h"
+#include "GeoPoint.h"
+#include "RidePool.h"
+#include "Report.h"
+#include <atomic>
+#include <cmath>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <iomanip>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Compact tag identifying the concrete ride type
+ * Built-in types form a closed set dispatched without virtual calls or RTTI;
+ * rides from extension subclasses carry the Custom tag. Each built-in tag
+ * has a row in RIDE_TYPES (below), in enumerator order; Custom stays last.
+ */
+enum class RideType : uint8_t {
+    Standard,
+    Premium,
+    Economy,
+    Custom
+};
+
+/**
+ * Number of built-in ride types (rows of RIDE_TYPES)
+ */
+constexpr size_t BUILTIN_RIDE_TYPE_COUNT = static_cast<size_t>(RideType::Custom);
+
+/**
+ * Number of ride type tags, including Custom (size of per-type tables)
+ */
+constexpr size_t RIDE_TYPE_COUNT = BUILTIN_RIDE_TYPE_COUNT + 1;
+
+/**
+ * How a ride type turns distance into a fare
+ * fare = max(rate * distance * multiplier, minimumFare), evaluated in that
+ * order so scalar, batch and vector pricing agree bit for bit
+ */
+struct FarePolicy {
+    double rate;        // Dollars per mile
+    double multiplier;  // Type premium or discount applied to rate * distance
+    double minimumFare; // Floor for short trips (0 = none)
+
+    constexpr double fareFor(double dist) const {
+        double fare = rate * dist * multiplier;
+        return fare < minimumFare ? minimumFare : fare;
+    }
+};
 
 /**
  * Base class representing a ride in the ride sharing system
@@ -12,23 +60,43 @@
 class Ride {
 private:
     int rideID;
-    std::string pickupLocation;
-    std::string dropoffLocation;
-    double distance;
-
-protected:
-    // Base fare rate accessible to derived classes
-    static const double BASE_RATE;
+    uint32_t pickupID;   // Interned in LocationPool::global()
+    uint32_t dropoffID;
+    RideType type;       // Packed next to the IDs to avoid padding
+    bool hasPickup;      // Set when the ride was matched from pickup coordinates
+    uint16_t surgePercent; // Surge multiplier quoted at creation, in percent (100 = none); fills padding
+    std::atomic<double> distance; // Atomic so re-pricing never tears concurrent reads
+    GeoPoint pickupPoint;
+    int64_t requestedAt = 0;              // Milliseconds since the Unix epoch, 0 if unknown
+    std::atomic<int64_t> completedAt{0};  // 0 while the ride is in progress
+    
+    // Re-pricing goes through the system so driver and rider totals stay in sync
+    friend class RideSharingSystem;
+    friend class RideStore; // Restores the quoted surge when rebuilding a ride from its row
+    void setDistance(double dist) { distance.store(dist, std::memory_order_relaxed); }
+    void setPickupPoint(GeoPoint point) { pickupPoint = point; hasPickup = true; }
+    void setSurgePercent(uint16_t percent) { surgePercent = percent; }
+    void setRequestedAt(int64_t at) { requestedAt = at; }
+    // Only the first completion counts
+    bool markCompleted(int64_t at) {
+        int64_t expected = 0;
+        return completedAt.compare_exchange_strong(expected, at);
+    }
 
 public:
+    // Base fare rate shared by all built-in ride types
+    static constexpr double BASE_RATE = 2.5;
+
     /**
      * Constructor to initialize a ride
      * @param id Unique identifier for the ride
      * @param pickup Starting location
      * @param dropoff Destination location
      * @param dist Distance in miles
+     * @param rideType Type tag (extension subclasses keep the Custom default)
      */
-    Ride(int id, const std::string& pickup, const std::string& dropoff, double dist);
+    Ride(int id, std::string_view pickup, std::string_view dropoff, double dist,
+         RideType rideType = RideType::Custom);
     
     /**
      * Virtual destructor for proper cleanup in inheritance hierarchy
@@ -42,16 +110,47 @@ public:
      */
     virtual double fare() const = 0;
     
+    /**
+     * Quoted fare: the type's fare() times the surge multiplier quoted when
+     * the ride was created. Built-in types compute inline through tag
+     * dispatch without a virtual call, Custom rides fall back to fare()
+     * @return fare() * getSurgeMultiplier()
+     */
+    double computeFare() const;
+    
+    /**
+     * Type tag of the concrete ride class
+     * @return RideType identifying this ride
+     */
+    RideType getType() const { return type; }
+    
     /**
      * Display ride information
+     * Built-in types print through writeDetails(); override to print more
      */
     virtual void rideDetails() const;
     
+    /**
+     * Format ride information into a report buffer (no virtual call)
+     * Built-in types get a "Type:" line from RIDE_TYPES, Custom rides none
+     * @param out Buffer to append to
+     */
+    void writeDetails(ReportBuffer& out) const;
+    
     // Getter methods - encapsulation in action
     int getRideID() const { return rideID; }
-    std::string getPickupLocation() const { return pickupLocation; }
-    std::string getDropoffLocation() const { return dropoffLocation; }
-    double getDistance() const { return distance; }
+    std::string_view getPickupLocation() const { return LocationPool::global().name(pickupID); }
+    std::string_view getDropoffLocation() const { return LocationPool::global().name(dropoffID); }
+    uint32_t getPickupID() const { return pickupID; }
+    uint32_t getDropoffID() const { return dropoffID; }
+    double getDistance() const { return distance.load(std::memory_order_relaxed); }
+    bool hasPickupPoint() const { return hasPickup; }
+    uint16_t getSurgePercent() const { return surgePercent; }
+    double getSurgeMultiplier() const { return surgePercent / 100.0; }
+    GeoPoint getPickupPoint() const { return pickupPoint; }
+    int64_t getRequestedAt() const { return requestedAt; }
+    int64_t getCompletedAt() const { return completedAt.load(std::memory_order_relaxed); }
+    bool isCompleted() const { return getCompletedAt() != 0; }
 };
 
 /**
@@ -60,18 +159,23 @@ public:
  */
 class StandardRide : public Ride {
 public:
-    StandardRide(int id, const std::string& pickup, const std::string& dropoff, double dist);
+    static constexpr RideType TYPE = RideType::Standard;
+    static constexpr FarePolicy POLICY = {BASE_RATE, 1.0, 0.0};
+    
+    StandardRide(int id, std::string_view pickup, std::string_view dropoff, double dist);
     
     /**
-     * Override fare calculation for standard rides
-     * @return Standard fare (base rate * distance)
+     * Fare policy for this type, usable without an object
+     * @param dist Distance in miles
+     * @return Fare for a ride of this type
      */
-    double fare() const override;
+    static constexpr double fareFor(double dist) { return POLICY.fareFor(dist); }
     
     /**
-     * Override ride details to show ride type
+     * Override fare calculation for standard rides
+     * @return Standard fare (base rate * distance)
      */
-    void rideDetails() const override;
+    double fare() const final { return fareFor(getDistance()); }
 };
 
 /**
@@ -79,22 +183,25 @@ public:
  * Demonstrates inheritance and polymorphism
  */
 class PremiumRide : public Ride {
-private:
-    static const double PREMIUM_MULTIPLIER;
-    
 public:
-    PremiumRide(int id, const std::string& pickup, const std::string& dropoff, double dist);
+    static constexpr double PREMIUM_MULTIPLIER = 1.8;
+    static constexpr RideType TYPE = RideType::Premium;
+    static constexpr FarePolicy POLICY = {BASE_RATE, PREMIUM_MULTIPLIER, 0.0};
+    
+    PremiumRide(int id, std::string_view pickup, std::string_view dropoff, double dist);
     
     /**
-     * Override fare calculation for premium rides
-     * @return Premium fare (base rate * distance * premium multiplier)
+     * Fare policy for this type, usable without an object
+     * @param dist Distance in miles
+     * @return Fare for a ride of this type
      */
-    double fare() const override;
+    static constexpr double fareFor(double dist) { return POLICY.fareFor(dist); }
     
     /**
-     * Override ride details to show ride type
+     * Override fare calculation for premium rides
+     * @return Premium fare (base rate * distance * premium multiplier)
      */
-    void rideDetails() const override;
+    double fare() const final { return fareFor(getDistance()); }
 };
 
 /**
@@ -102,22 +209,205 @@ public:
  * Demonstrates extensibility of the system
  */
 class EconomyRide : public Ride {
-private:
-    static const double ECONOMY_DISCOUNT;
-    
 public:
-    EconomyRide(int id, const std::string& pickup, const std::string& dropoff, double dist);
+    static constexpr double ECONOMY_DISCOUNT = 0.7;
+    static constexpr RideType TYPE = RideType::Economy;
+    static constexpr FarePolicy POLICY = {BASE_RATE, ECONOMY_DISCOUNT, 0.0};
+    
+    EconomyRide(int id, std::string_view pickup, std::string_view dropoff, double dist);
     
     /**
-     * Override fare calculation for economy rides
-     * @return Discounted fare for budget-conscious riders
+     * Fare policy for this type, usable without an object
+     * @param dist Distance in miles
+     * @return Fare for a ride of this type
      */
-    double fare() const override;
+    static constexpr double fareFor(double dist) { return POLICY.fareFor(dist); }
     
     /**
-     * Override ride details to show ride type
+     * Override fare calculation for economy rides
+     * @return Discounted fare for budget-conscious riders
      */
-    void rideDetails() const override;
+    double fare() const final { return fareFor(getDistance()); }
+};
+
+/**
+ * Pooled factory for one ride class, referenced from its RIDE_TYPES row
+ */
+template <typename T>
+std::shared_ptr<Ride> createPooledRide(int id, std::string_view pickup, std::string_view dropoff, double dist) {
+    return allocatePooled<T>(id, pickup, dropoff, dist);
+}
+
+/**
+ * Registry row of a built-in ride type
+ */
+struct RideTypeInfo {
+    RideType type;
+    std::string_view name;    // Name accepted at the API ("standard")
+    std::string_view label;   // Name shown in reports ("Standard")
+    std::string_view details; // Type line of ride details ("Standard Ride")
+    FarePolicy policy;
+    std::shared_ptr<Ride> (*create)(int id, std::string_view pickup, std::string_view dropoff, double dist);
+};
+
+/**
+ * Registry row for a ride class that declares TYPE and POLICY
+ */
+template <typename T>
+constexpr RideTypeInfo rideTypeRow(std::string_view name, std::string_view label, std::string_view details) {
+    return {T::TYPE, name, label, details, T::POLICY, &createPooledRide<T>};
+}
+
+/**
+ * Built-in ride types, indexed by RideType
+ * Adding a type takes an enumerator before Custom, a Ride subclass with
+ * TYPE and POLICY, and a row here; parsing, the factory, pricing (scalar
+ * and batch) and per-type reports all read this table.
+ */
+inline constexpr RideTypeInfo RIDE_TYPES[] = {
+    rideTypeRow<StandardRide>("standard", "Standard", "Standard Ride"),
+    rideTypeRow<PremiumRide>("premium", "Premium", "Premium Ride (Luxury vehicle, complimentary refreshments)"),
+    rideTypeRow<EconomyRide>("economy", "Economy", "Economy Ride (Budget-friendly option)"),
+};
+
+constexpr bool rideTypesInEnumOrder() {
+    for (size_t i = 0; i < BUILTIN_RIDE_TYPE_COUNT; ++i) {
+        if (static_cast<size_t>(RIDE_TYPES[i].type) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(sizeof(RIDE_TYPES) / sizeof(RIDE_TYPES[0]) == BUILTIN_RIDE_TYPE_COUNT,
+              "every built-in RideType needs exactly one RIDE_TYPES row");
+static_assert(rideTypesInEnumOrder(), "RIDE_TYPES rows must follow RideType order");
+
+/**
+ * Name lookup for RIDE_TYPES through a perfect hash built at compile time
+ * A seed is searched for that sends every name to its own slot, so a lookup
+ * is one hash, one table load and one string comparison.
+ */
+namespace RideTypeHash {
+
+constexpr size_t SLOTS = 8; // Power of two, at least twice the number of types
+
+constexpr uint32_t hash(std::string_view name, uint32_t seed) {
+    uint32_t value = 2166136261u ^ seed; // FNV-1a
+    for (char c : name) {
+        value = (value ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return value;
+}
+
+struct Table {
+    uint32_t seed = 0;
+    bool perfect = false;
+    uint8_t slots[SLOTS] = {}; // RIDE_TYPES index + 1, 0 = empty
 };
 
+constexpr Table build() {
+    for (uint32_t seed = 0; seed < 4096; ++seed) {
+        Table table;
+        table.seed = seed;
+        table.perfect = true;
+        for (size_t i = 0; i < BUILTIN_RIDE_TYPE_COUNT && table.perfect; ++i) {
+            uint8_t& slot = table.slots[hash(RIDE_TYPES[i].name, seed) & (SLOTS - 1)];
+            table.perfect = slot == 0;
+            slot = static_cast<uint8_t>(i + 1);
+        }
+        if (table.perfect) {
+            return table;
+        }
+    }
+    return Table();
+}
+
+inline constexpr Table TABLE = build();
+static_assert(SLOTS >= 2 * BUILTIN_RIDE_TYPE_COUNT && (SLOTS & (SLOTS - 1)) == 0,
+              "grow RideTypeHash::SLOTS with the number of ride types");
+static_assert(TABLE.perfect, "no collision-free seed for the ride type names; grow RideTypeHash::SLOTS");
+
+} // namespace RideTypeHash
+
+/**
+ * Find a built-in ride type by name
+ * @param name Type name ("standard", "premium", "economy", ...)
+ * @return Registry row, or nullptr if the name is unknown
+ */
+constexpr const RideTypeInfo* findRideType(std::string_view name) {
+    uint8_t entry = RideTypeHash::TABLE.slots[RideTypeHash::hash(name, RideTypeHash::TABLE.seed) &
+                                              (RideTypeHash::SLOTS - 1)];
+    if (entry == 0 || RIDE_TYPES[entry - 1].name != name) {
+        return nullptr;
+    }
+    return &RIDE_TYPES[entry - 1];
+}
+
+/**
+ * Registry row of a ride type
+ * @param type Ride type tag
+ * @return Registry row, or nullptr for Custom
+ */
+constexpr const RideTypeInfo* rideTypeInfo(RideType type) {
+    size_t index = static_cast<size_t>(type);
+    return index < BUILTIN_RIDE_TYPE_COUNT ? &RIDE_TYPES[index] : nullptr;
+}
+
+/**
+ * Name shown in reports for a ride type
+ * @param type Ride type tag
+ * @return Registry label, or "Custom"
+ */
+constexpr std::string_view rideTypeLabel(RideType type) {
+    size_t index = static_cast<size_t>(type);
+    return index < BUILTIN_RIDE_TYPE_COUNT ? RIDE_TYPES[index].label : std::string_view("Custom");
+}
+
+/**
+ * Fare of a built-in ride type computed from its distance
+ * Lets columnar code price rides without constructing Ride objects
+ * @param type Built-in ride type (Custom has no static policy)
+ * @param dist Distance in miles
+ * @return Fare, or 0.0 for Custom
+ */
+constexpr double rideFare(RideType type, double dist) {
+    // Indexed rather than through rideTypeInfo(): a pointer null check is not a
+    // constant expression when GCC instruments null checks (-fsanitize=undefined)
+    size_t index = static_cast<size_t>(type);
+    return index < BUILTIN_RIDE_TYPE_COUNT ? RIDE_TYPES[index].policy.fareFor(dist) : 0.0;
+}
+
+/**
+ * Longest ride distance the system accepts, in miles
+ * Far beyond any real trip, and small enough that every fare converts to
+ * integer micro-dollars without overflow
+ */
+constexpr double MAX_RIDE_DISTANCE = 1e6;
+
+/**
+ * Whether a distance can be priced (finite, non-negative, at most MAX_RIDE_DISTANCE)
+ * @param dist Distance in miles
+ * @return True if rides may be created or re-priced with it
+ */
+inline bool isValidDistance(double dist) {
+    return std::isfinite(dist) && dist >= 0.0 && dist <= MAX_RIDE_DISTANCE;
+}
+
+inline double Ride::computeFare() const {
+    double base = (type == RideType::Custom) ? fare() : rideFare(type, getDistance());
+    return base * getSurgeMultiplier(); // Exact for the default 1.0
+}
+
+/**
+ * Factory for the built-in ride types
+ * @param type Ride type tag
+ * @param id Unique identifier for the ride
+ * @param pickup Starting location
+ * @param dropoff Destination location
+ * @param dist Distance in miles
+ * @return Newly constructed ride (allocated from its type's pool), or nullptr for Custom
+ */
+std::shared_ptr<Ride> makeRide(RideType type, int id, std::string_view pickup,
+                               std::string_view dropoff, double dist);
+
 #endif // RIDE_H
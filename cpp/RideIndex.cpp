@@ -0,0 +1,330 @@
+#include "RideIndex.h"
+#include "LocationPool.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace {
+
+const std::vector<int> NO_RIDES;
+
+template <typename List>
+List& slotFor(std::vector<List>& lists, size_t key) {
+    if (key >= lists.size()) {
+        lists.resize(std::max(key + 1, lists.size() * 2));
+    }
+    return lists[key];
+}
+
+void addPosting(std::vector<int>& postings, int rideID) {
+    // Rides normally arrive in ID order; a concurrent dispatcher can commit slightly out of order
+    if (postings.empty() || postings.back() < rideID) {
+        postings.push_back(rideID);
+    } else {
+        postings.insert(std::lower_bound(postings.begin(), postings.end(), rideID), rideID);
+    }
+}
+
+void erasePosting(std::vector<std::vector<int>>& lists, size_t key, int rideID) {
+    if (key >= lists.size()) {
+        return;
+    }
+    std::vector<int>& postings = lists[key];
+    auto it = std::lower_bound(postings.begin(), postings.end(), rideID);
+    if (it != postings.end() && *it == rideID) {
+        postings.erase(it);
+    }
+}
+
+const std::vector<int>& postingsFor(const std::vector<std::vector<int>>& lists, size_t key) {
+    return key < lists.size() ? lists[key] : NO_RIDES;
+}
+
+/**
+ * Advance a cursor to the first posting >= rideID by galloping search
+ * Candidates arrive in ascending order, so each list is walked once and a
+ * short list intersected with a long one skips most of it
+ * @return True if the posting at the cursor is rideID
+ */
+bool advanceTo(const std::vector<int>& postings, size_t& pos, int rideID) {
+    size_t step = 1;
+    size_t low = pos;
+    while (pos + step < postings.size() && postings[pos + step] < rideID) {
+        low = pos + step;
+        step *= 2;
+    }
+    size_t high = std::min(pos + step + 1, postings.size());
+    pos = static_cast<size_t>(std::lower_bound(postings.begin() + low, postings.begin() + high, rideID) -
+                              postings.begin());
+    return pos < postings.size() && postings[pos] == rideID;
+}
+
+bool testBit(const std::vector<uint64_t>& bits, int rideID) {
+    size_t word = static_cast<size_t>(rideID) >> 6;
+    return word < bits.size() && (bits[word] >> (rideID & 63) & 1);
+}
+
+} // namespace
+
+// DistanceIndex implementation
+
+size_t DistanceIndex::countInRange(double minDistance, double maxDistance) const {
+    if (!(minDistance <= maxDistance)) {
+        return 0;
+    }
+    return keys.countBefore({maxDistance, INT_MAX}) - keys.countBefore({minDistance, INT_MIN});
+}
+
+void DistanceIndex::collect(double minDistance, double maxDistance, std::vector<int>& out) const {
+    if (!(minDistance <= maxDistance)) {
+        return;
+    }
+    keys.collect({minDistance, INT_MIN}, [&](const DistanceKey& key) {
+        if (key.distance > maxDistance) {
+            return false;
+        }
+        out.push_back(key.rideID);
+        return true;
+    });
+}
+
+// RideIndex implementation
+
+void RideIndex::add(int rideID, RideType type, double distance, uint32_t pickupID, uint32_t dropoffID,
+                    int driverID, int riderID) {
+    addPosting(slotFor(byPickup, pickupID), rideID);
+    addPosting(slotFor(byDropoff, dropoffID), rideID);
+    addPosting(slotFor(byDriver, static_cast<size_t>(driverID)), rideID);
+    addPosting(slotFor(byRider, static_cast<size_t>(riderID)), rideID);
+    size_t t = static_cast<size_t>(type);
+    slotFor(typeBits[t], static_cast<size_t>(rideID) >> 6) |= uint64_t(1) << (rideID & 63);
+    typeCounts[t]++;
+    slotFor(distanceByID, static_cast<size_t>(rideID)) = distance;
+}
+
+void RideIndex::build(const RideStore& store) {
+    reset();
+    const std::vector<int>& rideIDs = store.getRideIDs();
+    const std::vector<RideType>& types = store.getTypes();
+    const std::vector<double>& rideDistances = store.getDistances();
+    if (!rideIDs.empty()) {
+        distanceByID.resize(static_cast<size_t>(rideIDs.back()) + 1); // Rows are in ID order
+    }
+    std::vector<DistanceIndex::Key> keys;
+    keys.reserve(rideIDs.size());
+    for (size_t row = 0; row < rideIDs.size(); ++row) {
+        add(rideIDs[row], types[row], rideDistances[row], store.getPickupIDs()[row], store.getDropoffIDs()[row],
+            store.getDriverIDs()[row], store.getRiderIDs()[row]);
+        if (!std::isnan(rideDistances[row])) {
+            keys.push_back({rideDistances[row], rideIDs[row]});
+        }
+    }
+    distances.assign(std::move(keys));
+    built = true;
+}
+
+void RideIndex::reset() {
+    built = false;
+    byPickup.clear();
+    byDropoff.clear();
+    byDriver.clear();
+    byRider.clear();
+    distances.clear();
+    for (size_t t = 0; t < RIDE_TYPE_COUNT; ++t) {
+        typeBits[t].clear();
+        typeCounts[t] = 0;
+    }
+    distanceByID.clear();
+}
+
+void RideIndex::insert(const RideStore& store, size_t row) {
+    if (!built) {
+        return;
+    }
+    int rideID = store.getRideIDs()[row];
+    double distance = store.getDistances()[row];
+    add(rideID, store.getTypes()[row], distance, store.getPickupIDs()[row], store.getDropoffIDs()[row],
+        store.getDriverIDs()[row], store.getRiderIDs()[row]);
+    if (!std::isnan(distance)) { // NaN has no place in the order and matches no distance range
+        distances.insert(distance, rideID);
+    }
+}
+
+void RideIndex::erase(const RideStore& store, size_t row) {
+    if (!built) {
+        return;
+    }
+    int rideID = store.getRideIDs()[row];
+    erasePosting(byPickup, store.getPickupIDs()[row], rideID);
+    erasePosting(byDropoff, store.getDropoffIDs()[row], rideID);
+    erasePosting(byDriver, static_cast<size_t>(store.getDriverIDs()[row]), rideID);
+    erasePosting(byRider, static_cast<size_t>(store.getRiderIDs()[row]), rideID);
+    size_t t = static_cast<size_t>(store.getTypes()[row]);
+    if (testBit(typeBits[t], rideID)) {
+        typeBits[t][static_cast<size_t>(rideID) >> 6] &= ~(uint64_t(1) << (rideID & 63));
+        typeCounts[t]--;
+    }
+    distances.erase(store.getDistances()[row], rideID);
+}
+
+void RideIndex::updateDistance(const RideStore& store, size_t row, double newDistance) {
+    if (!built) {
+        return;
+    }
+    int rideID = store.getRideIDs()[row];
+    distances.erase(store.getDistances()[row], rideID);
+    if (!std::isnan(newDistance)) {
+        distances.insert(newDistance, rideID);
+    }
+    distanceByID[static_cast<size_t>(rideID)] = newDistance;
+}
+
+RideQueryResult RideIndex::query(const RideQuery& query, const RideStore& store) {
+    if (!built) {
+        build(store);
+    }
+    RideQueryResult result;
+
+    const uint32_t allTypes = (1u << RIDE_TYPE_COUNT) - 1;
+    const uint32_t types = query.types == 0 ? allTypes : query.types & allTypes;
+    const bool byType = types != allTypes;
+    const bool byDistance = query.minDistance > -std::numeric_limits<double>::infinity() ||
+                            query.maxDistance < std::numeric_limits<double>::infinity();
+    if (types == 0 || query.limit == 0 || (byDistance && !(query.minDistance <= query.maxDistance))) {
+        return result;
+    }
+
+    // Posting list predicates; a location nobody has used matches nothing
+    struct Predicate {
+        const std::vector<int>* postings;
+        RideAccessPath path;
+        size_t cursor;
+    };
+    std::vector<Predicate> predicates;
+    predicates.reserve(4);
+    auto location = [&](const std::string& name, const std::vector<std::vector<int>>& lists,
+                        RideAccessPath path) {
+        uint32_t id;
+        bool known = LocationPool::global().find(name, id);
+        predicates.push_back({known ? &postingsFor(lists, id) : &NO_RIDES, path, 0});
+    };
+    if (!query.pickup.empty()) {
+        location(query.pickup, byPickup, RideAccessPath::Pickup);
+    }
+    if (!query.dropoff.empty()) {
+        location(query.dropoff, byDropoff, RideAccessPath::Dropoff);
+    }
+    if (query.driverID != 0) {
+        predicates.push_back({query.driverID > 0 ? &postingsFor(byDriver, static_cast<size_t>(query.driverID))
+                                                 : &NO_RIDES,
+                              RideAccessPath::Driver, 0});
+    }
+    if (query.riderID != 0) {
+        predicates.push_back({query.riderID > 0 ? &postingsFor(byRider, static_cast<size_t>(query.riderID))
+                                                : &NO_RIDES,
+                              RideAccessPath::Rider, 0});
+    }
+
+    // Plan: drive from whichever index yields the fewest rides
+    size_t typeEstimate = 0;
+    for (size_t t = 0; t < RIDE_TYPE_COUNT; ++t) {
+        if (types >> t & 1) {
+            typeEstimate += typeCounts[t];
+        }
+    }
+    result.path = RideAccessPath::TypeBitmap;
+    size_t estimate = typeEstimate;
+    size_t driver = predicates.size(); // Driving predicate, if a posting list wins
+    for (size_t i = 0; i < predicates.size(); ++i) {
+        size_t size = predicates[i].postings->size();
+        // On a tie a posting list beats the bitmaps: it is read without scanning words
+        if (size < estimate || (size == estimate && result.path == RideAccessPath::TypeBitmap)) {
+            estimate = size;
+            result.path = predicates[i].path;
+            driver = i;
+        }
+    }
+    if (byDistance) {
+        size_t inRange = distances.countInRange(query.minDistance, query.maxDistance);
+        if (inRange < estimate) {
+            estimate = inRange;
+            result.path = RideAccessPath::Distance;
+            driver = predicates.size();
+        }
+    }
+    if (estimate == 0) {
+        result.path = RideAccessPath::None;
+        return result;
+    }
+
+    // Check one candidate (ascending ID) against every predicate but the driving one
+    auto matches = [&](int rideID) {
+        for (size_t i = 0; i < predicates.size(); ++i) {
+            if (i != driver && !advanceTo(*predicates[i].postings, predicates[i].cursor, rideID)) {
+                return false;
+            }
+        }
+        if (byType && result.path != RideAccessPath::TypeBitmap) {
+            bool typed = false;
+            for (size_t t = 0; t < RIDE_TYPE_COUNT && !typed; ++t) {
+                typed = (types >> t & 1) && testBit(typeBits[t], rideID);
+            }
+            if (!typed) {
+                return false;
+            }
+        }
+        if (byDistance && result.path != RideAccessPath::Distance) {
+            double distance = distanceByID[static_cast<size_t>(rideID)];
+            if (!(distance >= query.minDistance && distance <= query.maxDistance)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (result.path == RideAccessPath::TypeBitmap) {
+        size_t words = 0;
+        for (size_t t = 0; t < RIDE_TYPE_COUNT; ++t) {
+            if (types >> t & 1) {
+                words = std::max(words, typeBits[t].size());
+            }
+        }
+        for (size_t word = 0; word < words; ++word) {
+            uint64_t bits = 0;
+            for (size_t t = 0; t < RIDE_TYPE_COUNT; ++t) {
+                if ((types >> t & 1) && word < typeBits[t].size()) {
+                    bits |= typeBits[t][word];
+                }
+            }
+            for (; bits != 0; bits &= bits - 1) {
+                int rideID = static_cast<int>(word * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+                result.candidates++;
+                if (matches(rideID)) {
+                    result.rideIDs.push_back(rideID);
+                    if (result.rideIDs.size() == query.limit) {
+                        return result;
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    std::vector<int> ranged;
+    const std::vector<int>* candidates = driver < predicates.size() ? predicates[driver].postings : &ranged;
+    if (result.path == RideAccessPath::Distance) {
+        ranged.reserve(estimate);
+        distances.collect(query.minDistance, query.maxDistance, ranged);
+        std::sort(ranged.begin(), ranged.end());
+    }
+    for (int rideID : *candidates) {
+        result.candidates++;
+        if (matches(rideID)) {
+            result.rideIDs.push_back(rideID);
+            if (result.rideIDs.size() == query.limit) {
+                break;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,205 @@
+#ifndef RIDE_INDEX_H
+#define RIDE_INDEX_H
+
+#include "BlockedOrderedList.h"
+#include "Ride.h"
+#include "RideStore.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * Filter over rides; every predicate left at its default matches all rides
+ */
+struct RideQuery {
+    static constexpr size_t ALL = std::numeric_limits<size_t>::max();
+
+    uint32_t types = 0; // One bit per RideType (see type()), 0 = any type
+    double minDistance = -std::numeric_limits<double>::infinity(); // Inclusive, in miles
+    double maxDistance = std::numeric_limits<double>::infinity();  // Inclusive, in miles
+    std::string pickup;  // Exact location name, empty = any
+    std::string dropoff; // Exact location name, empty = any
+    int driverID = 0;    // 0 = any driver (IDs start at 1)
+    int riderID = 0;     // 0 = any rider (IDs start at 1)
+    size_t limit = ALL;  // Maximum rides returned (the lowest ride IDs)
+
+    /**
+     * Also accept rides of a type
+     * @param type Ride type
+     * @return This query, for chaining
+     */
+    RideQuery& type(RideType type) {
+        types |= 1u << static_cast<unsigned>(type);
+        return *this;
+    }
+};
+
+/**
+ * Index a query was answered from
+ */
+enum class RideAccessPath : uint8_t {
+    TypeBitmap, // Per-type bitmaps (also used when nothing narrower applies)
+    Distance,   // Sorted distance index
+    Pickup,     // Pickup location postings
+    Dropoff,    // Dropoff location postings
+    Driver,     // Driver postings
+    Rider,      // Rider postings
+    None        // A predicate matches nothing (unknown location, empty range)
+};
+
+/**
+ * Query answer with the plan that produced it
+ */
+struct RideQueryResult {
+    std::vector<int> rideIDs;                     // Matching rides, ascending ID
+    RideAccessPath path = RideAccessPath::None;   // Index the planner drove the query from
+    size_t candidates = 0;                        // Rides read from that index
+};
+
+/**
+ * Position of a ride in the distance index
+ */
+struct DistanceKey {
+    double distance;
+    int rideID;
+};
+
+/**
+ * Distance order: shortest first, with ties broken by the lower ride ID
+ */
+struct DistanceBefore {
+    bool operator()(const DistanceKey& a, const DistanceKey& b) const {
+        return a.distance < b.distance || (a.distance == b.distance && a.rideID < b.rideID);
+    }
+};
+
+/**
+ * DistanceIndex - Ride IDs ordered by distance
+ * A BlockedOrderedList of (distance, ride ID) keys, so the number of rides
+ * in a distance range is O(log n) and listing them is O(log n + k).
+ */
+class DistanceIndex {
+public:
+    using Key = DistanceKey;
+
+private:
+    BlockedOrderedList<DistanceKey, DistanceBefore> keys;
+
+public:
+    /**
+     * Replace the contents (keys need not be sorted)
+     * @param rides Keys to index
+     */
+    void assign(std::vector<Key> rides) { keys.assign(std::move(rides)); }
+
+    void insert(double distance, int rideID) { keys.insert({distance, rideID}); }
+
+    /**
+     * @return True if the key was present
+     */
+    bool erase(double distance, int rideID) { return keys.erase({distance, rideID}); }
+
+    /**
+     * Number of rides with minDistance <= distance <= maxDistance
+     */
+    size_t countInRange(double minDistance, double maxDistance) const;
+
+    /**
+     * Ride IDs with minDistance <= distance <= maxDistance, by distance
+     * @param out Receives the ride IDs (appended)
+     */
+    void collect(double minDistance, double maxDistance, std::vector<int>& out) const;
+
+    size_t size() const { return keys.size(); }
+    void clear() { keys.clear(); }
+};
+
+/**
+ * RideIndex - Secondary indexes for filtering rides
+ * Keeps, by ride ID:
+ * - posting lists (sorted ride IDs) per pickup location, dropoff location,
+ *   driver and rider
+ * - the rides ordered by distance (DistanceIndex)
+ * - one bitmap per ride type, plus the distance of every ride for checks
+ *
+ * A query asks each applicable index how many rides it would produce (all
+ * O(1) except the distance range, O(log n)), drives the query from the
+ * smallest, intersects the other posting lists with it by galloping search
+ * and checks type and distance per remaining ride. Cost follows the most
+ * selective predicate rather than the number of rides.
+ *
+ * The index is built from the ride store on the first query, so systems
+ * that never query pay nothing; after that every change is applied as it
+ * happens. Not synchronized - RideSharingSystem guards it with its ride
+ * log lock, like the store it mirrors.
+ */
+class RideIndex {
+private:
+    using Postings = std::vector<int>; // Ride IDs, ascending
+
+    bool built = false;
+    std::vector<Postings> byPickup;  // Indexed by LocationPool::global() ID
+    std::vector<Postings> byDropoff; // Indexed by LocationPool::global() ID
+    std::vector<Postings> byDriver;  // Indexed by driver ID
+    std::vector<Postings> byRider;   // Indexed by rider ID
+    DistanceIndex distances;
+    std::vector<uint64_t> typeBits[RIDE_TYPE_COUNT]; // Bit per ride ID
+    size_t typeCounts[RIDE_TYPE_COUNT] = {};
+    std::vector<double> distanceByID; // Distance of each indexed ride, by ride ID
+
+    void add(int rideID, RideType type, double distance, uint32_t pickupID, uint32_t dropoffID, int driverID,
+             int riderID);
+
+public:
+    /**
+     * Whether the index has been built (and is being maintained)
+     */
+    bool isBuilt() const { return built; }
+
+    /**
+     * Index every ride in a store, replacing the current contents
+     * @param store Ride store to index
+     */
+    void build(const RideStore& store);
+
+    /**
+     * Forget the contents; the next query builds the index again
+     * Used when the store is replaced wholesale (snapshot load)
+     */
+    void reset();
+
+    /**
+     * Index a ride just appended to the store (no-op before the first build)
+     * @param store Ride store
+     * @param row Row of the new ride
+     */
+    void insert(const RideStore& store, size_t row);
+
+    /**
+     * Drop a ride about to be erased from the store (no-op before the first build)
+     * @param store Ride store
+     * @param row Row of the ride
+     */
+    void erase(const RideStore& store, size_t row);
+
+    /**
+     * Move a ride in the distance index before its row is re-priced (no-op before the first build)
+     * @param store Ride store, still holding the old distance
+     * @param row Row of the ride
+     * @param newDistance Distance about to be stored
+     */
+    void updateDistance(const RideStore& store, size_t row, double newDistance);
+
+    /**
+     * Rides matching every predicate of a query
+     * Builds the index from the store first if needed
+     * @param query Filter
+     * @param store Ride store the index mirrors
+     * @return Matching ride IDs in ascending order, with the chosen plan
+     */
+    RideQueryResult query(const RideQuery& query, const RideStore& store);
+};
+
+#endif // RIDE_INDEX_H
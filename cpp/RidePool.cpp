@@ -0,0 +1,80 @@
+#include "RidePool.h"
+#include <algorithm>
+
+namespace {
+
+const size_t MAX_CHUNK_BLOCKS = 64 * 1024;
+
+std::mutex& registryMutex() {
+    static std::mutex* mutex = new std::mutex;
+    return *mutex;
+}
+
+std::vector<FixedPool*>& registry() {
+    static std::vector<FixedPool*>* pools = new std::vector<FixedPool*>;
+    return *pools;
+}
+
+} // namespace
+
+FixedPool::FixedPool(size_t size, size_t alignment)
+    : blockSize((std::max(size, sizeof(FreeBlock)) + alignment - 1) / alignment * alignment) {
+    static_assert(alignof(FreeBlock) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "free list must fit any block");
+}
+
+FixedPool::~FixedPool() {
+    for (void* chunk : chunks) {
+        ::operator delete(chunk);
+    }
+}
+
+void* FixedPool::allocate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    liveBlocks++;
+    if (freeList) {
+        FreeBlock* block = freeList;
+        freeList = block->next;
+        return block;
+    }
+    if (cursor == chunkEnd) {
+        // Chunks grow geometrically so small systems stay small and large ones need few chunks
+        size_t bytes = nextChunkBlocks * blockSize;
+        cursor = static_cast<char*>(::operator new(bytes));
+        chunkEnd = cursor + bytes;
+        chunks.push_back(cursor);
+        reservedBytes += bytes;
+        nextChunkBlocks = std::min(nextChunkBlocks * 2, MAX_CHUNK_BLOCKS);
+    }
+    void* block = cursor;
+    cursor += blockSize;
+    return block;
+}
+
+void FixedPool::deallocate(void* block) {
+    std::lock_guard<std::mutex> lock(mutex);
+    liveBlocks--;
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    freed->next = freeList;
+    freeList = freed;
+}
+
+void FixedPool::addStats(PoolStats& stats) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.liveBlocks += liveBlocks;
+    stats.reservedBytes += reservedBytes;
+    stats.chunks += chunks.size();
+}
+
+void registerRidePool(FixedPool* pool) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry().push_back(pool);
+}
+
+PoolStats ridePoolStats() {
+    PoolStats stats;
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const FixedPool* pool : registry()) {
+        pool->addStats(stats);
+    }
+    return stats;
+}
@@ -0,0 +1,135 @@
+#ifndef RIDE_POOL_H
+#define RIDE_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * Memory held by the ride pools, for reports and gauges
+ */
+struct PoolStats {
+    size_t liveBlocks = 0;    // Blocks handed out and not yet returned
+    size_t reservedBytes = 0; // Chunk memory obtained from the heap
+    size_t chunks = 0;        // Heap allocations behind reservedBytes
+};
+
+/**
+ * FixedPool - Allocator for blocks of a single size
+ * Blocks are carved from large chunks (growing from 256 to 64K blocks), so
+ * a million rides take a few dozen heap allocations instead of a million,
+ * sit densely with no per-block malloc header, and freed blocks are reused
+ * through an intrusive free list. Chunk memory is only given back when the
+ * pool is destroyed; the ride pools never are (see poolFor).
+ */
+class FixedPool {
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    const size_t blockSize;
+    size_t nextChunkBlocks = 256;
+    FreeBlock* freeList = nullptr;
+    char* cursor = nullptr;   // Next never-used block of the newest chunk
+    char* chunkEnd = nullptr;
+    std::vector<void*> chunks;
+    size_t reservedBytes = 0;
+    size_t liveBlocks = 0;
+    mutable std::mutex mutex;
+
+public:
+    /**
+     * @param size Block size in bytes (rounded up to keep blocks aligned)
+     * @param alignment Required block alignment, at most the default new alignment
+     */
+    FixedPool(size_t size, size_t alignment);
+    ~FixedPool();
+    FixedPool(const FixedPool&) = delete;
+    FixedPool& operator=(const FixedPool&) = delete;
+
+    void* allocate();
+    void deallocate(void* block);
+
+    /**
+     * Add this pool's usage to a running total
+     */
+    void addStats(PoolStats& stats) const;
+};
+
+/**
+ * Register a pool so ridePoolStats() includes it
+ */
+void registerRidePool(FixedPool* pool);
+
+/**
+ * Usage summed over every ride pool in the process
+ */
+PoolStats ridePoolStats();
+
+/**
+ * Process-wide pool for objects of type T
+ * One pool per type keeps each size class dense (type-segregated). The pool
+ * is deliberately never destroyed: rides may be released by other static
+ * objects during shutdown, after a function-local static would be gone.
+ */
+template <typename T>
+FixedPool& poolFor() {
+    static FixedPool* pool = [] {
+        auto* created = new FixedPool(sizeof(T), alignof(T));
+        registerRidePool(created);
+        return created;
+    }();
+    return *pool;
+}
+
+/**
+ * PoolAllocator - Standard allocator drawing single objects from poolFor<T>()
+ * Meant for std::allocate_shared, which rebinds it to its combined control
+ * block so the reference counts and the ride share one pooled block.
+ * Array allocations fall back to the global heap.
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n == 1) {
+            return static_cast<T*>(poolFor<T>().allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        if (n == 1) {
+            poolFor<T>().deallocate(ptr);
+        } else {
+            ::operator delete(ptr);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+/**
+ * Create a shared object whose control block and body come from its type's pool
+ * @param args Constructor arguments
+ * @return Shared pointer released back into the pool
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> allocatePooled(Args&&... args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+#endif // RIDE_POOL_H
@@ -1,132 +1,1362 @@
 #include "RideSharingSystem.h"
+#include "Logger.h"
+#include "FareKernel.h"
 #include <iostream>
 #include <iomanip>
+#include <unordered_map>
 #include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace {
+
+JournalEvent changeEvent(JournalEventType type, int id, double value) {
+    JournalEvent event;
+    event.type = type;
+    event.id = id;
+    event.value = value;
+    return event;
+}
+
+JournalEvent rideEvent(const Ride& ride, int driverID, int riderID) {
+    JournalEvent event = changeEvent(JournalEventType::CreateRide, ride.getRideID(), ride.getDistance());
+    event.rideType = ride.getType();
+    event.pickup = ride.getPickupLocation();
+    event.dropoff = ride.getDropoffLocation();
+    event.driverID = driverID;
+    event.riderID = riderID;
+    event.hasPoint = ride.hasPickupPoint();
+    event.point = ride.getPickupPoint();
+    event.surgePercent = ride.getSurgePercent();
+    return event;
+}
+
+} // namespace
 
 RideSharingSystem::RideSharingSystem() 
-    : nextRideID(1), nextDriverID(1), nextRiderID(1) {
-    std::cout << "[LOG] Ride Sharing System initialized" << std::endl;
+    : nextRideID(1), nextDriverID(1), nextRiderID(1),
+      metrics("ridesharing_"),
+      ridesCreated(metrics.counter("rides_created", "Rides created and assigned")),
+      rideRequestsRejected(metrics.counter("ride_requests_rejected",
+                                           "Ride requests refused (unknown type, invalid input "
+                                           "or missing driver or rider)")),
+      ridesRepriced(metrics.counter("rides_repriced", "Rides re-priced after creation")),
+      ridesCancelled(metrics.counter("rides_cancelled", "Rides cancelled")),
+      ridesCompleted(metrics.counter("rides_completed", "Rides completed")),
+      ridesSurged(metrics.counter("rides_surged", "Rides quoted above the base fare")),
+      journalCommitFailures(metrics.counter("journal_commit_failures",
+                                            "Changes applied in memory but not made durable by the journal")),
+      createRideLatency(metrics.histogram("create_ride", "createRide latency")),
+      createRidesLatency(metrics.histogram("create_rides_batch", "createRides latency per batch")),
+      findDriverLatency(metrics.histogram("find_driver", "findDriver latency")),
+      findRiderLatency(metrics.histogram("find_rider", "findRider latency")),
+      statsLatency(metrics.histogram("stats_query", "Statistics query latency")) {
+    metrics.gauge("rides", "Rides in the log", [this]() {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        return static_cast<double>(rideStore.size());
+    });
+    metrics.gauge("drivers", "Registered drivers", [this]() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        return static_cast<double>(drivers.size() + snapshotDriversPending);
+    });
+    metrics.gauge("riders", "Registered riders", [this]() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        return static_cast<double>(riders.size() + snapshotRidersPending);
+    });
+    metrics.gauge("resident_memory_bytes", "Resident memory of the process",
+                  []() { return static_cast<double>(residentMemoryBytes()); });
+    metrics.gauge("ride_pool_bytes", "Memory reserved by the ride object pools",
+                  []() { return static_cast<double>(ridePoolStats().reservedBytes); });
+    LOG_INFO("Ride Sharing System initialized");
 }
 
-Driver* RideSharingSystem::addDriver(const std::string& name, double rating) {
-    auto driver = std::make_unique<Driver>(nextDriverID++, name, rating);
+Driver* RideSharingSystem::registerDriver(int id, const std::string& name, double rating) {
+    auto driver = std::make_unique<Driver>(id, name, rating, &rides);
+    driver->setLeaderboard(&leaderboard);
     Driver* ptr = driver.get();
-    drivers.push_back(std::move(driver));
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        drivers.push_back(std::move(driver));
+    }
+    driverIndex.insert(id, ptr);
     return ptr;
 }
 
-Rider* RideSharingSystem::addRider(const std::string& name, const std::string& paymentMethod) {
-    auto rider = std::make_unique<Rider>(nextRiderID++, name, paymentMethod);
+Rider* RideSharingSystem::registerRider(int id, const std::string& name, const std::string& paymentMethod) {
+    auto rider = std::make_unique<Rider>(id, name, paymentMethod, &rides);
     Rider* ptr = rider.get();
-    riders.push_back(std::move(rider));
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        riders.push_back(std::move(rider));
+    }
+    riderIndex.insert(id, ptr);
     return ptr;
 }
 
+Driver* RideSharingSystem::addDriver(const std::string& name, double rating) {
+    return createDriver(name, rating, nullptr);
+}
+
+Driver* RideSharingSystem::addDriver(const std::string& name, double rating, GeoPoint location) {
+    return createDriver(name, rating, &location);
+}
+
+Driver* RideSharingSystem::createDriver(const std::string& name, double rating, const GeoPoint* location) {
+    if (location && !isFinite(*location)) {
+        LOG_ERROR("Cannot place driver " << name << " at a non-finite location");
+        return nullptr;
+    }
+    int id = nextDriverID++;
+    // Journaled before the driver is visible, so no ride record can precede it
+    uint64_t sequence = 0;
+    if (journal) {
+        JournalEvent event = changeEvent(JournalEventType::AddDriver, id, rating);
+        event.name = name;
+        event.hasPoint = location != nullptr;
+        event.point = location ? *location : GeoPoint();
+        sequence = journal->append(event);
+    }
+    Driver* driver = registerDriver(id, name, rating);
+    if (location) {
+        updateDriverLocation(id, *location);
+    }
+    commitToJournal(sequence);
+    return driver;
+}
+
+Rider* RideSharingSystem::addRider(const std::string& name, const std::string& paymentMethod) {
+    int id = nextRiderID++;
+    uint64_t sequence = 0;
+    if (journal) {
+        JournalEvent event = changeEvent(JournalEventType::AddRider, id, 0.0);
+        event.name = name;
+        event.paymentMethod = paymentMethod;
+        sequence = journal->append(event);
+    }
+    Rider* rider = registerRider(id, name, paymentMethod);
+    commitToJournal(sequence);
+    return rider;
+}
+
+bool RideSharingSystem::updateDriverRating(int driverID, double newRating) {
+    Driver* driver = findDriver(driverID);
+    if (!driver) {
+        LOG_ERROR("Cannot rate unknown driver ID: " << driverID);
+        return false;
+    }
+    uint64_t sequence = 0;
+    {
+        // The journal stores the resulting rating, so records must follow the update order
+        std::lock_guard<std::mutex> lock(ratingMutex);
+        if (!driver->updateRating(newRating)) {
+            return false;
+        }
+        if (journal) {
+            sequence = journal->append(changeEvent(JournalEventType::UpdateRating, driverID, driver->getRating()));
+        }
+    }
+    commitToJournal(sequence);
+    return true;
+}
+
+bool RideSharingSystem::updateDriverLocation(int driverID, GeoPoint location) {
+    Driver* driver = findDriver(driverID);
+    if (!driver) {
+        LOG_ERROR("Cannot move unknown driver ID: " << driverID);
+        return false;
+    }
+    if (!isFinite(location)) {
+        LOG_ERROR("Cannot move driver ID " << driverID << " to a non-finite location");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(dispatchMutex);
+    driver->setLocation(location);
+    if (driver->isAvailable()) {
+        driverGrid.update(driverID, location);
+        surge.setDriverIdle(driverID, location);
+    }
+    return true;
+}
+
+bool RideSharingSystem::setDriverAvailable(int driverID, bool available) {
+    Driver* driver = findDriver(driverID);
+    if (!driver) {
+        LOG_ERROR("Cannot update availability of unknown driver ID: " << driverID);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(dispatchMutex);
+    driver->setAvailable(available);
+    GeoPoint location;
+    if (available && driver->getLocation(location)) {
+        driverGrid.update(driverID, location);
+        surge.setDriverIdle(driverID, location);
+    } else {
+        driverGrid.remove(driverID);
+        surge.setDriverBusy(driverID);
+    }
+    return true;
+}
+
+bool RideSharingSystem::claimDriver(int driverID) {
+    Driver* driver = findDriver(driverID);
+    if (!driver) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(dispatchMutex);
+    if (!driver->isAvailable()) {
+        return false;
+    }
+    driver->setAvailable(false);
+    driverGrid.remove(driverID);
+    surge.setDriverBusy(driverID);
+    return true;
+}
+
+std::vector<Driver*> RideSharingSystem::findNearestDrivers(GeoPoint point, size_t k) {
+    std::vector<Neighbor> nearest;
+    {
+        std::lock_guard<std::mutex> lock(dispatchMutex);
+        nearest = driverGrid.nearest(point, k);
+    }
+    std::vector<Driver*> result;
+    result.reserve(nearest.size());
+    for (const Neighbor& neighbor : nearest) {
+        result.push_back(findDriver(neighbor.id));
+    }
+    return result;
+}
+
+bool RideSharingSystem::appendToLogLocked(const std::shared_ptr<Ride>& ride, Driver* driverPtr, Rider* riderPtr,
+                                          double fare, uint64_t& sequence) {
+    // The table is the only step that can refuse a ride, so it goes first and a refusal leaves no trace
+    if (!rides.insert(ride)) {
+        LOG_ERROR("Ride ID " << ride->getRideID() << " cannot be stored");
+        return false;
+    }
+    // Listed before the ride can be found in the store, so a re-price or cancel always
+    // sees it in the driver's and rider's totals, at the fare logged here
+    driverPtr->addRide(*ride, fare);
+    riderPtr->requestRide(*ride, fare);
+    int driverID = driverPtr->getDriverID();
+    int riderID = riderPtr->getRiderID();
+    rideIndex.insert(rideStore, rideStore.append(*ride, driverID, riderID, fare));
+    timeSeries.recordRequest(ride->getType(), fare, ride->getRequestedAt());
+    // Journaled under the log lock, so a later re-price or cancel is always recorded after it
+    sequence = journal ? journal->append(rideEvent(*ride, driverID, riderID)) : 0;
+    return true;
+}
+
+void RideSharingSystem::commitToJournal(uint64_t sequence) {
+    if (journal && !journal->commit(sequence)) {
+        journalCommitFailures.add();
+        LOG_ERROR("Journal commit failed; change " << sequence << " is applied but not durable");
+    }
+}
+
+bool RideSharingSystem::claimRideIDs(size_t count, int& first) {
+    int next = nextRideID.load(std::memory_order_relaxed);
+    do {
+        if (static_cast<size_t>(std::numeric_limits<int>::max() - next) < count) {
+            return false;
+        }
+    } while (!nextRideID.compare_exchange_weak(next, next + static_cast<int>(count), std::memory_order_relaxed));
+    first = next;
+    return true;
+}
+
+std::shared_ptr<Ride> RideSharingSystem::buildRide(RideType type,
+                                                  const std::string& pickup,
+                                                  const GeoPoint* pickupPoint,
+                                                  const std::string& dropoff,
+                                                  double distance,
+                                                  Driver* driverPtr,
+                                                  Rider* riderPtr) {
+    if (!rideTypeInfo(type)) {
+        LOG_ERROR("Rides of type " << rideTypeLabel(type) << " cannot be created by the system");
+        rideRequestsRejected.add();
+        return nullptr;
+    }
+    if (pickupPoint && !isFinite(*pickupPoint)) {
+        LOG_ERROR("Ride pickup at " << pickup << " has non-finite coordinates");
+        rideRequestsRejected.add();
+        return nullptr;
+    }
+    if (!isValidDistance(distance)) {
+        LOG_ERROR("Ride from " << pickup << " has invalid distance " << distance);
+        rideRequestsRejected.add();
+        return nullptr;
+    }
+    
+    int rideID;
+    if (!claimRideIDs(1, rideID)) {
+        LOG_ERROR("Ride IDs exhausted; rejecting ride from " << pickup);
+        rideRequestsRejected.add();
+        return nullptr;
+    }
+    
+    // Factory pattern: the registry row constructs the concrete ride class.
+    // The pickup point and quote are set before the ride is shared with any other thread.
+    auto ride = makeRide(type, rideID, pickup, dropoff, distance);
+    if (pickupPoint) {
+        ride->setPickupPoint(*pickupPoint);
+    }
+    if (driverPtr && riderPtr) {
+        int64_t now = wallClockMillis();
+        ride->setRequestedAt(now);
+        if (pickupPoint) {
+            ride->setSurgePercent(surge.quote(*pickupPoint, now));
+            if (ride->getSurgePercent() != 100) {
+                ridesSurged.add();
+            }
+        }
+        if (!assignRide(ride, driverPtr, riderPtr)) {
+            rideRequestsRejected.add();
+            return nullptr;
+        }
+        ridesCreated.add();
+        LOG_INFO("Ride created and assigned successfully!");
+    }
+    return ride;
+}
+
+std::shared_ptr<Ride> RideSharingSystem::createRide(RideType type,
+                                                   const std::string& pickup,
+                                                   const std::string& dropoff,
+                                                   double distance,
+                                                   Driver* driverPtr,
+                                                   Rider* riderPtr) {
+    LatencyTimer timer(createRideLatency);
+    return buildRide(type, pickup, nullptr, dropoff, distance, driverPtr, riderPtr);
+}
+
 std::shared_ptr<Ride> RideSharingSystem::createRide(const std::string& rideType,
                                                    const std::string& pickup,
                                                    const std::string& dropoff,
                                                    double distance,
                                                    Driver* driverPtr,
                                                    Rider* riderPtr) {
-    std::shared_ptr<Ride> ride;
+    LatencyTimer timer(createRideLatency);
+    RideType type;
+    if (!parseRideType(rideType, type)) {
+        LOG_ERROR("Unknown ride type: " << rideType);
+        rideRequestsRejected.add();
+        return nullptr;
+    }
+    return buildRide(type, pickup, nullptr, dropoff, distance, driverPtr, riderPtr);
+}
+
+std::shared_ptr<Ride> RideSharingSystem::createRide(RideType type,
+                                                   const std::string& pickup,
+                                                   GeoPoint pickupPoint,
+                                                   const std::string& dropoff,
+                                                   double distance,
+                                                   Driver* driverPtr,
+                                                   Rider* riderPtr) {
+    LatencyTimer timer(createRideLatency);
+    return buildRide(type, pickup, &pickupPoint, dropoff, distance, driverPtr, riderPtr);
+}
+
+std::shared_ptr<Ride> RideSharingSystem::createRide(const std::string& rideType,
+                                                   const std::string& pickup,
+                                                   GeoPoint pickupPoint,
+                                                   const std::string& dropoff,
+                                                   double distance,
+                                                   Driver* driverPtr,
+                                                   Rider* riderPtr) {
+    LatencyTimer timer(createRideLatency);
+    RideType type;
+    if (!parseRideType(rideType, type)) {
+        LOG_ERROR("Unknown ride type: " << rideType);
+        rideRequestsRejected.add();
+        return nullptr;
+    }
+    return buildRide(type, pickup, &pickupPoint, dropoff, distance, driverPtr, riderPtr);
+}
+
+bool RideSharingSystem::assignRide(const std::shared_ptr<Ride>& ride, Driver* driverPtr, Rider* riderPtr) {
+    uint64_t sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        if (!appendToLogLocked(ride, driverPtr, riderPtr, ride->computeFare(), sequence)) {
+            return false;
+        }
+    }
+    commitToJournal(sequence);
+    return true;
+}
+
+std::shared_ptr<Ride> RideSharingSystem::requestRide(Rider* riderPtr,
+                                                     const std::string& pickup,
+                                                     GeoPoint pickupPoint,
+                                                     const std::string& dropoff,
+                                                     double distance,
+                                                     const std::string& rideType) {
+    RideType type;
+    if (!parseRideType(rideType, type)) {
+        LOG_ERROR("Unknown ride type: " << rideType);
+        rideRequestsRejected.add();
+        return nullptr;
+    }
+    return requestRide(riderPtr, pickup, pickupPoint, dropoff, distance, type);
+}
+
+std::shared_ptr<Ride> RideSharingSystem::requestRide(Rider* riderPtr,
+                                                     const std::string& pickup,
+                                                     GeoPoint pickupPoint,
+                                                     const std::string& dropoff,
+                                                     double distance,
+                                                     RideType type) {
+    if (!rideTypeInfo(type)) {
+        LOG_ERROR("Rides of type " << rideTypeLabel(type) << " cannot be requested");
+        rideRequestsRejected.add();
+        return nullptr;
+    }
+    if (!riderPtr) {
+        LOG_ERROR("Ride request is missing a rider");
+        rideRequestsRejected.add();
+        return nullptr;
+    }
+    if (!isFinite(pickupPoint)) {
+        LOG_ERROR("Ride request pickup at " << pickup << " has non-finite coordinates");
+        rideRequestsRejected.add();
+        return nullptr;
+    }
+    if (!isValidDistance(distance)) {
+        // Checked before a driver is claimed, like the pickup point
+        LOG_ERROR("Ride request from " << pickup << " has invalid distance " << distance);
+        rideRequestsRejected.add();
+        return nullptr;
+    }
     
-    // Factory pattern implementation for creating different ride types
-    if (rideType == "standard") {
-        ride = std::make_shared<StandardRide>(nextRideID++, pickup, dropoff, distance);
-    } else if (rideType == "premium") {
-        ride = std::make_shared<PremiumRide>(nextRideID++, pickup, dropoff, distance);
-    } else if (rideType == "economy") {
-        ride = std::make_shared<EconomyRide>(nextRideID++, pickup, dropoff, distance);
-    } else {
-        std::cout << "[ERROR] Unknown ride type: " << rideType << std::endl;
+    // Claim the nearest available driver so concurrent requests cannot match it too
+    Driver* driver = nullptr;
+    double pickupMiles = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(dispatchMutex);
+        std::vector<Neighbor> nearest = driverGrid.nearest(pickupPoint, 1);
+        if (nearest.empty()) {
+            surge.recordRequest(pickupPoint, wallClockMillis()); // Unserved requests are demand too
+            LOG_WARN("No available driver for pickup at " << pickup);
+            return nullptr;
+        }
+        driver = findDriver(nearest.front().id);
+        pickupMiles = nearest.front().distance;
+        driverGrid.remove(nearest.front().id);
+        surge.setDriverBusy(nearest.front().id);
+        driver->setAvailable(false);
+    }
+    
+    auto ride = createRide(type, pickup, pickupPoint, dropoff, distance, driver, riderPtr);
+    if (!ride) {
+        setDriverAvailable(driver->getDriverID(), true); // Hand the driver back for the next request
         return nullptr;
     }
+    LOG_INFO("Ride " << ride->getRideID() << " matched with nearest driver " << driver->getName()
+             << " (" << std::fixed << std::setprecision(2) << pickupMiles << " miles away)");
+    return ride;
+}
+
+bool RideSharingSystem::repriceRide(int rideID, double newDistance) {
+    if (!isValidDistance(newDistance)) {
+        LOG_ERROR("Cannot re-price ride " << rideID << " to invalid distance " << newDistance);
+        rideRequestsRejected.add();
+        return false;
+    }
+    int driverID;
+    int riderID;
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        size_t row;
+        if (!rideStore.findRow(rideID, row)) {
+            LOG_ERROR("Cannot re-price unknown ride ID: " << rideID);
+            return false;
+        }
+        driverID = rideStore.getDriverIDs()[row];
+        riderID = rideStore.getRiderIDs()[row];
+    }
+    
+    // Resolve both parties before the fare changes: a driver or rider
+    // materialized from a snapshot must start from the old fare
+    Driver* driver = findDriver(driverID);
+    Rider* rider = findRider(riderID);
     
-    if (ride && driverPtr && riderPtr) {
-        allRides.push_back(ride);
-        driverPtr->addRide(ride);
-        riderPtr->requestRide(ride);
+    RideType type;
+    double oldFare;
+    double newFare;
+    uint64_t sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        size_t row;
+        if (!rideStore.findRow(rideID, row)) {
+            LOG_ERROR("Cannot re-price cancelled ride ID: " << rideID);
+            return false;
+        }
         
-        std::cout << "[LOG] Ride created and assigned successfully!" << std::endl;
+        Ride& ride = *rideAt(row);
+        type = ride.getType();
+        oldFare = ride.computeFare();
+        ride.setDistance(newDistance);
+        newFare = ride.computeFare();
+        rideIndex.updateDistance(rideStore, row, newDistance);
+        rideStore.updatePrice(row, newDistance, newFare);
+        timeSeries.recordReprice(type, oldFare, newFare, ride.getRequestedAt());
+        // Appended under the log lock so replay applies re-prices in the same order
+        if (journal) {
+            sequence = journal->append(changeEvent(JournalEventType::RepriceRide, rideID, newDistance));
+        }
     }
+    commitToJournal(sequence);
     
-    return ride;
+    // The ride was listed with its driver and rider before it was logged, and fare
+    // deltas commute with a concurrent cancel, so totals can be adjusted outside the log lock
+    driver->updateRideFare(type, oldFare, newFare);
+    rider->updateRideFare(type, oldFare, newFare);
+    
+    ridesRepriced.add();
+    LOG_INFO("Ride " << rideID << " re-priced to $" << std::fixed << std::setprecision(2) << newFare);
+    return true;
+}
+
+bool RideSharingSystem::cancelRide(int rideID) {
+    int driverID;
+    int riderID;
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        size_t row;
+        if (!rideStore.findRow(rideID, row)) {
+            LOG_ERROR("Cannot cancel unknown ride ID: " << rideID);
+            return false;
+        }
+        driverID = rideStore.getDriverIDs()[row];
+        riderID = rideStore.getRiderIDs()[row];
+    }
+    
+    // Materialize first so a snapshot driver or rider still lists the ride
+    Driver* driver = findDriver(driverID);
+    Rider* rider = findRider(riderID);
+    
+    std::shared_ptr<Ride> ride;
+    uint64_t sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        size_t row;
+        if (!rideStore.findRow(rideID, row)) {
+            LOG_ERROR("Cannot cancel unknown ride ID: " << rideID);
+            return false;
+        }
+        ride = rideAt(row);
+        rideIndex.erase(rideStore, row);
+        rideStore.erase(row);
+        timeSeries.recordCancel(ride->getType(), ride->computeFare(), ride->getRequestedAt(), ride->getCompletedAt());
+        if (journal) {
+            sequence = journal->append(changeEvent(JournalEventType::CancelRide, rideID, 0.0));
+        }
+    }
+    commitToJournal(sequence);
+    
+    // Released from the table only once no driver or rider lists its ID; if either
+    // still might, the ride object is kept so that ID keeps resolving
+    bool driverRemoved = driver->removeRide(*ride);
+    bool riderRemoved = rider->removeRide(*ride);
+    if (driverRemoved && riderRemoved) {
+        rides.release(rideID);
+    } else {
+        LOG_ERROR("Cancelled ride " << rideID << " was not listed with its "
+                  << (driverRemoved ? "rider" : "driver") << "; keeping it in the ride table");
+    }
+    
+    ridesCancelled.add();
+    LOG_INFO("Ride " << rideID << " cancelled");
+    return true;
+}
+
+bool RideSharingSystem::completeRide(int rideID) {
+    int64_t completedAt = wallClockMillis();
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        size_t row;
+        if (!rideStore.findRow(rideID, row)) {
+            LOG_ERROR("Cannot complete unknown ride ID: " << rideID);
+            return false;
+        }
+        std::shared_ptr<Ride> ride = rideAt(row);
+        if (!ride->markCompleted(completedAt)) {
+            LOG_ERROR("Ride " << rideID << " is already completed");
+            return false;
+        }
+        timeSeries.recordCompletion(ride->getType(), completedAt);
+    }
+    ridesCompleted.add();
+    LOG_INFO("Ride " << rideID << " completed");
+    return true;
+}
+
+bool RideSharingSystem::parseRideType(std::string_view rideType, RideType& type) {
+    const RideTypeInfo* info = findRideType(rideType);
+    if (!info) {
+        return false;
+    }
+    type = info->type;
+    return true;
+}
+
+std::vector<std::shared_ptr<Ride>> RideSharingSystem::createRides(const RideRequest* requests,
+                                                                  size_t count) {
+    // Unknown names become Custom, which the typed overload rejects
+    std::vector<RideType> types(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (!parseRideType(requests[i].rideType, types[i])) {
+            LOG_ERROR("Unknown ride type: " << requests[i].rideType);
+            types[i] = RideType::Custom;
+        }
+    }
+    return createRides(requests, types.data(), count);
+}
+
+std::vector<std::shared_ptr<Ride>> RideSharingSystem::createRides(const RideRequest* requests,
+                                                                  const RideType* types, size_t count) {
+    LatencyTimer timer(createRidesLatency);
+    std::vector<std::shared_ptr<Ride>> created(count);
+    
+    // Validate every request once, counting rides per driver and rider
+    std::vector<bool> accepted(count, false);
+    std::unordered_map<Driver*, size_t> driverCounts;
+    std::unordered_map<Rider*, size_t> riderCounts;
+    size_t acceptedCount = 0;
+    
+    for (size_t i = 0; i < count; ++i) {
+        const RideRequest& request = requests[i];
+        if (!rideTypeInfo(types[i])) {
+            continue; // Custom: unknown name, or a type the system cannot construct
+        }
+        if (!request.driver || !request.rider) {
+            LOG_ERROR("Ride request " << i << " is missing a driver or rider");
+            continue;
+        }
+        if (!isValidDistance(request.distance)) {
+            LOG_ERROR("Ride request " << i << " has invalid distance " << request.distance);
+            continue;
+        }
+        accepted[i] = true;
+        acceptedCount++;
+        driverCounts[request.driver]++;
+        riderCounts[request.rider]++;
+    }
+    
+    // Claim one contiguous block of IDs before anything is changed, so running out rejects the batch cleanly
+    int rideID = 0;
+    if (acceptedCount > 0 && !claimRideIDs(acceptedCount, rideID)) {
+        LOG_ERROR("Ride IDs exhausted; rejecting batch of " << count << " rides");
+        rideRequestsRejected.add(count);
+        return created;
+    }
+    
+    // Reserve once for the whole batch
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        size_t needed = rideStore.size() + acceptedCount;
+        if (needed > rideStore.capacity()) {
+            rideStore.reserve(std::max(needed, rideStore.capacity() * 2));
+        }
+    }
+    for (const auto& entry : driverCounts) {
+        entry.first->reserveRides(entry.second);
+    }
+    for (const auto& entry : riderCounts) {
+        entry.first->reserveRides(entry.second);
+    }
+    
+    // Price the whole batch with the vectorized fare kernel
+    std::vector<double> distances(count);
+    for (size_t i = 0; i < count; ++i) {
+        distances[i] = requests[i].distance;
+    }
+    std::vector<double> fares(count);
+    FareKernel::computeFares(distances.data(), types, fares.data(), count);
+    
+    // Build the rides outside any lock
+    int64_t requestedAt = wallClockMillis();
+    for (size_t i = 0; i < count; ++i) {
+        if (accepted[i]) {
+            const RideRequest& request = requests[i];
+            created[i] = makeRide(types[i], rideID++, request.pickup, request.dropoff, request.distance);
+            created[i]->setRequestedAt(requestedAt);
+        }
+    }
+    
+    // Commit every accepted ride to the log under a single lock acquisition
+    uint64_t sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        for (size_t i = 0; i < count; ++i) {
+            if (accepted[i]) {
+                const RideRequest& request = requests[i];
+                uint64_t rideSequence = 0;
+                if (!appendToLogLocked(created[i], request.driver, request.rider, fares[i], rideSequence)) {
+                    accepted[i] = false;
+                    created[i] = nullptr;
+                    acceptedCount--;
+                    continue;
+                }
+                sequence = rideSequence;
+            }
+        }
+    }
+    
+    // One commit covers the whole batch
+    if (acceptedCount > 0) {
+        commitToJournal(sequence);
+    }
+    
+    ridesCreated.add(acceptedCount);
+    rideRequestsRejected.add(count - acceptedCount);
+    LOG_INFO("Batch created " << acceptedCount << " of " << count << " rides");
+    return created;
 }
 
 void RideSharingSystem::demonstratePolymorphism() {
+    Logger::instance().flush(); // Keep queued log records ahead of the report
     std::cout << "\n========================================" << std::endl;
     std::cout << "DEMONSTRATING POLYMORPHISM" << std::endl;
     std::cout << "========================================" << std::endl;
-    std::cout << "[LOG] Processing all rides polymorphically..." << std::endl;
+    LOG_INFO("Processing all rides polymorphically...");
+    Logger::instance().flush();
     
-    if (allRides.empty()) {
+    // Snapshot the log so dispatchers are not blocked while the report prints
+    std::vector<std::shared_ptr<Ride>> rideList;
+    double totalRevenue;
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        rideList.reserve(rideStore.size());
+        for (size_t row = 0; row < rideStore.size(); ++row) {
+            rideList.push_back(rideAt(row));
+        }
+        // Revenue comes from the dense fare column rather than per-ride virtual calls
+        totalRevenue = rideStore.totalRevenue();
+    }
+    
+    if (rideList.empty()) {
         std::cout << "No rides in the system to demonstrate." << std::endl;
         return;
     }
     
-    double totalRevenue = 0.0;
-    
     // Polymorphic behavior: calling virtual methods on base class pointers
-    for (const auto& ride : allRides) {
+    for (const auto& ride : rideList) {
         std::cout << "\n--- Processing Ride Polymorphically ---" << std::endl;
         // Call virtual methods - actual implementation depends on runtime type
         ride->rideDetails();
-        totalRevenue += ride->fare();
         std::cout << std::endl;
     }
     
     std::cout << "=== Polymorphism Demonstration Summary ===" << std::endl;
-    std::cout << "Total rides processed: " << allRides.size() << std::endl;
+    std::cout << "Total rides processed: " << rideList.size() << std::endl;
     std::cout << "Total revenue: $" << std::fixed << std::setprecision(2) << totalRevenue << std::endl;
-    std::cout << "[LOG] Polymorphism demonstration completed!" << std::endl;
+    LOG_INFO("Polymorphism demonstration completed!");
+}
+
+RideStats RideSharingSystem::computeStats() {
+    LatencyTimer timer(statsLatency);
+    std::lock_guard<std::mutex> statsLock(statsMutex);
+    if (!statsEngine) {
+        statsEngine = std::make_unique<StatsEngine>();
+    }
+    int maxDriverID;
+    {
+        // Only the column copy holds up dispatch; the parallel pass runs on the copy
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        statsEngine->capture(rideStore);
+        maxDriverID = nextDriverID - 1;
+    }
+    return statsEngine->computeCaptured(maxDriverID);
+}
+
+RideQueryResult RideSharingSystem::queryRides(const RideQuery& query) {
+    std::lock_guard<std::mutex> lock(rideLogMutex);
+    return rideIndex.query(query, rideStore);
 }
 
 void RideSharingSystem::displaySystemStats() {
+    Logger::instance().flush(); // Keep queued log records ahead of the report
     std::cout << "\n========================================" << std::endl;
     std::cout << "SYSTEM STATISTICS" << std::endl;
     std::cout << "========================================" << std::endl;
     
-    std::cout << "Total Drivers: " << drivers.size() << std::endl;
-    std::cout << "Total Riders: " << riders.size() << std::endl;
-    std::cout << "Total Rides: " << allRides.size() << std::endl;
+    RideStats stats = computeStats();
+    size_t driverCount;
+    size_t riderCount;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        driverCount = drivers.size() + snapshotDriversPending;
+        riderCount = riders.size() + snapshotRidersPending;
+    }
     
-    // Calculate total revenue
-    double totalRevenue = 0.0;
-    for (const auto& ride : allRides) {
-        totalRevenue += ride->fare();
+    std::cout << "Total Drivers: " << driverCount << std::endl;
+    std::cout << "Total Riders: " << riderCount << std::endl;
+    std::cout << "Total Rides: " << stats.rideCount << std::endl;
+    std::cout << "Total Revenue: $" << std::fixed << std::setprecision(2) << stats.totalRevenue << std::endl;
+    
+    std::cout << "\nRide Type Distribution:" << std::endl;
+    for (const RideTypeInfo& info : RIDE_TYPES) {
+        std::cout << "- " << info.label << ": " << stats.count(info.type) << std::endl;
+    }
+    if (stats.count(RideType::Custom) > 0) {
+        std::cout << "- Custom: " << stats.count(RideType::Custom) << std::endl;
     }
-    std::cout << "Total Revenue: $" << std::fixed << std::setprecision(2) << totalRevenue << std::endl;
     
-    // Show ride type distribution
-    int standardCount = 0, premiumCount = 0, economyCount = 0;
-    for (const auto& ride : allRides) {
-        if (std::dynamic_pointer_cast<StandardRide>(ride)) {
-            standardCount++;
-        } else if (std::dynamic_pointer_cast<PremiumRide>(ride)) {
-            premiumCount++;
-        } else if (std::dynamic_pointer_cast<EconomyRide>(ride)) {
-            economyCount++;
-        }
+    if (stats.rideCount > 0) {
+        std::cout << "\nRide Distance (miles):" << std::endl;
+        std::cout << "- Median: " << std::fixed << std::setprecision(2) << stats.distanceP50 << std::endl;
+        std::cout << "- 90th Percentile: " << stats.distanceP90 << std::endl;
+        std::cout << "- 99th Percentile: " << stats.distanceP99 << std::endl;
     }
     
-    std::cout << "\nRide Type Distribution:" << std::endl;
-    std::cout << "- Standard: " << standardCount << std::endl;
-    std::cout << "- Premium: " << premiumCount << std::endl;
-    std::cout << "- Economy: " << economyCount << std::endl;
+    displayRecentActivity();
+}
+
+TimeWindowStats RideSharingSystem::recentActivity(int64_t windowMillis) {
+    int64_t now = wallClockMillis();
+    std::lock_guard<std::mutex> lock(rideLogMutex);
+    return timeSeries.window(now, windowMillis);
+}
+
+std::vector<TimeWindowStats> RideSharingSystem::activitySeries(size_t count, bool hourly) {
+    int64_t now = wallClockMillis();
+    std::lock_guard<std::mutex> lock(rideLogMutex);
+    return timeSeries.series(now, count, hourly);
+}
+
+void RideSharingSystem::displayRecentActivity() {
+    const struct {
+        const char* label;
+        int64_t millis;
+    } windows[] = {
+        {"Last 15 minutes", 15 * RideTimeSeries::MINUTE_MILLIS},
+        {"Last hour", RideTimeSeries::HOUR_MILLIS},
+        {"Last 24 hours", 24 * RideTimeSeries::HOUR_MILLIS},
+    };
+    
+    std::cout << "\nRecent Activity (requests / completions / revenue):" << std::endl;
+    for (const auto& window : windows) {
+        TimeWindowStats activity = recentActivity(window.millis);
+        std::cout << "- " << std::left << std::setw(16) << window.label << std::right
+                  << std::setw(8) << activity.requestCount() << std::setw(8) << activity.completionCount()
+                  << "   $" << std::fixed << std::setprecision(2) << activity.revenue() << std::endl;
+    }
+    
+    TimeWindowStats lastHour = recentActivity(RideTimeSeries::HOUR_MILLIS);
+    std::cout << "\nLast Hour by Type:" << std::endl;
+    for (const RideTypeInfo& info : RIDE_TYPES) {
+        std::cout << "- " << info.label << ": " << lastHour.requestCount(info.type) << " ($"
+                  << std::fixed << std::setprecision(2) << lastHour.revenue(info.type) << ")" << std::endl;
+    }
+    if (lastHour.requestCount(RideType::Custom) > 0) {
+        std::cout << "- Custom: " << lastHour.requestCount(RideType::Custom) << " ($"
+                  << std::fixed << std::setprecision(2) << lastHour.revenue(RideType::Custom) << ")" << std::endl;
+    }
+}
+
+std::vector<LeaderboardEntry> RideSharingSystem::topDrivers(LeaderboardMetric metric, size_t k) {
+    materializeSnapshotDrivers();
+    return leaderboard.top(metric, k);
+}
+
+size_t RideSharingSystem::driverRank(int driverID, LeaderboardMetric metric) {
+    materializeSnapshotDrivers();
+    return leaderboard.rank(metric, driverID);
+}
+
+void RideSharingSystem::displayLeaderboard(size_t k) {
+    Logger::instance().flush(); // Keep queued log records ahead of the report
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "DRIVER LEADERBOARD" << std::endl;
+    std::cout << "========================================" << std::endl;
+    
+    const struct {
+        const char* title;
+        LeaderboardMetric metric;
+    } rankings[] = {
+        {"Top Earners", LeaderboardMetric::Earnings},
+        {"Most Rides", LeaderboardMetric::RideCount},
+        {"Highest Rated", LeaderboardMetric::Rating},
+    };
+    for (const auto& ranking : rankings) {
+        std::cout << "\n" << ranking.title << ":" << std::endl;
+        std::vector<LeaderboardEntry> entries = topDrivers(ranking.metric, k);
+        if (entries.empty()) {
+            std::cout << "No drivers registered." << std::endl;
+        }
+        for (size_t i = 0; i < entries.size(); ++i) {
+            Driver* driver = findDriver(entries[i].driverID);
+            std::cout << (i + 1) << ". " << (driver ? driver->getName() : "?")
+                      << " (ID: " << entries[i].driverID << ") - ";
+            switch (ranking.metric) {
+                case LeaderboardMetric::Earnings:
+                    std::cout << "$" << std::fixed << std::setprecision(2) << entries[i].score;
+                    break;
+                case LeaderboardMetric::RideCount:
+                    std::cout << static_cast<size_t>(entries[i].score) << " rides";
+                    break;
+                case LeaderboardMetric::Rating:
+                    std::cout << std::fixed << std::setprecision(1) << entries[i].score << "/5.0";
+                    break;
+            }
+            std::cout << std::endl;
+        }
+    }
+}
+
+void RideSharingSystem::setSurgePolicy(const SurgePolicy& policy) {
+    surge.setPolicy(policy);
+}
+
+ZoneDemand RideSharingSystem::zoneDemand(GeoPoint point) {
+    return surge.zone(point, wallClockMillis());
+}
+
+std::vector<ZoneDemand> RideSharingSystem::surgingZones() {
+    return surge.surgingZones(wallClockMillis());
+}
+
+void RideSharingSystem::displayMetrics() {
+    Logger::instance().flush(); // Keep queued log records ahead of the report
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "SYSTEM METRICS" << std::endl;
+    std::cout << "========================================" << std::endl;
+    metrics.display(std::cout);
+}
+
+bool RideSharingSystem::exportMetrics(const std::string& path) {
+    if (!metrics.writePrometheus(path)) {
+        LOG_ERROR("Cannot write metrics to " << path);
+        return false;
+    }
+    LOG_INFO("Metrics written to " << path);
+    return true;
 }
 
 Driver* RideSharingSystem::findDriver(int id) {
-    auto it = std::find_if(drivers.begin(), drivers.end(),
-                          [id](const std::unique_ptr<Driver>& driver) {
-                              return driver->getDriverID() == id;
-                          });
-    return (it != drivers.end()) ? it->get() : nullptr;
+    LatencyTimer timer(findDriverLatency);
+    Driver* driver = driverIndex.find(id);
+    if (driver || !snapshot) {
+        return driver;
+    }
+    return materializeDriver(id);
 }
 
 Rider* RideSharingSystem::findRider(int id) {
-    auto it = std::find_if(riders.begin(), riders.end(),
-                          [id](const std::unique_ptr<Rider>& rider) {
-                              return rider->getRiderID() == id;
-                          });
-    return (it != riders.end()) ? it->get() : nullptr;
+    LatencyTimer timer(findRiderLatency);
+    Rider* rider = riderIndex.find(id);
+    if (rider || !snapshot) {
+        return rider;
+    }
+    return materializeRider(id);
+}
+
+std::shared_ptr<Ride> RideSharingSystem::rideAt(size_t row) {
+    std::shared_ptr<Ride> ride = rides.get(rideStore.getRideIDs()[row]);
+    if (!ride) {
+        // Only snapshot rows start out without a ride object
+        ride = rideStore.makeRide(row);
+        size_t snapshotRow;
+        if (snapshot->findRide(ride->getRideID(), snapshotRow) && snapshot->pickupFlags()[snapshotRow]) {
+            ride->setPickupPoint(snapshot->pickupPoints()[snapshotRow]);
+        }
+        rides.insert(ride);
+    }
+    return ride;
+}
+
+Driver* RideSharingSystem::materializeDriver(int id) {
+    const SnapshotDriver* record = snapshot->findDriver(id);
+    if (!record) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> registryLock(registryMutex);
+    if (Driver* existing = driverIndex.find(id)) {
+        return existing; // Another thread got here first
+    }
+    
+    auto driver = std::make_unique<Driver>(id, std::string(snapshot->text(record->nameOffset, record->nameLength)),
+                                           record->rating, &rides);
+    if (record->flags & SnapshotDriver::HAS_LOCATION) {
+        driver->setLocation({record->x, record->y});
+    }
+    driver->setAvailable((record->flags & SnapshotDriver::AVAILABLE) != 0);
+    
+    size_t count;
+    const int32_t* rideIDs = snapshot->driverRides(record, count);
+    std::vector<int> listed;
+    listed.reserve(count);
+    {
+        std::lock_guard<std::mutex> logLock(rideLogMutex);
+        for (size_t i = 0; i < count; ++i) {
+            size_t row;
+            if (rideStore.findRow(rideIDs[i], row)) {
+                rideAt(row); // Materialized so the driver's IDs resolve
+                listed.push_back(rideIDs[i]);
+            }
+        }
+    }
+    driver->restoreRides(std::move(listed));
+    driver->setLeaderboard(&leaderboard);
+    
+    Driver* ptr = driver.get();
+    drivers.push_back(std::move(driver));
+    driverIndex.insert(id, ptr);
+    snapshotDriversPending--;
+    return ptr;
+}
+
+void RideSharingSystem::materializeSnapshotDrivers() {
+    if (!snapshot) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (snapshotDriversPending == 0) {
+            return;
+        }
+    }
+    for (size_t i = 0; i < snapshot->driverCount(); ++i) {
+        findDriver(snapshot->drivers()[i].id);
+    }
+}
+
+Rider* RideSharingSystem::materializeRider(int id) {
+    const SnapshotRider* record = snapshot->findRider(id);
+    if (!record) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> registryLock(registryMutex);
+    if (Rider* existing = riderIndex.find(id)) {
+        return existing;
+    }
+    
+    auto rider = std::make_unique<Rider>(id, std::string(snapshot->text(record->nameOffset, record->nameLength)),
+                                         std::string(snapshot->text(record->paymentOffset, record->paymentLength)),
+                                         &rides);
+    
+    size_t count;
+    const int32_t* rideIDs = snapshot->riderRides(record, count);
+    std::vector<int> listed;
+    listed.reserve(count);
+    {
+        std::lock_guard<std::mutex> logLock(rideLogMutex);
+        for (size_t i = 0; i < count; ++i) {
+            size_t row;
+            if (rideStore.findRow(rideIDs[i], row)) {
+                rideAt(row); // Materialized so the rider's IDs resolve
+                listed.push_back(rideIDs[i]);
+            }
+        }
+    }
+    rider->restoreRides(std::move(listed));
+    
+    Rider* ptr = rider.get();
+    riders.push_back(std::move(rider));
+    riderIndex.insert(id, ptr);
+    snapshotRidersPending--;
+    return ptr;
+}
+
+bool RideSharingSystem::saveSnapshot(const std::string& path) {
+    // Records are written from live objects, so finish materializing the old snapshot
+    if (snapshot) {
+        materializeSnapshotDrivers();
+        for (size_t i = 0; i < snapshot->riderCount(); ++i) {
+            findRider(snapshot->riders()[i].id);
+        }
+    }
+    
+    std::vector<Driver*> driverList;
+    std::vector<Rider*> riderList;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& driver : drivers) {
+            driverList.push_back(driver.get());
+        }
+        for (const auto& rider : riders) {
+            riderList.push_back(rider.get());
+        }
+    }
+    std::sort(driverList.begin(), driverList.end(),
+              [](const Driver* a, const Driver* b) { return a->getDriverID() < b->getDriverID(); });
+    std::sort(riderList.begin(), riderList.end(),
+              [](const Rider* a, const Rider* b) { return a->getRiderID() < b->getRiderID(); });
+    
+    SnapshotContents contents;
+    auto addString = [&contents](const std::string& text, uint32_t& offset, uint32_t& length) {
+        offset = static_cast<uint32_t>(contents.strings.size());
+        length = static_cast<uint32_t>(text.size());
+        contents.strings += text;
+    };
+    
+    contents.driverRideStart.push_back(0);
+    for (const Driver* driver : driverList) {
+        SnapshotDriver record = {};
+        record.id = driver->getDriverID();
+        addString(driver->getName(), record.nameOffset, record.nameLength);
+        record.rating = driver->getRating();
+        GeoPoint location;
+        if (driver->getLocation(location)) {
+            record.flags |= SnapshotDriver::HAS_LOCATION;
+            record.x = location.x;
+            record.y = location.y;
+        }
+        if (driver->isAvailable()) {
+            record.flags |= SnapshotDriver::AVAILABLE;
+        }
+        contents.drivers.push_back(record);
+        for (int rideID : driver->getRideIDs()) {
+            contents.driverRideIDs.push_back(rideID);
+        }
+        contents.driverRideStart.push_back(static_cast<uint32_t>(contents.driverRideIDs.size()));
+    }
+    
+    contents.riderRideStart.push_back(0);
+    for (const Rider* rider : riderList) {
+        SnapshotRider record = {};
+        record.id = rider->getRiderID();
+        addString(rider->getName(), record.nameOffset, record.nameLength);
+        addString(rider->getPaymentMethod(), record.paymentOffset, record.paymentLength);
+        contents.riders.push_back(record);
+        for (int rideID : rider->getRideIDs()) {
+            contents.riderRideIDs.push_back(rideID);
+        }
+        contents.riderRideStart.push_back(static_cast<uint32_t>(contents.riderRideIDs.size()));
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        const std::vector<RideType>& types = rideStore.getTypes();
+        if (std::find(types.begin(), types.end(), RideType::Custom) != types.end()) {
+            LOG_ERROR("Cannot snapshot custom ride types");
+            return false;
+        }
+        const std::vector<int>& rideIDs = rideStore.getRideIDs();
+        contents.rideIDs.assign(rideIDs.begin(), rideIDs.end());
+        contents.types = types;
+        contents.distances = rideStore.getDistances();
+        contents.fares = rideStore.getFares();
+        contents.surgePercents = rideStore.getSurgePercents();
+        contents.driverIDs.assign(rideStore.getDriverIDs().begin(), rideStore.getDriverIDs().end());
+        contents.riderIDs.assign(rideStore.getRiderIDs().begin(), rideStore.getRiderIDs().end());
+        
+        // Pool IDs are process-local; renumber the locations actually used densely
+        std::unordered_map<uint32_t, uint32_t> localIDs;
+        auto localID = [&](uint32_t poolID) {
+            auto inserted = localIDs.emplace(poolID, static_cast<uint32_t>(contents.locations.size()));
+            if (inserted.second) {
+                contents.locations.push_back(rideStore.locationName(poolID));
+            }
+            return inserted.first->second;
+        };
+        
+        size_t count = rideStore.size();
+        contents.pickupIDs.resize(count);
+        contents.dropoffIDs.resize(count);
+        contents.hasPickupPoint.resize(count, 0);
+        contents.pickupPoints.resize(count);
+        for (size_t row = 0; row < count; ++row) {
+            contents.pickupIDs[row] = localID(rideStore.getPickupIDs()[row]);
+            contents.dropoffIDs[row] = localID(rideStore.getDropoffIDs()[row]);
+            const Ride* ride = rides.find(rideIDs[row]);
+            size_t snapshotRow;
+            if (ride && ride->hasPickupPoint()) {
+                contents.hasPickupPoint[row] = 1;
+                contents.pickupPoints[row] = ride->getPickupPoint();
+            } else if (!ride && snapshot && snapshot->findRide(rideIDs[row], snapshotRow)) {
+                // Still unmaterialized - copy straight from the old snapshot
+                contents.hasPickupPoint[row] = snapshot->pickupFlags()[snapshotRow];
+                contents.pickupPoints[row] = snapshot->pickupPoints()[snapshotRow];
+            }
+        }
+    }
+    contents.nextRideID = nextRideID.load();
+    contents.nextDriverID = nextDriverID.load();
+    contents.nextRiderID = nextRiderID.load();
+    
+    if (!Snapshot::save(path, contents)) {
+        return false;
+    }
+    // The snapshot now holds everything the journal recorded
+    if (journal && !journal->truncate()) {
+        LOG_ERROR("Snapshot saved but the journal could not be emptied");
+        return false;
+    }
+    LOG_INFO("Saved snapshot " << path << " (" << contents.drivers.size() << " drivers, "
+             << contents.riders.size() << " riders, " << contents.rideIDs.size() << " rides)");
+    return true;
+}
+
+bool RideSharingSystem::loadSnapshot(const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> registryLock(registryMutex);
+        std::lock_guard<std::mutex> logLock(rideLogMutex);
+        if (snapshot || !drivers.empty() || !riders.empty() || !rideStore.empty()) {
+            LOG_ERROR("Snapshots can only be loaded into an empty system");
+            return false;
+        }
+    }
+    
+    std::unique_ptr<Snapshot> image = Snapshot::open(path);
+    if (!image) {
+        return false;
+    }
+    
+    // Translate snapshot location IDs to this process's pool
+    std::vector<uint32_t> locationIDs(image->locationCount());
+    for (size_t i = 0; i < locationIDs.size(); ++i) {
+        locationIDs[i] = LocationPool::global().intern(image->locationName(static_cast<uint32_t>(i)));
+    }
+    
+    // One tight pass over the columns checks everything later lookups rely on
+    size_t count = image->rideCount();
+    const int32_t* rideIDs = image->rideIDs();
+    const RideType* types = image->rideTypes();
+    std::vector<uint32_t> pickupIDs(count);
+    std::vector<uint32_t> dropoffIDs(count);
+    for (size_t row = 0; row < count; ++row) {
+        uint32_t pickup = image->pickupIDs()[row];
+        uint32_t dropoff = image->dropoffIDs()[row];
+        if ((row > 0 && rideIDs[row] <= rideIDs[row - 1]) || rideIDs[row] >= image->nextRideID() ||
+            static_cast<uint8_t>(types[row]) >= static_cast<uint8_t>(RideType::Custom) ||
+            pickup >= locationIDs.size() || dropoff >= locationIDs.size()) {
+            LOG_ERROR("Snapshot ride columns are corrupt: " << path);
+            return false;
+        }
+        pickupIDs[row] = locationIDs[pickup];
+        dropoffIDs[row] = locationIDs[dropoff];
+    }
+    size_t driverCount = image->driverCount();
+    size_t riderCount = image->riderCount();
+    if ((driverCount > 0 && image->drivers()[driverCount - 1].id >= image->nextDriverID()) ||
+        (riderCount > 0 && image->riders()[riderCount - 1].id >= image->nextRiderID())) {
+        LOG_ERROR("Snapshot ID counters are behind its records: " << path);
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        rideStore.assign(count, rideIDs, types, image->distances(), image->fares(),
+                         pickupIDs.data(), dropoffIDs.data(), image->rideDriverIDs(), image->rideRiderIDs(),
+                         image->surgePercents());
+        rideIndex.reset(); // Rebuilt from the loaded columns on the first query
+    }
+    {
+        // Available drivers must be matchable before they are ever looked up
+        std::lock_guard<std::mutex> lock(dispatchMutex);
+        const SnapshotDriver* records = image->drivers();
+        const uint8_t matchable = SnapshotDriver::HAS_LOCATION | SnapshotDriver::AVAILABLE;
+        for (size_t i = 0; i < driverCount; ++i) {
+            if ((records[i].flags & matchable) == matchable) {
+                driverGrid.update(records[i].id, {records[i].x, records[i].y});
+                surge.setDriverIdle(records[i].id, {records[i].x, records[i].y});
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        snapshotDriversPending = driverCount;
+        snapshotRidersPending = riderCount;
+    }
+    nextRideID = image->nextRideID();
+    nextDriverID = image->nextDriverID();
+    nextRiderID = image->nextRiderID();
+    snapshot = std::move(image);
+    
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Loaded snapshot " << path << " (" << driverCount << " drivers, " << riderCount << " riders, "
+             << count << " rides) in " << std::fixed << std::setprecision(2) << millis << " ms");
+    return true;
+}
+
+
+bool RideSharingSystem::openJournal(const std::string& path, const JournalOptions& options) {
+    if (journal) {
+        LOG_ERROR("A journal is already open");
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t replayed = 0;
+    std::unique_ptr<Journal> opened = Journal::open(path, options, [this, &replayed](const JournalEvent& event) {
+        applyJournalEvent(event);
+        replayed++;
+    });
+    if (!opened) {
+        return false;
+    }
+    journal = std::move(opened);
+    
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Replayed " << replayed << " journal events from " << path << " in "
+             << std::fixed << std::setprecision(2) << millis << " ms");
+    return true;
+}
+
+void RideSharingSystem::applyJournalEvent(const JournalEvent& event) {
+    // Runs before the journal is attached, so nothing here is journaled again
+    auto hasRide = [this](int rideID) {
+        std::lock_guard<std::mutex> lock(rideLogMutex);
+        size_t row;
+        return rideStore.findRow(rideID, row);
+    };
+    auto advance = [](std::atomic<int>& counter, int usedID) {
+        if (counter.load() <= usedID) {
+            counter = usedID < std::numeric_limits<int>::max() ? usedID + 1 : usedID; // INT_MAX: none left
+        }
+    };
+    
+    switch (event.type) {
+        case JournalEventType::AddDriver:
+            if (!findDriver(event.id)) {
+                registerDriver(event.id, std::string(event.name), event.value);
+                if (event.hasPoint) {
+                    updateDriverLocation(event.id, event.point);
+                }
+            }
+            advance(nextDriverID, event.id);
+            break;
+        case JournalEventType::AddRider:
+            if (!findRider(event.id)) {
+                registerRider(event.id, std::string(event.name), std::string(event.paymentMethod));
+            }
+            advance(nextRiderID, event.id);
+            break;
+        case JournalEventType::CreateRide: {
+            advance(nextRideID, event.id);
+            if (hasRide(event.id)) {
+                break;
+            }
+            Driver* driver = findDriver(event.driverID);
+            Rider* rider = findRider(event.riderID);
+            if (!driver || !rider) {
+                LOG_WARN("Journaled ride " << event.id << " refers to a missing driver or rider");
+                break;
+            }
+            auto ride = makeRide(event.rideType, event.id, event.pickup, event.dropoff, event.value);
+            if (event.hasPoint) {
+                ride->setPickupPoint(event.point);
+            }
+            ride->setSurgePercent(event.surgePercent); // The quote is replayed, not re-computed
+            assignRide(ride, driver, rider);
+            break;
+        }
+        case JournalEventType::UpdateRating:
+            if (Driver* driver = findDriver(event.id)) {
+                driver->setRating(event.value);
+            }
+            break;
+        case JournalEventType::RepriceRide:
+            if (hasRide(event.id)) {
+                repriceRide(event.id, event.value);
+            }
+            break;
+        case JournalEventType::CancelRide:
+            if (hasRide(event.id)) {
+                cancelRide(event.id);
+            }
+            break;
+    }
 }
@@ -4,22 +4,204 @@
 #include "Ride.h"
 #include "Driver.h"
 #include "Rider.h"
+#include "RideStore.h"
+#include "RideTable.h"
+#include "RideIndex.h"
+#include "IdIndex.h"
+#include "StatsEngine.h"
+#include "SpatialIndex.h"
+#include "Snapshot.h"
+#include "Journal.h"
+#include "Metrics.h"
+#include "RideTimeSeries.h"
+#include "Leaderboard.h"
+#include "SurgeEngine.h"
 #include <vector>
 #include <memory>
 #include <map>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+
+/**
+ * One entry of a batch ride creation request
+ */
+struct RideRequest {
+    std::string rideType;   // Registered type name ("standard", "premium", "economy", ...)
+    std::string pickup;
+    std::string dropoff;
+    double distance;
+    Driver* driver;
+    Rider* rider;
+};
 
 /**
  * RideSharingSystem - Main system class that manages the entire operation
  * Demonstrates composition and system-level functionality
+ *
+ * Thread safety: any number of dispatcher threads may add drivers and riders
+ * and create, re-price or cancel rides concurrently. IDs come from atomic
+ * counters, findDriver/findRider are wait-free, each driver and rider has its
+ * own lock, and the shared ride log is only locked for the append itself.
+ *
+ * After loadSnapshot() the snapshot file stays mapped as the base layer:
+ * ride columns are copied into the store up front, while Ride, Driver and
+ * Rider objects are only built the first time something looks them up.
+ * Ride objects live in one RideTable; drivers and riders list ride IDs.
+ * With a journal open, every change is also appended to it before the call
+ * returns (durably, depending on the journal's sync policy).
  */
 class RideSharingSystem {
 private:
-    std::vector<std::shared_ptr<Ride>> allRides;
+    RideTable rides;     // Owns every ride object; drivers and riders hold ride IDs into it
+    RideStore rideStore; // Columnar copy of the ride log for aggregate scans
+    RideIndex rideIndex; // Secondary indexes over rideStore for filter queries
+    std::mutex rideLogMutex; // Guards rideStore, rideIndex and timeSeries, and orders ride table changes with it
+    RideTimeSeries timeSeries; // Per-minute and per-hour activity, updated as rides change
     std::vector<std::unique_ptr<Driver>> drivers;
     std::vector<std::unique_ptr<Rider>> riders;
-    int nextRideID;
-    int nextDriverID;
-    int nextRiderID;
+    std::mutex registryMutex; // Guards the drivers and riders ownership lists
+    IdIndex<Driver> driverIndex; // O(1) wait-free lookup by driver ID
+    IdIndex<Rider> riderIndex;   // O(1) wait-free lookup by rider ID
+    std::atomic<int> nextRideID;
+    std::atomic<int> nextDriverID;
+    std::atomic<int> nextRiderID;
+    std::mutex statsMutex; // Guards statsEngine; taken before rideLogMutex
+    std::unique_ptr<StatsEngine> statsEngine; // Created on first statistics query
+    SpatialIndex driverGrid; // Positions of drivers open for automatic matching
+    std::mutex dispatchMutex; // Guards driverGrid and driver availability
+    SurgeEngine surge;        // Per-zone demand and idle drivers; kept in step with driverGrid
+    std::unique_ptr<Snapshot> snapshot; // Loaded base layer, nullptr if none
+    size_t snapshotDriversPending = 0; // Snapshot drivers not yet materialized (registryMutex)
+    size_t snapshotRidersPending = 0;  // Snapshot riders not yet materialized (registryMutex)
+    std::mutex ratingMutex; // Keeps journaled ratings in the order they were applied
+    Leaderboard leaderboard; // Driver rankings, updated by drivers as their figures change
+    MetricsRegistry metrics;
+    Counter& ridesCreated;         // Instruments registered in the constructor
+    Counter& rideRequestsRejected;
+    Counter& ridesRepriced;
+    Counter& ridesCancelled;
+    Counter& ridesCompleted;
+    Counter& ridesSurged;
+    Counter& journalCommitFailures;
+    Histogram& createRideLatency;
+    Histogram& createRidesLatency;
+    Histogram& findDriverLatency;
+    Histogram& findRiderLatency;
+    Histogram& statsLatency;
+    std::unique_ptr<Journal> journal; // Write-ahead log, nullptr if none; declared last so it flushes first
+    
+    /**
+     * Create a driver with a given ID and add it to the registry and index
+     * @param id Driver ID
+     * @param name Driver's name
+     * @param rating Initial rating
+     * @return Pointer to created driver
+     */
+    Driver* registerDriver(int id, const std::string& name, double rating);
+    
+    /**
+     * Create a rider with a given ID and add it to the registry and index
+     * @param id Rider ID
+     * @param name Rider's name
+     * @param paymentMethod Payment method
+     * @return Pointer to created rider
+     */
+    Rider* registerRider(int id, const std::string& name, const std::string& paymentMethod);
+    
+    /**
+     * Create a driver, journaling it first when a journal is open
+     * @param name Driver's name
+     * @param rating Initial rating
+     * @param location Current position, or nullptr if unknown
+     * @return Pointer to created driver
+     */
+    Driver* createDriver(const std::string& name, double rating, const GeoPoint* location);
+    
+    /**
+     * Apply one event read back from the journal
+     * Events already reflected in the system (e.g. by a snapshot) are skipped
+     * @param event Journaled event
+     */
+    void applyJournalEvent(const JournalEvent& event);
+    
+    /**
+     * Ride object of a store row, built from the columns on first use
+     * Caller must hold rideLogMutex; the ride stays in the ride table
+     * @param row Row index
+     * @return Ride at that row
+     */
+    std::shared_ptr<Ride> rideAt(size_t row);
+    
+    /**
+     * Build a driver from its snapshot record on first lookup
+     * @param id Driver ID
+     * @return Driver, or nullptr if the snapshot has no such driver
+     */
+    Driver* materializeDriver(int id);
+    
+    /**
+     * Build a rider from its snapshot record on first lookup
+     * @param id Rider ID
+     * @return Rider, or nullptr if the snapshot has no such rider
+     */
+    Rider* materializeRider(int id);
+    
+    /**
+     * Materialize every snapshot driver not looked up yet
+     * Needed before anything that must see all drivers, such as rankings
+     */
+    void materializeSnapshotDrivers();
+    
+    /**
+     * Wait for a journaled change to be durable, as the sync policy requires
+     * The change is already applied in memory, so a failure is logged and
+     * counted in journal_commit_failures rather than undone
+     * @param sequence Sequence number returned by the journal append (ignored without a journal)
+     */
+    void commitToJournal(uint64_t sequence);
+    
+    /**
+     * Record a constructed ride in the ride table, its driver's and rider's
+     * lists and the store (caller holds the ride log lock)
+     * The driver and rider list the ride before the store does, so nothing
+     * that finds the ride in the store can miss it in their totals
+     * @param ride Ride to record
+     * @param driverPtr Assigned driver
+     * @param riderPtr Requesting rider
+     * @param fare Fare of the ride, used for the store and the totals alike
+     * @param sequence Receives the journal sequence number of the ride (0 without a journal)
+     * @return False (and nothing recorded) if the ride table cannot hold the ride's ID
+     */
+    bool appendToLogLocked(const std::shared_ptr<Ride>& ride, Driver* driverPtr, Rider* riderPtr, double fare,
+                           uint64_t& sequence);
+    
+    /**
+     * Record a constructed ride in the log and in its driver's and rider's lists
+     * @param ride Ride to commit
+     * @param driverPtr Assigned driver
+     * @param riderPtr Requesting rider
+     * @return False if the ride could not be recorded
+     */
+    bool assignRide(const std::shared_ptr<Ride>& ride, Driver* driverPtr, Rider* riderPtr);
+    
+    /**
+     * Reserve a block of consecutive ride IDs
+     * Fails instead of wrapping once the int ID space is used up
+     * @param count Number of IDs
+     * @param first Receives the first ID of the block
+     * @return False (and nothing reserved) if fewer than count IDs are left
+     */
+    bool claimRideIDs(size_t count, int& first);
+    
+    /**
+     * Shared body of the createRide overloads once the type is resolved
+     * @param pickupPoint Pickup position, or nullptr (such rides are not surged)
+     * @return Created ride, or nullptr if the type has no registry row
+     */
+    std::shared_ptr<Ride> buildRide(RideType type, const std::string& pickup, const GeoPoint* pickupPoint,
+                                    const std::string& dropoff, double distance,
+                                    Driver* driverPtr, Rider* riderPtr);
     
 public:
     /**
@@ -35,6 +217,48 @@ public:
      */
     Driver* addDriver(const std::string& name, double rating = 5.0);
     
+    /**
+     * Create a driver at a known position, available for automatic matching
+     * @param name Driver's name
+     * @param rating Initial rating
+     * @param location Current position
+     * @return Pointer to created driver, or nullptr if the location is not finite
+     */
+    Driver* addDriver(const std::string& name, double rating, GeoPoint location);
+    
+    /**
+     * Move a driver (cheap enough to call on every position report)
+     * @param driverID Driver ID
+     * @param location New position
+     * @return True if the driver exists and the location is finite
+     */
+    bool updateDriverLocation(int driverID, GeoPoint location);
+    
+    /**
+     * Open or close a driver for automatic matching
+     * Drivers matched by requestRide become unavailable until released here
+     * @param driverID Driver ID
+     * @param available True to accept new requests
+     * @return True if the driver exists
+     */
+    bool setDriverAvailable(int driverID, bool available);
+    
+    /**
+     * Atomically take an available driver out of automatic matching
+     * Used by dispatchers that pick the driver themselves
+     * @param driverID Driver ID
+     * @return True if the driver was available and is now claimed
+     */
+    bool claimDriver(int driverID);
+    
+    /**
+     * Find the available drivers closest to a point
+     * @param point Query position
+     * @param k Maximum number of drivers
+     * @return Up to k drivers, closest first
+     */
+    std::vector<Driver*> findNearestDrivers(GeoPoint point, size_t k);
+    
     /**
      * Create and add a new rider to the system
      * @param name Rider's name
@@ -45,13 +269,30 @@ public:
     
     /**
      * Create a ride and assign it to a driver and rider
+     * @param type Built-in ride type (Custom is rejected)
+     * @param pickup Pickup location
+     * @param dropoff Dropoff location
+     * @param distance Distance in miles
+     * @param driverPtr Pointer to driver
+     * @param riderPtr Pointer to rider
+     * @return Shared pointer to created ride, or nullptr if the type or distance is rejected
+     */
+    std::shared_ptr<Ride> createRide(RideType type,
+                                   const std::string& pickup,
+                                   const std::string& dropoff,
+                                   double distance,
+                                   Driver* driverPtr,
+                                   Rider* riderPtr);
+    
+    /**
+     * Create a ride from a type name (resolved once through RIDE_TYPES)
      * @param rideType Type of ride ("standard", "premium", "economy")
      * @param pickup Pickup location
      * @param dropoff Dropoff location
      * @param distance Distance in miles
      * @param driverPtr Pointer to driver
      * @param riderPtr Pointer to rider
-     * @return Shared pointer to created ride
+     * @return Shared pointer to created ride, or nullptr if the type or distance is rejected
      */
     std::shared_ptr<Ride> createRide(const std::string& rideType, 
                                    const std::string& pickup, 
@@ -60,29 +301,314 @@ public:
                                    Driver* driverPtr,
                                    Rider* riderPtr);
     
+    /**
+     * Create a ride with known pickup coordinates and assign it
+     * The request is counted in its pickup zone and the ride is quoted that
+     * zone's surge multiplier; the quote stays with the ride (re-pricing
+     * changes the distance, not the surge). Rides without coordinates are
+     * never surged.
+     * @param type Built-in ride type (Custom is rejected)
+     * @param pickup Pickup location
+     * @param pickupPoint Pickup position
+     * @param dropoff Dropoff location
+     * @param distance Distance in miles
+     * @param driverPtr Pointer to driver
+     * @param riderPtr Pointer to rider
+     * @return Shared pointer to created ride, or nullptr if the type, pickup point or distance is rejected
+     */
+    std::shared_ptr<Ride> createRide(RideType type,
+                                   const std::string& pickup,
+                                   GeoPoint pickupPoint,
+                                   const std::string& dropoff,
+                                   double distance,
+                                   Driver* driverPtr,
+                                   Rider* riderPtr);
+    
+    /**
+     * Create a ride with known pickup coordinates from a type name
+     * @param rideType Type of ride ("standard", "premium", "economy")
+     * @param pickup Pickup location
+     * @param pickupPoint Pickup position
+     * @param dropoff Dropoff location
+     * @param distance Distance in miles
+     * @param driverPtr Pointer to driver
+     * @param riderPtr Pointer to rider
+     * @return Shared pointer to created ride, or nullptr if the type, pickup point or distance is rejected
+     */
+    std::shared_ptr<Ride> createRide(const std::string& rideType,
+                                   const std::string& pickup,
+                                   GeoPoint pickupPoint,
+                                   const std::string& dropoff,
+                                   double distance,
+                                   Driver* driverPtr,
+                                   Rider* riderPtr);
+    
+    /**
+     * Request a ride and assign the nearest available driver automatically
+     * The matched driver becomes unavailable until setDriverAvailable()
+     * Requests nobody can serve still count as demand in their zone
+     * @param riderPtr Requesting rider
+     * @param pickup Pickup location
+     * @param pickupPoint Pickup position used for matching
+     * @param dropoff Dropoff location
+     * @param distance Distance in miles
+     * @param type Built-in ride type (Custom is rejected)
+     * @return Created ride, or nullptr if the pickup point or distance is invalid or no driver is available
+     */
+    std::shared_ptr<Ride> requestRide(Rider* riderPtr,
+                                      const std::string& pickup,
+                                      GeoPoint pickupPoint,
+                                      const std::string& dropoff,
+                                      double distance,
+                                      RideType type);
+    
+    /**
+     * Request a ride by type name and assign the nearest available driver
+     * @param riderPtr Requesting rider
+     * @param pickup Pickup location
+     * @param pickupPoint Pickup position used for matching
+     * @param dropoff Dropoff location
+     * @param distance Distance in miles
+     * @param rideType Type of ride ("standard", "premium", "economy")
+     * @return Created ride, or nullptr if the type, pickup point or distance is invalid or no driver is available
+     */
+    std::shared_ptr<Ride> requestRide(Rider* riderPtr,
+                                      const std::string& pickup,
+                                      GeoPoint pickupPoint,
+                                      const std::string& dropoff,
+                                      double distance,
+                                      const std::string& rideType = "standard");
+    
+    /**
+     * Create many rides in one call
+     * Capacity is reserved up front for the system and for every driver and
+     * rider involved, and all rides are committed in a single pass
+     * @param requests Pointer to the first request (rideType is not read)
+     * @param types Resolved type of each request (Custom rows are rejected)
+     * @param count Number of requests
+     * @return Created rides in request order (nullptr for rejected requests)
+     */
+    std::vector<std::shared_ptr<Ride>> createRides(const RideRequest* requests, const RideType* types,
+                                                   size_t count);
+    
+    /**
+     * Create many rides in one call, resolving each request's type name once
+     * @param requests Pointer to the first request
+     * @param count Number of requests
+     * @return Created rides in request order (nullptr for rejected requests)
+     */
+    std::vector<std::shared_ptr<Ride>> createRides(const RideRequest* requests, size_t count);
+    
+    /**
+     * Convenience overload of createRides for a vector of requests
+     * @param requests Requests to create
+     * @return Created rides in request order (nullptr for rejected requests)
+     */
+    std::vector<std::shared_ptr<Ride>> createRides(const std::vector<RideRequest>& requests) {
+        return createRides(requests.data(), requests.size());
+    }
+    
+    /**
+     * Change a ride's distance and re-price it
+     * Driver and rider totals and the ride store are adjusted in place
+     * @param rideID Ride to re-price
+     * @param newDistance Corrected distance in miles
+     * @return True if the ride exists and the distance is valid (see isValidDistance)
+     */
+    bool repriceRide(int rideID, double newDistance);
+    
+    /**
+     * Cancel a ride, removing it from the system, its driver and its rider
+     * Cancellation is rare, so removal shifts the remaining rides (O(n))
+     * @param rideID Ride to cancel
+     * @return True if the ride existed
+     */
+    bool cancelRide(int rideID);
+    
+    /**
+     * Mark a ride as completed now
+     * @param rideID Ride to complete
+     * @return False if the ride does not exist or was already completed
+     */
+    bool completeRide(int rideID);
+    
+    /**
+     * Parse a ride type name (a perfect-hash lookup in RIDE_TYPES)
+     * Name-based entry points call this once and pass the RideType on
+     * @param rideType Type name ("standard", "premium", "economy")
+     * @param type Receives the parsed type
+     * @return True if the name is a known ride type
+     */
+    static bool parseRideType(std::string_view rideType, RideType& type);
+    
     /**
      * Demonstrate polymorphism by processing all rides in the system
      */
     void demonstratePolymorphism();
     
     /**
-     * Display system statistics
+     * Compute ride statistics in one fused parallel pass
+     * @return Revenue, type counts, distance percentiles and per-driver revenue
+     */
+    RideStats computeStats();
+    
+    /**
+     * Rides matching a filter on type, distance, locations, driver and rider
+     * Answered from secondary indexes, driven by the most selective
+     * predicate; the indexes are built on the first query and kept up to
+     * date from then on
+     * @param query Filter (unset predicates match every ride)
+     * @return Matching ride IDs in ascending order, with the index used
+     */
+    RideQueryResult queryRides(const RideQuery& query);
+    
+    /**
+     * Display system statistics, followed by recent activity
      */
     void displaySystemStats();
     
     /**
-     * Find driver by ID
+     * Ride activity over a rolling window ending now
+     * Costs O(buckets) - one per minute up to 24 hours, one per hour beyond
+     * Rides loaded from a snapshot or journal have no request time and are not included
+     * @param windowMillis Window length in milliseconds (rounded up to whole buckets)
+     * @return Requests, completions and revenue by ride type
+     */
+    TimeWindowStats recentActivity(int64_t windowMillis);
+    
+    /**
+     * Ride activity per minute or per hour, oldest first, the last bucket holding now
+     * @param count Number of buckets (up to 24 hours of minutes or 7 days of hours)
+     * @param hourly True for hour buckets, false for minute buckets
+     * @return One entry per bucket, empty buckets included
+     */
+    std::vector<TimeWindowStats> activitySeries(size_t count, bool hourly);
+    
+    /**
+     * Display activity over the last 15 minutes, hour and day, with the last hour by type
+     */
+    void displayRecentActivity();
+    
+    /**
+     * Best drivers by earnings, ride count or rating
+     * O(log n + k): rankings are kept up to date as rides and ratings change
+     * @param metric Ranking to read
+     * @param k Maximum number of drivers
+     * @return Up to k drivers with their scores, best first (ties by lower ID)
+     */
+    std::vector<LeaderboardEntry> topDrivers(LeaderboardMetric metric, size_t k);
+    
+    /**
+     * Position of a driver in a ranking in O(log n)
+     * @param driverID Driver ID
+     * @param metric Ranking to read
+     * @return 1 for the best driver, 0 if the driver does not exist
+     */
+    size_t driverRank(int driverID, LeaderboardMetric metric);
+    
+    /**
+     * Display the top drivers by earnings, ride count and rating
+     * @param k Drivers listed per ranking
+     */
+    void displayLeaderboard(size_t k = 5);
+    
+    /**
+     * Change how demand turns into surge (zones, window, thresholds)
+     * @param policy New surge policy
+     */
+    void setSurgePolicy(const SurgePolicy& policy);
+    
+    /**
+     * Recent requests, idle drivers and the surge a request would be quoted now
+     * @param point Any position in the zone
+     * @return Zone figures
+     */
+    ZoneDemand zoneDemand(GeoPoint point);
+    
+    /**
+     * Zones currently quoting above 1.0x, highest surge first
+     * @return Surging zones
+     */
+    std::vector<ZoneDemand> surgingZones();
+    
+    /**
+     * Write drivers, riders, rides and ID counters to a binary snapshot
+     * Run while no other thread is changing the system
+     * @param path Snapshot file (replaced atomically)
+     * @return False if writing failed or the system holds Custom rides
+     */
+    bool saveSnapshot(const std::string& path);
+    
+    /**
+     * Map a snapshot as the starting state of an empty system
+     * Only the ride columns are copied; drivers, riders and ride objects
+     * are materialized lazily, so loading takes milliseconds even for
+     * millions of rides. Call before the system is shared between threads.
+     * @param path Snapshot file
+     * @return False if the system is not empty or the file is unusable
+     */
+    bool loadSnapshot(const std::string& path);
+    
+    /**
+     * Open a write-ahead journal, replaying the events already in it
+     * Call after loadSnapshot() (if any) and before the system is shared
+     * between threads. saveSnapshot() empties the journal once the snapshot
+     * holds its contents. Driver positions and availability are not journaled.
+     * @param path Journal file (created if missing)
+     * @param options Sync policy and group commit latency bound
+     * @return False if the journal cannot be opened or one is already open
+     */
+    bool openJournal(const std::string& path, const JournalOptions& options = JournalOptions());
+    
+    /**
+     * Rate a driver through the system so the change is journaled
+     * @param driverID Driver ID
+     * @param newRating Rating from the latest ride (1.0 - 5.0)
+     * @return True if the driver exists and the rating was applied
+     */
+    bool updateDriverRating(int driverID, double newRating);
+    
+    /**
+     * Find driver by ID in O(1) through the ID index
+     * Wait-free for every ID the system hands out, whatever the driver count
      * @param id Driver ID
      * @return Pointer to driver or nullptr if not found
      */
     Driver* findDriver(int id);
     
     /**
-     * Find rider by ID
+     * Find rider by ID in O(1) through the ID index
+     * Wait-free for every ID the system hands out, whatever the rider count
      * @param id Rider ID
      * @return Pointer to rider or nullptr if not found
      */
     Rider* findRider(int id);
+    
+    /**
+     * Columnar view of all rides for dense aggregate queries
+     * Not synchronized - only read it while no other thread is creating,
+     * re-pricing or cancelling rides (use computeStats() otherwise)
+     * @return Read-only ride store
+     */
+    const RideStore& getRideStore() const { return rideStore; }
+    
+    /**
+     * Counters, latency histograms and gauges of this system
+     * @return Registry for reading values or changing the latency sample interval
+     */
+    MetricsRegistry& getMetrics() { return metrics; }
+    
+    /**
+     * Display counters, gauges and latency percentiles
+     */
+    void displayMetrics();
+    
+    /**
+     * Write all metrics in Prometheus text format
+     * @param path Output file (replaced atomically)
+     * @return False on I/O error
+     */
+    bool exportMetrics(const std::string& path);
 };
 
 #endif // RIDE_SHARING_SYSTEM_H
@@ -0,0 +1,128 @@
+#include "RideStore.h"
+#include "FareKernel.h"
+#include <algorithm>
+#include <cmath>
+
+size_t RideStore::append(const Ride& ride, int driverID, int riderID) {
+    return append(ride, driverID, riderID, ride.computeFare());
+}
+
+size_t RideStore::append(const Ride& ride, int driverID, int riderID, double fare) {
+    int rideID = ride.getRideID();
+    if (rideIDs.empty() || rideID > rideIDs.back()) {
+        size_t row = rideIDs.size();
+        rideIDs.push_back(rideID);
+        types.push_back(ride.getType());
+        distances.push_back(ride.getDistance());
+        fares.push_back(fare);
+        surgePercents.push_back(ride.getSurgePercent());
+        pickupIDs.push_back(ride.getPickupID());
+        dropoffIDs.push_back(ride.getDropoffID());
+        driverIDs.push_back(driverID);
+        riderIDs.push_back(riderID);
+        return row;
+    }
+    
+    // A concurrent dispatcher committed a higher ID first; the slot is near the end
+    size_t row = static_cast<size_t>(std::upper_bound(rideIDs.begin(), rideIDs.end(), rideID) - rideIDs.begin());
+    rideIDs.insert(rideIDs.begin() + row, rideID);
+    types.insert(types.begin() + row, ride.getType());
+    distances.insert(distances.begin() + row, ride.getDistance());
+    fares.insert(fares.begin() + row, fare);
+    surgePercents.insert(surgePercents.begin() + row, ride.getSurgePercent());
+    pickupIDs.insert(pickupIDs.begin() + row, ride.getPickupID());
+    dropoffIDs.insert(dropoffIDs.begin() + row, ride.getDropoffID());
+    driverIDs.insert(driverIDs.begin() + row, driverID);
+    riderIDs.insert(riderIDs.begin() + row, riderID);
+    return row;
+}
+
+void RideStore::reserve(size_t count) {
+    rideIDs.reserve(count);
+    types.reserve(count);
+    distances.reserve(count);
+    fares.reserve(count);
+    surgePercents.reserve(count);
+    pickupIDs.reserve(count);
+    dropoffIDs.reserve(count);
+    driverIDs.reserve(count);
+    riderIDs.reserve(count);
+}
+
+void RideStore::assign(size_t count, const int* ids, const RideType* rideTypes,
+                       const double* rideDistances, const double* rideFares,
+                       const uint32_t* pickups, const uint32_t* dropoffs,
+                       const int* drivers, const int* riders, const uint16_t* surges) {
+    rideIDs.assign(ids, ids + count);
+    types.assign(rideTypes, rideTypes + count);
+    distances.assign(rideDistances, rideDistances + count);
+    fares.assign(rideFares, rideFares + count);
+    if (surges) {
+        surgePercents.assign(surges, surges + count);
+    } else {
+        surgePercents.assign(count, 100);
+        for (size_t row = 0; row < count; ++row) {
+            double unsurged = rideFare(types[row], distances[row]);
+            if (unsurged > 0.0 && fares[row] != unsurged) {
+                surgePercents[row] = static_cast<uint16_t>(std::lround(fares[row] / unsurged * 100.0));
+            }
+        }
+    }
+    pickupIDs.assign(pickups, pickups + count);
+    dropoffIDs.assign(dropoffs, dropoffs + count);
+    driverIDs.assign(drivers, drivers + count);
+    riderIDs.assign(riders, riders + count);
+}
+
+bool RideStore::findRow(int rideID, size_t& row) const {
+    auto it = std::lower_bound(rideIDs.begin(), rideIDs.end(), rideID);
+    if (it == rideIDs.end() || *it != rideID) {
+        return false;
+    }
+    row = static_cast<size_t>(it - rideIDs.begin());
+    return true;
+}
+
+void RideStore::updatePrice(size_t row, double distance, double fare) {
+    distances[row] = distance;
+    fares[row] = fare;
+}
+
+void RideStore::recomputeFares() {
+    std::vector<double> priced(fares.size());
+    FareKernel::computeFares(distances.data(), types.data(), surgePercents.data(), priced.data(), priced.size());
+    for (size_t row = 0; row < fares.size(); ++row) {
+        if (types[row] != RideType::Custom) {
+            fares[row] = priced[row];
+        }
+    }
+}
+
+void RideStore::erase(size_t row) {
+    rideIDs.erase(rideIDs.begin() + row);
+    types.erase(types.begin() + row);
+    distances.erase(distances.begin() + row);
+    fares.erase(fares.begin() + row);
+    surgePercents.erase(surgePercents.begin() + row);
+    pickupIDs.erase(pickupIDs.begin() + row);
+    dropoffIDs.erase(dropoffIDs.begin() + row);
+    driverIDs.erase(driverIDs.begin() + row);
+    riderIDs.erase(riderIDs.begin() + row);
+}
+
+double RideStore::totalRevenue() const {
+    double total = 0.0;
+    for (double fare : fares) {
+        total += fare;
+    }
+    return total;
+}
+
+std::shared_ptr<Ride> RideStore::makeRide(size_t row) const {
+    std::shared_ptr<Ride> ride = ::makeRide(types[row], rideIDs[row], locationName(pickupIDs[row]),
+                                            locationName(dropoffIDs[row]), distances[row]);
+    if (ride) {
+        ride->setSurgePercent(surgePercents[row]);
+    }
+    return ride;
+}
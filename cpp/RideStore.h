@@ -0,0 +1,144 @@
+#ifndef RIDE_STORE_H
+#define RIDE_STORE_H
+
+#include "Ride.h"
+#include <vector>
+#include <memory>
+#include <string_view>
+#include <cstdint>
+
+/**
+ * RideStore - Columnar (struct-of-arrays) storage for every ride in the system
+ * Each column is a contiguous array so aggregate scans run over dense memory
+ * instead of chasing a pointer and making a virtual call per ride
+ * Not synchronized - RideSharingSystem guards it with its ride log lock
+ */
+class RideStore {
+private:
+    // One entry per ride, all columns share the same row index
+    std::vector<int> rideIDs;
+    std::vector<RideType> types;
+    std::vector<double> distances;
+    std::vector<double> fares;         // Quoted fares, surge included
+    std::vector<uint16_t> surgePercents; // Surge multiplier of each ride in percent (100 = none)
+    std::vector<uint32_t> pickupIDs;   // IDs from LocationPool::global()
+    std::vector<uint32_t> dropoffIDs;
+    std::vector<int> driverIDs;
+    std::vector<int> riderIDs;
+
+public:
+    /**
+     * Append a ride as a new row
+     * The fare is evaluated once here so later scans never call fare()
+     * Rows stay sorted by ride ID; a ride arriving after a higher ID (from a
+     * concurrent dispatcher) is inserted before it
+     * @param ride Ride to copy into the columns
+     * @param driverID ID of the assigned driver
+     * @param riderID ID of the requesting rider
+     * @return Row index of the new entry
+     */
+    size_t append(const Ride& ride, int driverID, int riderID);
+
+    /**
+     * Append a ride whose fare was already computed (e.g. by FareKernel)
+     * @param ride Ride to copy into the columns
+     * @param driverID ID of the assigned driver
+     * @param riderID ID of the requesting rider
+     * @param fare Precomputed fare of the ride
+     * @return Row index of the new entry
+     */
+    size_t append(const Ride& ride, int driverID, int riderID, double fare);
+
+    /**
+     * Locate the row of a ride (binary search over the sorted ID column)
+     * @param rideID Ride ID
+     * @param row Receives the row index if found
+     * @return True if the ride is stored
+     */
+    bool findRow(int rideID, size_t& row) const;
+
+    /**
+     * Overwrite the distance and fare of a row after re-pricing
+     * @param row Row index
+     * @param distance New distance
+     * @param fare New fare
+     */
+    void updatePrice(size_t row, double distance, double fare);
+
+    /**
+     * Re-evaluate the fare column for built-in ride types with the batch
+     * fare kernel, keeping each ride's quoted surge (Custom rows keep their stored fare)
+     */
+    void recomputeFares();
+
+    /**
+     * Remove a row, keeping the remaining rows in ID order
+     * @param row Row index
+     */
+    void erase(size_t row);
+
+    /**
+     * Replace every column with bulk-copied data (used when loading a snapshot)
+     * Surge multipliers are recovered from the fares (fare / unsurged fare,
+     * rounded to a whole percent), so they need no column of their own
+     * @param count Number of rows
+     * @param ids Ride IDs, strictly increasing
+     * @param rideTypes Ride types
+     * @param rideDistances Distances
+     * @param rideFares Fares
+     * @param pickups Pickup location IDs from LocationPool::global()
+     * @param dropoffs Dropoff location IDs from LocationPool::global()
+     * @param drivers Driver IDs
+     * @param riders Rider IDs
+     * @param surges Quoted surge percents, or nullptr to derive them from the
+     *               fares (for sources that did not store them; rides with an
+     *               unsurged fare of 0 then come back unsurged)
+     */
+    void assign(size_t count, const int* ids, const RideType* rideTypes,
+                const double* rideDistances, const double* rideFares,
+                const uint32_t* pickups, const uint32_t* dropoffs,
+                const int* drivers, const int* riders, const uint16_t* surges);
+
+    /**
+     * Reserve capacity in every column
+     * @param count Expected total number of rides
+     */
+    void reserve(size_t count);
+
+    /**
+     * Sum of all stored fares
+     * @return Total revenue
+     */
+    double totalRevenue() const;
+
+    /**
+     * Resolve an interned location ID
+     * @param id Location ID from the pickup or dropoff column
+     * @return Location name
+     */
+    std::string_view locationName(uint32_t id) const { return LocationPool::global().name(id); }
+
+    /**
+     * Build a Ride object view of a stored row
+     * Ride objects are optional - scans should use the columns directly
+     * @param row Row index
+     * @return Newly constructed ride of the stored type (nullptr for Custom rows)
+     */
+    std::shared_ptr<Ride> makeRide(size_t row) const;
+
+    // Column accessors for dense scans
+    size_t size() const { return rideIDs.size(); }
+    size_t capacity() const { return rideIDs.capacity(); }
+    bool empty() const { return rideIDs.empty(); }
+    const std::vector<int>& getRideIDs() const { return rideIDs; }
+    const std::vector<RideType>& getTypes() const { return types; }
+    const std::vector<double>& getDistances() const { return distances; }
+    const std::vector<double>& getFares() const { return fares; }
+    const std::vector<uint16_t>& getSurgePercents() const { return surgePercents; }
+    const std::vector<uint32_t>& getPickupIDs() const { return pickupIDs; }
+    const std::vector<uint32_t>& getDropoffIDs() const { return dropoffIDs; }
+    const std::vector<int>& getDriverIDs() const { return driverIDs; }
+    const std::vector<int>& getRiderIDs() const { return riderIDs; }
+};
+
+#endif // RIDE_STORE_H
@@ -0,0 +1,55 @@
+#include "RideTable.h"
+
+RideTable::Slot* RideTable::slotFor(int rideID, bool create) {
+    if (rideID < 0) {
+        return nullptr;
+    }
+    size_t slot = static_cast<size_t>(rideID);
+    Slot* slots = create ? chunks.allocate(slot) : chunks.chunk(slot);
+    return slots ? &slots[SlotDirectory::offset(slot)] : nullptr;
+}
+
+const RideTable::Slot* RideTable::slotFor(int rideID) const {
+    if (rideID < 0) {
+        return nullptr;
+    }
+    size_t slot = static_cast<size_t>(rideID);
+    const Slot* slots = chunks.chunk(slot);
+    return slots ? &slots[SlotDirectory::offset(slot)] : nullptr;
+}
+
+bool RideTable::insert(std::shared_ptr<Ride> ride) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Slot* slot = slotFor(ride->getRideID(), true);
+    if (!slot) {
+        return false;
+    }
+    if (!slot->owner) {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot->ride.store(ride.get(), std::memory_order_release);
+    slot->owner = std::move(ride);
+    return true;
+}
+
+std::shared_ptr<Ride> RideTable::release(int rideID) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Slot* slot = slotFor(rideID, false);
+    if (!slot || !slot->owner) {
+        return nullptr;
+    }
+    count.fetch_sub(1, std::memory_order_relaxed);
+    slot->ride.store(nullptr, std::memory_order_release);
+    return std::move(slot->owner);
+}
+
+Ride* RideTable::find(int rideID) const {
+    const Slot* slot = slotFor(rideID);
+    return slot ? slot->ride.load(std::memory_order_acquire) : nullptr;
+}
+
+std::shared_ptr<Ride> RideTable::get(int rideID) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Slot* slot = slotFor(rideID);
+    return slot ? slot->owner : nullptr;
+}
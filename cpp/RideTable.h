@@ -0,0 +1,83 @@
+#ifndef RIDE_TABLE_H
+#define RIDE_TABLE_H
+
+#include "ChunkDirectory.h"
+#include "Ride.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+/**
+ * RideTable - The single owner of a system's ride objects, indexed by ride ID
+ * Drivers and riders keep only the 4-byte ride IDs and resolve them here, so
+ * a ride costs one table slot instead of three shared_ptr copies and adding
+ * it to a driver or rider never touches a reference count. Ride IDs only
+ * ever increment and are never reused, so an ID doubles as a handle that
+ * cannot alias a later ride after cancellation.
+ *
+ * Thread safety: insert/release/get are serialized internally. Slots live in
+ * fixed-size chunks that never move, so find() is lock-free. The chunk
+ * directory covers every non-negative int, so the table holds any ride ID
+ * the system can issue. A pointer from
+ * find() stays valid until the ride is released; the system releases a ride
+ * only after removing it from its driver and rider, so an ID still listed by
+ * a driver or rider always resolves.
+ */
+class RideTable {
+private:
+    struct Slot {
+        std::atomic<Ride*> ride{nullptr}; // Read lock-free by find()
+        std::shared_ptr<Ride> owner;      // Only touched under the mutex
+    };
+
+    using SlotDirectory = ChunkDirectory<Slot, 12, 31>; // Slots for ride IDs 0 .. INT_MAX
+
+    SlotDirectory chunks;
+    std::atomic<size_t> count{0};
+    mutable std::mutex mutex; // Serializes writers and shared-ownership reads
+
+    // Caller holds the mutex when creating; nullptr if the ID is negative or not allocated
+    Slot* slotFor(int rideID, bool create);
+    const Slot* slotFor(int rideID) const;
+
+public:
+    RideTable() = default;
+    RideTable(const RideTable&) = delete;
+    RideTable& operator=(const RideTable&) = delete;
+
+    /**
+     * Take ownership of a ride under its ID, replacing any previous entry
+     * @param ride Ride to store (must not be nullptr)
+     * @return False (and nothing stored) if the ride ID is negative
+     */
+    bool insert(std::shared_ptr<Ride> ride);
+
+    /**
+     * Remove a ride from the table
+     * @param rideID Ride ID
+     * @return The table's reference to the ride, or nullptr if not stored
+     */
+    std::shared_ptr<Ride> release(int rideID);
+
+    /**
+     * Resolve a ride ID without locking
+     * @param rideID Ride ID
+     * @return The ride, or nullptr if not stored
+     */
+    Ride* find(int rideID) const;
+
+    /**
+     * Resolve a ride ID to a shared reference that outlives a later release
+     * @param rideID Ride ID
+     * @return The ride, or nullptr if not stored
+     */
+    std::shared_ptr<Ride> get(int rideID) const;
+
+    /**
+     * Number of rides stored
+     */
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+};
+
+#endif // RIDE_TABLE_H
@@ -0,0 +1,142 @@
+#include "RideTimeSeries.h"
+#include <algorithm>
+#include <chrono>
+
+int64_t wallClockMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint64_t TimeWindowStats::requestCount() const {
+    uint64_t total = 0;
+    for (uint64_t count : requests) {
+        total += count;
+    }
+    return total;
+}
+
+uint64_t TimeWindowStats::completionCount() const {
+    uint64_t total = 0;
+    for (uint64_t count : completions) {
+        total += count;
+    }
+    return total;
+}
+
+double TimeWindowStats::revenue() const {
+    int64_t total = 0;
+    for (int64_t micros : revenueMicros) {
+        total += micros;
+    }
+    return total / 1e6;
+}
+
+RideTimeSeries::Bucket* RideTimeSeries::Ring::bucketFor(int64_t at, bool create) {
+    if (at <= 0) {
+        return nullptr;
+    }
+    int64_t index = at / width;
+    int64_t size = static_cast<int64_t>(buckets.size());
+    if (index <= latest - size) {
+        return nullptr; // Older than anything the ring still holds
+    }
+    Bucket& bucket = buckets[static_cast<size_t>(index % size)];
+    if (bucket.index != index) {
+        if (!create) {
+            return nullptr;
+        }
+        bucket = Bucket();
+        bucket.index = index;
+        latest = std::max(latest, index);
+    }
+    return &bucket;
+}
+
+void RideTimeSeries::Ring::addTo(TimeWindowStats& stats, int64_t firstIndex, int64_t lastIndex) const {
+    int64_t size = static_cast<int64_t>(buckets.size());
+    for (int64_t index = std::max<int64_t>(firstIndex, 0); index <= lastIndex; ++index) {
+        const Bucket& bucket = buckets[static_cast<size_t>(index % size)];
+        if (bucket.index != index) {
+            continue; // Never written, or since reused for a newer range
+        }
+        for (size_t t = 0; t < RIDE_TYPE_COUNT; ++t) {
+            stats.requests[t] += bucket.requests[t];
+            stats.completions[t] += bucket.completions[t];
+            stats.revenueMicros[t] += bucket.revenueMicros[t];
+        }
+    }
+}
+
+RideTimeSeries::RideTimeSeries() : minutes(MINUTE_MILLIS, MINUTE_BUCKETS), hours(HOUR_MILLIS, HOUR_BUCKETS) {}
+
+void RideTimeSeries::recordRequest(RideType type, double fare, int64_t requestedAt) {
+    size_t slot = static_cast<size_t>(type);
+    int64_t micros = toMicros(fare);
+    for (Ring* ring : {&minutes, &hours}) {
+        if (Bucket* bucket = ring->bucketFor(requestedAt, true)) {
+            bucket->requests[slot]++;
+            bucket->revenueMicros[slot] += micros;
+        }
+    }
+}
+
+void RideTimeSeries::recordCompletion(RideType type, int64_t completedAt) {
+    size_t slot = static_cast<size_t>(type);
+    for (Ring* ring : {&minutes, &hours}) {
+        if (Bucket* bucket = ring->bucketFor(completedAt, true)) {
+            bucket->completions[slot]++;
+        }
+    }
+}
+
+void RideTimeSeries::recordReprice(RideType type, double oldFare, double newFare, int64_t requestedAt) {
+    size_t slot = static_cast<size_t>(type);
+    int64_t delta = toMicros(newFare) - toMicros(oldFare);
+    for (Ring* ring : {&minutes, &hours}) {
+        if (Bucket* bucket = ring->bucketFor(requestedAt, false)) {
+            bucket->revenueMicros[slot] += delta;
+        }
+    }
+}
+
+void RideTimeSeries::recordCancel(RideType type, double fare, int64_t requestedAt, int64_t completedAt) {
+    size_t slot = static_cast<size_t>(type);
+    int64_t micros = toMicros(fare);
+    for (Ring* ring : {&minutes, &hours}) {
+        if (Bucket* bucket = ring->bucketFor(requestedAt, false)) {
+            bucket->requests[slot]--;
+            bucket->revenueMicros[slot] -= micros;
+        }
+        if (Bucket* bucket = ring->bucketFor(completedAt, false)) {
+            bucket->completions[slot]--;
+        }
+    }
+}
+
+TimeWindowStats RideTimeSeries::window(int64_t now, int64_t windowMillis) const {
+    const Ring& ring = (windowMillis <= static_cast<int64_t>(MINUTE_BUCKETS) * MINUTE_MILLIS) ? minutes : hours;
+    int64_t count = std::max<int64_t>(1, (windowMillis + ring.width - 1) / ring.width);
+    count = std::min<int64_t>(count, static_cast<int64_t>(ring.buckets.size()));
+    int64_t lastIndex = now / ring.width;
+
+    TimeWindowStats stats;
+    stats.start = (lastIndex - count + 1) * ring.width;
+    stats.end = (lastIndex + 1) * ring.width;
+    ring.addTo(stats, lastIndex - count + 1, lastIndex);
+    return stats;
+}
+
+std::vector<TimeWindowStats> RideTimeSeries::series(int64_t now, size_t count, bool hourly) const {
+    const Ring& ring = hourly ? hours : minutes;
+    count = std::min(count, ring.buckets.size());
+    int64_t lastIndex = now / ring.width;
+
+    std::vector<TimeWindowStats> result(count);
+    for (size_t i = 0; i < count; ++i) {
+        int64_t index = lastIndex - static_cast<int64_t>(count - 1 - i);
+        result[i].start = index * ring.width;
+        result[i].end = (index + 1) * ring.width;
+        ring.addTo(result[i], index, index);
+    }
+    return result;
+}
@@ -0,0 +1,139 @@
+#ifndef RIDE_TIME_SERIES_H
+#define RIDE_TIME_SERIES_H
+
+#include "Ride.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Current wall-clock time in milliseconds since the Unix epoch
+ * (the unit of ride timestamps)
+ */
+int64_t wallClockMillis();
+
+/**
+ * Ride activity over one time range, broken down by ride type
+ * Revenue is attributed to the time the ride was requested, so it matches
+ * the system totals once every ride in the range has been counted.
+ */
+struct TimeWindowStats {
+    int64_t start = 0; // First millisecond of the range
+    int64_t end = 0;   // One past the last millisecond
+    uint64_t requests[RIDE_TYPE_COUNT] = {};
+    uint64_t completions[RIDE_TYPE_COUNT] = {};
+    int64_t revenueMicros[RIDE_TYPE_COUNT] = {};
+
+    uint64_t requestCount(RideType type) const { return requests[static_cast<size_t>(type)]; }
+    uint64_t completionCount(RideType type) const { return completions[static_cast<size_t>(type)]; }
+    double revenue(RideType type) const { return revenueMicros[static_cast<size_t>(type)] / 1e6; }
+    uint64_t requestCount() const;
+    uint64_t completionCount() const;
+    double revenue() const;
+};
+
+/**
+ * RideTimeSeries - Incremental per-minute and per-hour ride aggregates
+ * Every request, completion, re-price and cancellation updates one bucket
+ * in each of two ring buffers (the last 24 hours by minute, the last 7 days
+ * by hour), so rolling-window queries cost O(buckets) however many rides
+ * there are. A ring slot remembers which minute or hour it holds and is
+ * cleared when time wraps around to it; events older than a ring are only
+ * kept by the longer one. Fares are kept as integer micro-dollars (like
+ * RideTotals), so cancelling a ride returns its bucket to the exact value
+ * it had before.
+ *
+ * Not synchronized: the owner serializes updates and queries.
+ */
+class RideTimeSeries {
+public:
+    static constexpr int64_t MINUTE_MILLIS = 60 * 1000;
+    static constexpr int64_t HOUR_MILLIS = 60 * MINUTE_MILLIS;
+    static constexpr size_t MINUTE_BUCKETS = 24 * 60; // 24 hours by minute
+    static constexpr size_t HOUR_BUCKETS = 7 * 24;    // 7 days by hour
+
+private:
+    struct Bucket {
+        int64_t index = -1; // Minute or hour since the epoch held by this slot, -1 if empty
+        uint32_t requests[RIDE_TYPE_COUNT] = {};
+        uint32_t completions[RIDE_TYPE_COUNT] = {};
+        int64_t revenueMicros[RIDE_TYPE_COUNT] = {};
+    };
+
+    /**
+     * One ring of equally sized buckets
+     */
+    struct Ring {
+        int64_t width;  // Bucket width in milliseconds
+        int64_t latest; // Newest bucket index written so far
+        std::vector<Bucket> buckets;
+
+        Ring(int64_t bucketWidth, size_t count) : width(bucketWidth), latest(-1), buckets(count) {}
+
+        // Bucket holding a time, cleared if it held an older range; nullptr if out of range
+        Bucket* bucketFor(int64_t at, bool create);
+        void addTo(TimeWindowStats& stats, int64_t firstIndex, int64_t lastIndex) const;
+    };
+
+    Ring minutes;
+    Ring hours;
+
+    static int64_t toMicros(double amount) { return std::llround(amount * 1e6); }
+
+public:
+    RideTimeSeries();
+
+    /**
+     * Count a requested ride and its fare
+     * @param type Ride type
+     * @param fare Quoted fare
+     * @param requestedAt Request time (ms since epoch; 0 = unknown, not counted)
+     */
+    void recordRequest(RideType type, double fare, int64_t requestedAt);
+
+    /**
+     * Count a completed ride in the bucket of its completion time
+     * @param type Ride type
+     * @param completedAt Completion time (ms since epoch)
+     */
+    void recordCompletion(RideType type, int64_t completedAt);
+
+    /**
+     * Replace the fare recorded for a ride (re-pricing)
+     * @param type Ride type
+     * @param oldFare Fare the ride was recorded with
+     * @param newFare New fare
+     * @param requestedAt Request time the ride was recorded under
+     */
+    void recordReprice(RideType type, double oldFare, double newFare, int64_t requestedAt);
+
+    /**
+     * Remove a cancelled ride from the bucket it was requested in
+     * @param type Ride type
+     * @param fare Fare the ride was recorded with
+     * @param requestedAt Request time the ride was recorded under
+     * @param completedAt Completion time, or 0 if it was not completed
+     */
+    void recordCancel(RideType type, double fare, int64_t requestedAt, int64_t completedAt);
+
+    /**
+     * Activity over a rolling window ending now, in whole buckets
+     * Windows up to 24 hours use minute buckets, longer ones hour buckets
+     * @param now Current time (ms since epoch)
+     * @param windowMillis Window length; rounded up to whole buckets
+     * @return Totals over the window
+     */
+    TimeWindowStats window(int64_t now, int64_t windowMillis) const;
+
+    /**
+     * Activity of each of the last buckets of a ring, oldest first
+     * @param now Current time (ms since epoch)
+     * @param count Number of buckets (at most the ring size), the last one holding now
+     * @param hourly True for hour buckets, false for minute buckets
+     * @return One entry per bucket, empty buckets included
+     */
+    std::vector<TimeWindowStats> series(int64_t now, size_t count, bool hourly) const;
+};
+
+#endif // RIDE_TIME_SERIES_H
@@ -0,0 +1,70 @@
+#ifndef RIDE_TOTALS_H
+#define RIDE_TOTALS_H
+
+#include "Ride.h"
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * RideTotals - Running fare total, ride count and per-type breakdown
+ * Fares are accumulated as integer micro-dollars so adding and later
+ * removing the same fare always returns the total to its exact previous
+ * value, no matter how many re-pricings or cancellations happen in between
+ */
+class RideTotals {
+private:
+    int64_t fareMicros[RIDE_TYPE_COUNT] = {};
+    size_t rideCounts[RIDE_TYPE_COUNT] = {};
+    int64_t totalMicros = 0;
+    size_t totalCount = 0;
+
+    static int64_t toMicros(double amount) { return std::llround(amount * 1e6); }
+    static size_t slot(RideType type) { return static_cast<size_t>(type); }
+
+public:
+    /**
+     * Record a ride
+     * @param type Ride type
+     * @param fare Ride fare
+     */
+    void add(RideType type, double fare) {
+        int64_t micros = toMicros(fare);
+        fareMicros[slot(type)] += micros;
+        rideCounts[slot(type)]++;
+        totalMicros += micros;
+        totalCount++;
+    }
+
+    /**
+     * Remove a previously recorded ride (cancellation)
+     * @param type Ride type
+     * @param fare Fare the ride was recorded with
+     */
+    void remove(RideType type, double fare) {
+        int64_t micros = toMicros(fare);
+        fareMicros[slot(type)] -= micros;
+        rideCounts[slot(type)]--;
+        totalMicros -= micros;
+        totalCount--;
+    }
+
+    /**
+     * Replace the fare of a recorded ride (re-pricing)
+     * @param type Ride type
+     * @param oldFare Fare the ride was recorded with
+     * @param newFare New fare
+     */
+    void reprice(RideType type, double oldFare, double newFare) {
+        int64_t delta = toMicros(newFare) - toMicros(oldFare);
+        fareMicros[slot(type)] += delta;
+        totalMicros += delta;
+    }
+
+    double total() const { return totalMicros / 1e6; }
+    size_t count() const { return totalCount; }
+    double total(RideType type) const { return fareMicros[slot(type)] / 1e6; }
+    size_t count(RideType type) const { return rideCounts[slot(type)]; }
+};
+
+#endif // RIDE_TOTALS_H
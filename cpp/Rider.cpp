@@ -1,56 +1,168 @@
 #include "Rider.h"
+#include "Logger.h"
+#include "FareKernel.h"
 #include <iostream>
-#include <iomanip>
+#include <algorithm>
 
-Rider::Rider(int id, const std::string& riderName, const std::string& payment)
-    : riderID(id), name(riderName), paymentMethod(payment) {
-    std::cout << "[LOG] Created rider: " << name << " (ID: " << riderID << ")" << std::endl;
+Rider::Rider(int id, const std::string& riderName, const std::string& payment, const RideTable* rides)
+    : riderID(id), name(riderName), paymentMethod(payment), rideTable(rides) {
+    LOG_INFO("Created rider: " << name << " (ID: " << riderID << ")");
 }
 
-void Rider::requestRide(std::shared_ptr<Ride> ride) {
-    if (ride) {
-        requestedRides.push_back(ride);
-        std::cout << "[LOG] Rider " << name << " requested ride ID: " << ride->getRideID() << std::endl;
+void Rider::requestRide(const Ride& ride, double fare) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requestedRides.push_back(ride.getRideID());
+        totals.add(ride.getType(), fare);
+    }
+    LOG_INFO("Rider " << name << " requested ride ID: " << ride.getRideID());
+}
+
+bool Rider::removeRide(const Ride& ride) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find(requestedRides.begin(), requestedRides.end(), ride.getRideID());
+    if (it == requestedRides.end()) {
+        return false;
+    }
+    totals.remove(ride.getType(), ride.computeFare());
+    requestedRides.erase(it);
+    return true;
+}
+
+void Rider::updateRideFare(RideType type, double oldFare, double newFare) {
+    std::lock_guard<std::mutex> lock(mutex);
+    totals.reprice(type, oldFare, newFare);
+}
+
+void Rider::recomputeTotals() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!rideTable) {
+        return;
+    }
+    // The system releases a ride only after removing it here, so every listed ID
+    // should resolve; one that does not is left out of the totals rather than read
+    std::vector<const Ride*> rides;
+    std::vector<double> distances;
+    std::vector<RideType> types;
+    rides.reserve(requestedRides.size());
+    distances.reserve(requestedRides.size());
+    types.reserve(requestedRides.size());
+    for (int rideID : requestedRides) {
+        const Ride* ride = rideTable->find(rideID);
+        if (!ride) {
+            LOG_ERROR("Rider " << riderID << " lists unknown ride ID " << rideID);
+            continue;
+        }
+        rides.push_back(ride);
+        distances.push_back(ride->getDistance());
+        types.push_back(ride->getType());
+    }
+    std::vector<double> fares(distances.size());
+    FareKernel::computeFares(distances.data(), types.data(), fares.data(), fares.size());
+    
+    totals = RideTotals();
+    for (size_t i = 0; i < fares.size(); ++i) {
+        // Extension rides have no static policy and are priced virtually
+        double fare = (types[i] == RideType::Custom) ? rides[i]->computeFare()
+                                                     : fares[i] * rides[i]->getSurgeMultiplier();
+        totals.add(types[i], fare);
+    }
+}
+
+void Rider::restoreRides(std::vector<int> rideIDs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requestedRides = std::move(rideIDs);
+    }
+    recomputeTotals();
+}
+
+std::vector<int> Rider::getRideIDs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return requestedRides;
+}
+
+void Rider::reserveRides(size_t additional) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t needed = requestedRides.size() + additional;
+    if (needed > requestedRides.capacity()) {
+        // Keep geometric growth so repeated small batches stay amortized O(1)
+        requestedRides.reserve(std::max(needed, requestedRides.capacity() * 2));
     }
 }
 
 void Rider::viewRides() const {
-    std::cout << "\n=== Ride History for " << name << " ===" << std::endl;
+    Logger::instance().flush(); // Keep queued log records ahead of the report
+    ReportWriter out(std::cout);
+    writeHistory(out);
+}
+
+ReportCursor Rider::writeHistory(ReportWriter& out, const ReportPage& page) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    ReportBuffer& text = out.buffer();
+    text << "\n=== Ride History for " << name << " ===\n";
     
+    ReportRange range(requestedRides, page);
     if (requestedRides.empty()) {
-        std::cout << "No rides requested yet." << std::endl;
-        return;
+        text << "No rides requested yet.\n";
+        return range.cursor(requestedRides, page.limit);
     }
     
-    for (size_t i = 0; i < requestedRides.size(); ++i) {
-        const auto& ride = requestedRides[i];
-        std::cout << "\n--- Ride " << (i + 1) << " ---" << std::endl;
-        ride->rideDetails();
+    for (size_t i = range.first; i < range.last; ++i) {
+        text << "\n--- Ride " << (i + 1) << " ---\n";
+        if (const Ride* ride = rideTable ? rideTable->find(requestedRides[i]) : nullptr) {
+            ride->writeDetails(text);
+        } else {
+            text << "Ride ID: " << requestedRides[i] << '\n';
+        }
+        out.endRecord();
     }
     
-    std::cout << "\nTotal Spending: $" << std::fixed << std::setprecision(2) 
-             << getTotalSpending() << std::endl;
+    text << "\nTotal Spending: $" << fixed(totals.total(), 2) << '\n';
+    return range.cursor(requestedRides, page.limit);
 }
 
 double Rider::getTotalSpending() const {
-    double total = 0.0;
-    for (const auto& ride : requestedRides) {
-        total += ride->fare();
-    }
-    return total;
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals.total();
+}
+
+std::string Rider::getPaymentMethod() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return paymentMethod;
+}
+
+size_t Rider::getRideCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return requestedRides.size();
+}
+
+RideTotals Rider::getTotals() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals;
 }
 
 void Rider::setPaymentMethod(const std::string& newPayment) {
-    paymentMethod = newPayment;
-    std::cout << "[LOG] Payment method updated to: " << paymentMethod << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        paymentMethod = newPayment;
+    }
+    LOG_INFO("Payment method updated to: " << newPayment);
 }
 
 void Rider::getRiderInfo() const {
-    std::cout << "\n=== Rider Information ===" << std::endl;
-    std::cout << "Rider ID: " << riderID << std::endl;
-    std::cout << "Name: " << name << std::endl;
-    std::cout << "Payment Method: " << paymentMethod << std::endl;
-    std::cout << "Total Rides: " << requestedRides.size() << std::endl;
-    std::cout << "Total Spending: $" << std::fixed << std::setprecision(2) 
-             << getTotalSpending() << std::endl;
+    Logger::instance().flush(); // Keep queued log records ahead of the report
+    ReportWriter out(std::cout);
+    writeInfo(out);
+}
+
+void Rider::writeInfo(ReportWriter& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    ReportBuffer& text = out.buffer();
+    text << "\n=== Rider Information ===\n";
+    text << "Rider ID: " << riderID << '\n';
+    text << "Name: " << name << '\n';
+    text << "Payment Method: " << paymentMethod << '\n';
+    text << "Total Rides: " << requestedRides.size() << '\n';
+    text << "Total Spending: $" << fixed(totals.total(), 2) << '\n';
 }
@@ -2,9 +2,12 @@
 #define RIDER_H
 
 #include "Ride.h"
+#include "RideTable.h"
+#include "RideTotals.h"
 #include <vector>
 #include <memory>
 #include <string>
+#include <mutex>
 
 /**
  * Rider class representing a passenger in the ride sharing system
@@ -15,8 +18,16 @@ private:
     int riderID;
     std::string name;
     std::string paymentMethod;
-    // Private collection - demonstrates encapsulation
-    std::vector<std::shared_ptr<Ride>> requestedRides;
+    // Private collection of 4-byte ride IDs; the rides are owned by the system's RideTable
+    std::vector<int> requestedRides;
+    const RideTable* rideTable; // Resolves requestedRides, nullptr for a standalone rider
+    RideTotals totals; // Maintained incrementally as rides are added or changed
+    mutable std::mutex mutex; // Guards paymentMethod, requestedRides and totals across dispatcher threads
+    
+    // Snapshot support: replace the ride list wholesale and list it by ID
+    friend class RideSharingSystem;
+    void restoreRides(std::vector<int> rideIDs);
+    std::vector<int> getRideIDs() const;
     
 public:
     /**
@@ -24,23 +35,42 @@ public:
      * @param id Unique rider identifier
      * @param riderName Name of the rider
      * @param payment Payment method (default: "Credit Card")
+     * @param rides Table owning the rider's rides (needed to list or re-price them)
      */
-    Rider(int id, const std::string& riderName, const std::string& payment = "Credit Card");
+    Rider(int id, const std::string& riderName, const std::string& payment = "Credit Card",
+          const RideTable* rides = nullptr);
     
     /**
      * Request a ride and add it to the rider's history
-     * Controlled access to private data
-     * @param ride Shared pointer to the ride object
+     * Only the ride ID is kept; the ride itself stays in the ride table
+     * @param ride Requested ride
+     */
+    void requestRide(const Ride& ride) { requestRide(ride, ride.computeFare()); }
+    
+    /**
+     * Add a requested ride at the fare it was logged with
+     * @param ride Requested ride
+     * @param fare Fare recorded for the ride in the ride log
      */
-    void requestRide(std::shared_ptr<Ride> ride);
+    void requestRide(const Ride& ride, double fare);
     
     /**
      * Display all rides requested by this rider
+     * Without a ride table only the ride IDs are listed
      */
     void viewRides() const;
     
     /**
-     * Calculate total spending on rides
+     * Write the ride history, one page at a time
+     * Each page repeats the heading and ends with the total spending
+     * @param out Report destination
+     * @param page Rides to list (default: all)
+     * @return Cursor for the following page
+     */
+    ReportCursor writeHistory(ReportWriter& out, const ReportPage& page = ReportPage()) const;
+    
+    /**
+     * Total spending on rides (O(1), kept up to date incrementally)
      * @return Total amount spent
      */
     double getTotalSpending() const;
@@ -56,11 +86,46 @@ public:
      */
     void getRiderInfo() const;
     
+    /**
+     * Write the rider information summary
+     * @param out Report destination
+     */
+    void writeInfo(ReportWriter& out) const;
+    
+    /**
+     * Pre-allocate room for additional rides (used by batch creation)
+     * @param additional Number of rides about to be added
+     */
+    void reserveRides(size_t additional);
+    
+    /**
+     * Remove a cancelled ride and subtract it from the running totals
+     * @param ride Ride to remove (still priced at its current fare)
+     * @return True if the rider had requested the ride
+     */
+    bool removeRide(const Ride& ride);
+    
+    /**
+     * Adjust running totals after a ride's fare changed
+     * @param type Ride type
+     * @param oldFare Fare before re-pricing
+     * @param newFare Fare after re-pricing
+     */
+    void updateRideFare(RideType type, double oldFare, double newFare);
+    
+    /**
+     * Rebuild the running totals from the ride list using the batch fare kernel
+     * Used to audit or refresh totals after fare policy changes
+     * Needs the ride table; a standalone rider keeps its totals as they are
+     */
+    void recomputeTotals();
+    
     // Getter methods for controlled access
     int getRiderID() const { return riderID; }
     std::string getName() const { return name; }
-    std::string getPaymentMethod() const { return paymentMethod; }
-    size_t getRideCount() const { return requestedRides.size(); }
+    std::string getPaymentMethod() const;
+    size_t getRideCount() const;
+    RideTotals getTotals() const; // Consistent snapshot of the running totals
 };
 
 #endif // RIDER_H
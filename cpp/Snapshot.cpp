@@ -0,0 +1,377 @@
+#include "Snapshot.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[8] = {'R', 'S', 'S', 'N', 'A', 'P', 0, 0};
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+size_t alignUp(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+// count * recordSize (+ extra), false if a forged count makes it overflow
+bool sectionBytes(uint64_t count, uint64_t recordSize, uint64_t extra, uint64_t& bytes) {
+    return !__builtin_mul_overflow(count, recordSize, &bytes) && !__builtin_add_overflow(bytes, extra, &bytes);
+}
+
+// findRecord() binary-searches, so the IDs must be strictly increasing
+template <typename Record>
+bool idsIncreasing(const Record* records, size_t count) {
+    for (size_t i = 1; i < count; ++i) {
+        if (records[i].id <= records[i - 1].id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Record>
+const Record* findRecord(const Record* records, size_t count, int id) {
+    const Record* end = records + count;
+    const Record* it = std::lower_bound(records, end, id,
+                                        [](const Record& record, int key) { return record.id < key; });
+    return (it != end && it->id == id) ? it : nullptr;
+}
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * File header; every section starts on an 8-byte boundary
+ * Followed by the section table: the offsets of every section of the file's
+ * version, then their sizes in bytes
+ */
+struct Snapshot::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder; // Written as BYTE_ORDER_MARK; anything else means a foreign byte order
+    int32_t nextRideID;
+    int32_t nextDriverID;
+    int32_t nextRiderID;
+    uint32_t reserved;
+    uint64_t driverCount;
+    uint64_t riderCount;
+    uint64_t rideCount;
+    uint64_t locationCount;
+    uint64_t fileSize;
+};
+
+Snapshot::Snapshot(const unsigned char* mapping, size_t size)
+    : base(mapping), length(size), header(reinterpret_cast<const Header*>(mapping)) {}
+
+Snapshot::~Snapshot() {
+    ::munmap(const_cast<unsigned char*>(base), length);
+}
+
+bool Snapshot::save(const std::string& path, const SnapshotContents& contents) {
+    size_t rides = contents.rideIDs.size();
+    size_t locationBytes = 0;
+    for (std::string_view location : contents.locations) {
+        locationBytes += location.size();
+    }
+    if (contents.strings.size() + locationBytes > UINT32_MAX) {
+        LOG_ERROR("Snapshot string data exceeds 4 GiB");
+        return false;
+    }
+
+    // Location names follow the other strings; their offsets are relative to the section
+    std::vector<uint32_t> locationOffsets;
+    locationOffsets.reserve(contents.locations.size() + 1);
+    uint32_t offset = static_cast<uint32_t>(contents.strings.size());
+    for (std::string_view location : contents.locations) {
+        locationOffsets.push_back(offset);
+        offset += static_cast<uint32_t>(location.size());
+    }
+    locationOffsets.push_back(offset);
+
+    struct Chunk {
+        const void* data;
+        size_t size;
+    };
+    std::vector<Chunk> sections[SECTION_COUNT];
+    sections[Drivers] = {{contents.drivers.data(), contents.drivers.size() * sizeof(SnapshotDriver)}};
+    sections[Riders] = {{contents.riders.data(), contents.riders.size() * sizeof(SnapshotRider)}};
+    sections[Strings] = {{contents.strings.data(), contents.strings.size()}};
+    for (std::string_view location : contents.locations) {
+        sections[Strings].push_back({location.data(), location.size()});
+    }
+    sections[LocationOffsets] = {{locationOffsets.data(), locationOffsets.size() * sizeof(uint32_t)}};
+    sections[RideIDs] = {{contents.rideIDs.data(), rides * sizeof(int32_t)}};
+    sections[RideTypes] = {{contents.types.data(), rides * sizeof(RideType)}};
+    sections[Distances] = {{contents.distances.data(), rides * sizeof(double)}};
+    sections[Fares] = {{contents.fares.data(), rides * sizeof(double)}};
+    sections[PickupIDs] = {{contents.pickupIDs.data(), rides * sizeof(uint32_t)}};
+    sections[DropoffIDs] = {{contents.dropoffIDs.data(), rides * sizeof(uint32_t)}};
+    sections[RideDriverIDs] = {{contents.driverIDs.data(), rides * sizeof(int32_t)}};
+    sections[RideRiderIDs] = {{contents.riderIDs.data(), rides * sizeof(int32_t)}};
+    sections[PickupFlags] = {{contents.hasPickupPoint.data(), rides * sizeof(uint8_t)}};
+    sections[PickupPoints] = {{contents.pickupPoints.data(), rides * sizeof(GeoPoint)}};
+    sections[DriverRideStart] = {{contents.driverRideStart.data(),
+                                  contents.driverRideStart.size() * sizeof(uint32_t)}};
+    sections[DriverRideIDs] = {{contents.driverRideIDs.data(), contents.driverRideIDs.size() * sizeof(int32_t)}};
+    sections[RiderRideStart] = {{contents.riderRideStart.data(),
+                                 contents.riderRideStart.size() * sizeof(uint32_t)}};
+    sections[RiderRideIDs] = {{contents.riderRideIDs.data(), contents.riderRideIDs.size() * sizeof(int32_t)}};
+    sections[SurgePercents] = {{contents.surgePercents.data(), rides * sizeof(uint16_t)}};
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.nextRideID = contents.nextRideID;
+    header.nextDriverID = contents.nextDriverID;
+    header.nextRiderID = contents.nextRiderID;
+    header.driverCount = contents.drivers.size();
+    header.riderCount = contents.riders.size();
+    header.rideCount = rides;
+    header.locationCount = contents.locations.size();
+    uint64_t table[2 * SECTION_COUNT];
+    uint64_t* offsets = table;
+    uint64_t* sizes = table + SECTION_COUNT;
+    size_t position = sizeof(Header) + sizeof(table);
+    for (uint32_t s = 0; s < SECTION_COUNT; ++s) {
+        size_t size = 0;
+        for (const Chunk& chunk : sections[s]) {
+            size += chunk.size;
+        }
+        offsets[s] = position;
+        sizes[s] = size;
+        position = alignUp(position + size);
+    }
+    header.fileSize = position;
+
+    // Write beside the target and rename, so readers never see a partial file
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Cannot create snapshot file: " << temporary << " (" << std::strerror(errno) << ")");
+        return false;
+    }
+    static const char padding[8] = {};
+    bool ok = writeAll(fd, &header, sizeof(header)) && writeAll(fd, table, sizeof(table));
+    for (uint32_t s = 0; ok && s < SECTION_COUNT; ++s) {
+        for (const Chunk& chunk : sections[s]) {
+            ok = ok && writeAll(fd, chunk.data, chunk.size);
+        }
+        ok = ok && writeAll(fd, padding, alignUp(sizes[s]) - sizes[s]);
+    }
+    ok = ok && ::fsync(fd) == 0;
+    ok = (::close(fd) == 0) && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        LOG_ERROR("Failed to write snapshot: " << path << " (" << std::strerror(errno) << ")");
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Snapshot> Snapshot::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Cannot open snapshot: " << path << " (" << std::strerror(errno) << ")");
+        return nullptr;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        LOG_ERROR("Snapshot is truncated: " << path);
+        ::close(fd);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file contents alive
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR("Cannot map snapshot: " << path << " (" << std::strerror(errno) << ")");
+        return nullptr;
+    }
+
+    std::unique_ptr<Snapshot> snapshot(new Snapshot(static_cast<const unsigned char*>(mapping), size));
+    if (!snapshot->validate()) {
+        LOG_ERROR("Snapshot is corrupt or from an incompatible version: " << path);
+        return nullptr;
+    }
+    return snapshot;
+}
+
+bool Snapshot::validate() const {
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || (header->version != 1 && header->version != VERSION) ||
+        header->byteOrder != BYTE_ORDER_MARK || header->fileSize != length) {
+        return false;
+    }
+    uint32_t sections = sectionCount();
+    size_t tableEnd = sizeof(Header) + 2 * sections * sizeof(uint64_t);
+    if (length < tableEnd) {
+        return false;
+    }
+
+    // Only the section table and the record order are checked; records are used in place.
+    // The counts come from the file, so a product that wraps around is a forgery
+    uint64_t rides = header->rideCount;
+    uint64_t expected[SECTION_COUNT] = {};
+    bool sized = sectionBytes(header->driverCount, sizeof(SnapshotDriver), 0, expected[Drivers]) &&
+                 sectionBytes(header->riderCount, sizeof(SnapshotRider), 0, expected[Riders]) &&
+                 sectionBytes(header->locationCount, sizeof(uint32_t), sizeof(uint32_t), expected[LocationOffsets]) &&
+                 sectionBytes(rides, sizeof(int32_t), 0, expected[RideIDs]) &&
+                 sectionBytes(rides, sizeof(RideType), 0, expected[RideTypes]) &&
+                 sectionBytes(rides, sizeof(double), 0, expected[Distances]) &&
+                 sectionBytes(rides, sizeof(double), 0, expected[Fares]) &&
+                 sectionBytes(rides, sizeof(uint32_t), 0, expected[PickupIDs]) &&
+                 sectionBytes(rides, sizeof(uint32_t), 0, expected[DropoffIDs]) &&
+                 sectionBytes(rides, sizeof(int32_t), 0, expected[RideDriverIDs]) &&
+                 sectionBytes(rides, sizeof(int32_t), 0, expected[RideRiderIDs]) &&
+                 sectionBytes(rides, sizeof(uint8_t), 0, expected[PickupFlags]) &&
+                 sectionBytes(rides, sizeof(GeoPoint), 0, expected[PickupPoints]) &&
+                 sectionBytes(header->driverCount, sizeof(uint32_t), sizeof(uint32_t), expected[DriverRideStart]) &&
+                 sectionBytes(header->riderCount, sizeof(uint32_t), sizeof(uint32_t), expected[RiderRideStart]) &&
+                 sectionBytes(rides, sizeof(uint16_t), 0, expected[SurgePercents]);
+    if (!sized) {
+        return false;
+    }
+    expected[Strings] = sectionSize(Strings);
+    expected[DriverRideIDs] = sectionSize(DriverRideIDs);
+    expected[RiderRideIDs] = sectionSize(RiderRideIDs);
+    for (uint32_t s = 0; s < sections; ++s) {
+        uint64_t offset = sectionOffset(static_cast<Section>(s));
+        uint64_t size = sectionSize(static_cast<Section>(s));
+        if (size != expected[s] || offset % 8 != 0 || offset < tableEnd ||
+            offset > length || size > length - offset) {
+            return false;
+        }
+    }
+
+    // Offset tables must end exactly at the end of the data they index
+    const uint32_t* driverStart = section<uint32_t>(DriverRideStart);
+    const uint32_t* riderStart = section<uint32_t>(RiderRideStart);
+    const uint32_t* locationOffsets = section<uint32_t>(LocationOffsets);
+    return uint64_t(driverStart[header->driverCount]) * sizeof(int32_t) == sectionSize(DriverRideIDs) &&
+           uint64_t(riderStart[header->riderCount]) * sizeof(int32_t) == sectionSize(RiderRideIDs) &&
+           locationOffsets[header->locationCount] <= sectionSize(Strings) &&
+           idsIncreasing(drivers(), driverCount()) && idsIncreasing(riders(), riderCount());
+}
+
+uint32_t Snapshot::sectionCount() const {
+    return header->version == 1 ? VERSION_1_SECTIONS : SECTION_COUNT;
+}
+
+const uint64_t* Snapshot::sectionTable() const {
+    static_assert(sizeof(Header) % 8 == 0, "the section table follows the header 8-byte aligned");
+    return reinterpret_cast<const uint64_t*>(base + sizeof(Header));
+}
+
+uint64_t Snapshot::sectionOffset(Section which) const {
+    return sectionTable()[which];
+}
+
+uint64_t Snapshot::sectionSize(Section which) const {
+    return sectionTable()[sectionCount() + which];
+}
+
+int32_t Snapshot::nextRideID() const {
+    return header->nextRideID;
+}
+
+int32_t Snapshot::nextDriverID() const {
+    return header->nextDriverID;
+}
+
+int32_t Snapshot::nextRiderID() const {
+    return header->nextRiderID;
+}
+
+size_t Snapshot::driverCount() const {
+    return static_cast<size_t>(header->driverCount);
+}
+
+size_t Snapshot::riderCount() const {
+    return static_cast<size_t>(header->riderCount);
+}
+
+size_t Snapshot::rideCount() const {
+    return static_cast<size_t>(header->rideCount);
+}
+
+size_t Snapshot::locationCount() const {
+    return static_cast<size_t>(header->locationCount);
+}
+
+const SnapshotDriver* Snapshot::findDriver(int id) const {
+    return findRecord(drivers(), driverCount(), id);
+}
+
+const SnapshotRider* Snapshot::findRider(int id) const {
+    return findRecord(riders(), riderCount(), id);
+}
+
+const int32_t* Snapshot::driverRides(const SnapshotDriver* record, size_t& count) const {
+    const uint32_t* start = section<uint32_t>(DriverRideStart);
+    size_t index = static_cast<size_t>(record - drivers());
+    uint32_t first = start[index];
+    uint32_t last = start[index + 1];
+    // A damaged table yields an empty list rather than a read past the section
+    count = (first <= last && last <= start[driverCount()]) ? last - first : 0;
+    return section<int32_t>(DriverRideIDs) + first;
+}
+
+const int32_t* Snapshot::riderRides(const SnapshotRider* record, size_t& count) const {
+    const uint32_t* start = section<uint32_t>(RiderRideStart);
+    size_t index = static_cast<size_t>(record - riders());
+    uint32_t first = start[index];
+    uint32_t last = start[index + 1];
+    count = (first <= last && last <= start[riderCount()]) ? last - first : 0;
+    return section<int32_t>(RiderRideIDs) + first;
+}
+
+bool Snapshot::findRide(int rideID, size_t& row) const {
+    const int32_t* ids = rideIDs();
+    const int32_t* end = ids + rideCount();
+    const int32_t* it = std::lower_bound(ids, end, rideID);
+    if (it == end || *it != rideID) {
+        return false;
+    }
+    row = static_cast<size_t>(it - ids);
+    return true;
+}
+
+std::string_view Snapshot::text(uint32_t offset, uint32_t size) const {
+    uint64_t limit = sectionSize(Strings);
+    if (offset > limit || size > limit - offset) {
+        return {};
+    }
+    return std::string_view(reinterpret_cast<const char*>(base + sectionOffset(Strings)) + offset, size);
+}
+
+std::string_view Snapshot::locationName(uint32_t id) const {
+    if (id >= locationCount()) {
+        return {};
+    }
+    const uint32_t* offsets = section<uint32_t>(LocationOffsets);
+    if (offsets[id] > offsets[id + 1]) {
+        return {};
+    }
+    return text(offsets[id], offsets[id + 1] - offsets[id]);
+}
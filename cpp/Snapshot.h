@@ -0,0 +1,242 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "GeoPoint.h"
+#include "Ride.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Driver as stored in a snapshot (fixed-size, read in place from the mapping)
+ */
+struct SnapshotDriver {
+    int32_t id;
+    uint32_t nameOffset;  // Into the string section
+    uint32_t nameLength;
+    uint8_t flags;        // HAS_LOCATION | AVAILABLE
+    uint8_t reserved[3];
+    double rating;
+    double x;
+    double y;
+
+    static constexpr uint8_t HAS_LOCATION = 1;
+    static constexpr uint8_t AVAILABLE = 2;
+};
+
+/**
+ * Rider as stored in a snapshot
+ */
+struct SnapshotRider {
+    int32_t id;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t paymentOffset;
+    uint32_t paymentLength;
+    uint32_t reserved;
+};
+
+/**
+ * Everything a snapshot records, gathered by RideSharingSystem::saveSnapshot
+ * Ride columns use the snapshot's own location IDs (see locations)
+ */
+struct SnapshotContents {
+    int32_t nextRideID = 1;
+    int32_t nextDriverID = 1;
+    int32_t nextRiderID = 1;
+    std::vector<SnapshotDriver> drivers;   // Sorted by ID; offsets index into strings
+    std::vector<SnapshotRider> riders;     // Sorted by ID
+    std::string strings;                   // Names and payment methods
+    std::vector<std::string_view> locations;
+
+    // Ride columns, one entry per ride, sorted by ride ID
+    std::vector<int32_t> rideIDs;
+    std::vector<RideType> types;
+    std::vector<double> distances;
+    std::vector<double> fares;
+    std::vector<uint32_t> pickupIDs;
+    std::vector<uint32_t> dropoffIDs;
+    std::vector<int32_t> driverIDs;
+    std::vector<int32_t> riderIDs;
+    std::vector<uint8_t> hasPickupPoint;
+    std::vector<GeoPoint> pickupPoints;
+    std::vector<uint16_t> surgePercents;
+
+    // Ride IDs of each driver and rider in list order, as offset tables
+    std::vector<uint32_t> driverRideStart; // drivers.size() + 1 entries
+    std::vector<int32_t> driverRideIDs;
+    std::vector<uint32_t> riderRideStart;  // riders.size() + 1 entries
+    std::vector<int32_t> riderRideIDs;
+};
+
+/**
+ * Snapshot - Versioned binary image of a RideSharingSystem, opened with mmap
+ * Every section is a fixed-size record array or a plain column, aligned so
+ * it can be used directly from the mapping. Opening a snapshot validates the
+ * header and section bounds and nothing else - there is no per-object
+ * parsing, so even very large snapshots open in milliseconds.
+ * Per-driver and per-rider ride lists are stored as offset tables so a single
+ * Driver or Rider object can be materialized on demand.
+ *
+ * Version 2 added the SurgePercents column. Version 1 files still open; their
+ * section table is simply shorter and surgePercents() returns nullptr.
+ */
+class Snapshot {
+public:
+    static constexpr uint32_t VERSION = 2;
+
+    enum Section : uint32_t {
+        Drivers,
+        Riders,
+        Strings,
+        LocationOffsets,  // locationCount + 1 offsets into Strings
+        RideIDs,
+        RideTypes,
+        Distances,
+        Fares,
+        PickupIDs,
+        DropoffIDs,
+        RideDriverIDs,
+        RideRiderIDs,
+        PickupFlags,
+        PickupPoints,
+        DriverRideStart,  // driverCount + 1 offsets into DriverRideIDs
+        DriverRideIDs,    // Ride IDs grouped by driver, in driver order
+        RiderRideStart,
+        RiderRideIDs,
+        SurgePercents,    // Quoted surge of each ride in percent (version 2)
+        SECTION_COUNT
+    };
+
+    static constexpr uint32_t VERSION_1_SECTIONS = SurgePercents;
+
+private:
+    struct Header;
+
+    const unsigned char* base;
+    size_t length;
+    const Header* header;
+
+    Snapshot(const unsigned char* mapping, size_t size);
+
+    template <typename T>
+    const T* section(Section which) const {
+        return reinterpret_cast<const T*>(base + sectionOffset(which));
+    }
+
+    uint32_t sectionCount() const;
+    const uint64_t* sectionTable() const; // offsets[sectionCount()], then sizes[sectionCount()]
+    uint64_t sectionOffset(Section which) const;
+    uint64_t sectionSize(Section which) const;
+    bool validate() const;
+
+public:
+    ~Snapshot();
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    /**
+     * Write a snapshot atomically (temporary file, then rename)
+     * @param path Destination file
+     * @param contents Data to store
+     * @return True on success
+     */
+    static bool save(const std::string& path, const SnapshotContents& contents);
+
+    /**
+     * Map a snapshot file read-only and validate its header
+     * @param path Snapshot file
+     * @return Opened snapshot, or nullptr if missing, truncated or of another version
+     */
+    static std::unique_ptr<Snapshot> open(const std::string& path);
+
+    int32_t nextRideID() const;
+    int32_t nextDriverID() const;
+    int32_t nextRiderID() const;
+    size_t driverCount() const;
+    size_t riderCount() const;
+    size_t rideCount() const;
+    size_t locationCount() const;
+
+    // Records, in ID order
+    const SnapshotDriver* drivers() const { return section<SnapshotDriver>(Drivers); }
+    const SnapshotRider* riders() const { return section<SnapshotRider>(Riders); }
+
+    /**
+     * Look up a driver record by ID (binary search)
+     * @param id Driver ID
+     * @return Record, or nullptr if the snapshot has no such driver
+     */
+    const SnapshotDriver* findDriver(int id) const;
+
+    /**
+     * Look up a rider record by ID (binary search)
+     * @param id Rider ID
+     * @return Record, or nullptr if the snapshot has no such rider
+     */
+    const SnapshotRider* findRider(int id) const;
+
+    /**
+     * Ride IDs of one driver's rides
+     * @param record Driver record from this snapshot
+     * @param count Receives the number of rides
+     * @return Pointer to the first ride ID
+     */
+    const int32_t* driverRides(const SnapshotDriver* record, size_t& count) const;
+
+    /**
+     * Ride IDs of one rider's rides
+     * @param record Rider record from this snapshot
+     * @param count Receives the number of rides
+     * @return Pointer to the first ride ID
+     */
+    const int32_t* riderRides(const SnapshotRider* record, size_t& count) const;
+
+    /**
+     * Row of a ride in the snapshot's ride columns
+     * @param rideID Ride ID
+     * @param row Receives the row if found
+     * @return True if the snapshot contains the ride
+     */
+    bool findRide(int rideID, size_t& row) const;
+
+    // Ride columns (rideCount() entries each)
+    const int32_t* rideIDs() const { return section<int32_t>(RideIDs); }
+    const RideType* rideTypes() const { return section<RideType>(RideTypes); }
+    const double* distances() const { return section<double>(Distances); }
+    const double* fares() const { return section<double>(Fares); }
+    const uint32_t* pickupIDs() const { return section<uint32_t>(PickupIDs); }
+    const uint32_t* dropoffIDs() const { return section<uint32_t>(DropoffIDs); }
+    const int32_t* rideDriverIDs() const { return section<int32_t>(RideDriverIDs); }
+    const int32_t* rideRiderIDs() const { return section<int32_t>(RideRiderIDs); }
+    const uint8_t* pickupFlags() const { return section<uint8_t>(PickupFlags); }
+    const GeoPoint* pickupPoints() const { return section<GeoPoint>(PickupPoints); }
+
+    /**
+     * Quoted surge of each ride in percent
+     * @return Column of rideCount() entries, or nullptr for a version 1 snapshot
+     */
+    const uint16_t* surgePercents() const {
+        return sectionCount() > SurgePercents ? section<uint16_t>(SurgePercents) : nullptr;
+    }
+
+    /**
+     * Text stored in the string section
+     * @param offset Byte offset
+     * @param length Byte length
+     * @return View into the mapping
+     */
+    std::string_view text(uint32_t offset, uint32_t length) const;
+
+    /**
+     * Name of a location by its snapshot location ID
+     * @param id Location ID used in the pickup/dropoff columns
+     * @return View into the mapping
+     */
+    std::string_view locationName(uint32_t id) const;
+};
+
+#endif // SNAPSHOT_H
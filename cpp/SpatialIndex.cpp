@@ -0,0 +1,160 @@
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+SpatialIndex::SpatialIndex(double cellMiles)
+    : cellSize(cellMiles > 0.0 ? cellMiles : 0.5) {}
+
+int32_t SpatialIndex::cellCoord(double value) const {
+    double cell = std::floor(value / cellSize);
+    if (std::isnan(cell)) {
+        return 0; // NaN compares false against both clamps, and converting it is undefined
+    }
+    // Clamp so far-out coordinates still land in a valid (edge) cell
+    cell = std::max(cell, static_cast<double>(std::numeric_limits<int32_t>::min()));
+    cell = std::min(cell, static_cast<double>(std::numeric_limits<int32_t>::max()));
+    return static_cast<int32_t>(cell);
+}
+
+uint64_t SpatialIndex::cellKey(int32_t cx, int32_t cy) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+void SpatialIndex::removeFromCell(const Entry& entry) {
+    std::vector<Item>& items = cells.find(entry.cell)->second;
+    // Swap-remove; empty cells are kept to avoid churn at cell boundaries
+    Item last = items.back();
+    items[entry.slot] = last;
+    entries[last.id].slot = entry.slot;
+    items.pop_back();
+}
+
+void SpatialIndex::update(int id, GeoPoint point) {
+    if (id < 0) {
+        return;
+    }
+    if (static_cast<size_t>(id) >= entries.size()) {
+        entries.resize(static_cast<size_t>(id) + 1);
+    }
+
+    int32_t cx = cellCoord(point.x);
+    int32_t cy = cellCoord(point.y);
+    uint64_t key = cellKey(cx, cy);
+    Entry& entry = entries[id];
+
+    if (entry.present && entry.cell == key) {
+        cells.find(key)->second[entry.slot].point = point;
+        return;
+    }
+
+    if (entry.present) {
+        removeFromCell(entry);
+    } else {
+        if (cells.empty()) {
+            minCellX = maxCellX = cx;
+            minCellY = maxCellY = cy;
+        }
+        count++;
+    }
+
+    std::vector<Item>& items = cells[key];
+    entry.cell = key;
+    entry.slot = static_cast<uint32_t>(items.size());
+    entry.present = true;
+    items.push_back({id, point});
+
+    minCellX = std::min(minCellX, cx);
+    maxCellX = std::max(maxCellX, cx);
+    minCellY = std::min(minCellY, cy);
+    maxCellY = std::max(maxCellY, cy);
+}
+
+bool SpatialIndex::remove(int id) {
+    if (!contains(id)) {
+        return false;
+    }
+    Entry& entry = entries[id];
+    removeFromCell(entry);
+    entry.present = false;
+    count--;
+    return true;
+}
+
+std::vector<Neighbor> SpatialIndex::nearest(GeoPoint point, size_t k) const {
+    std::vector<Neighbor> result;
+    if (k == 0 || count == 0) {
+        return result;
+    }
+
+    // Max-heap on squared distance holding the best k entries seen so far
+    std::vector<std::pair<double, int>> best;
+    best.reserve(k);
+
+    auto scanCell = [&](int64_t x, int64_t y) {
+        auto it = cells.find(cellKey(static_cast<int32_t>(x), static_cast<int32_t>(y)));
+        if (it == cells.end()) {
+            return;
+        }
+        for (const Item& item : it->second) {
+            double d2 = squaredDistance(point, item.point);
+            if (best.size() < k) {
+                best.emplace_back(d2, item.id);
+                std::push_heap(best.begin(), best.end());
+            } else if (d2 < best.front().first) {
+                std::pop_heap(best.begin(), best.end());
+                best.back() = {d2, item.id};
+                std::push_heap(best.begin(), best.end());
+            }
+        }
+    };
+    // Scan the cells of a row or column segment, clipped to the occupied area
+    auto scanRow = [&](int64_t y, int64_t x0, int64_t x1) {
+        if (y < minCellY || y > maxCellY) {
+            return;
+        }
+        for (int64_t x = std::max<int64_t>(x0, minCellX); x <= std::min<int64_t>(x1, maxCellX); ++x) {
+            scanCell(x, y);
+        }
+    };
+    auto scanColumn = [&](int64_t x, int64_t y0, int64_t y1) {
+        if (x < minCellX || x > maxCellX) {
+            return;
+        }
+        for (int64_t y = std::max<int64_t>(y0, minCellY); y <= std::min<int64_t>(y1, maxCellY); ++y) {
+            scanCell(x, y);
+        }
+    };
+
+    int64_t cx = cellCoord(point.x);
+    int64_t cy = cellCoord(point.y);
+    // Rings closer than the occupied area are empty; rings past its far edge add nothing
+    int64_t firstRing = std::max({int64_t(0), minCellX - cx, cx - maxCellX, minCellY - cy, cy - maxCellY});
+    int64_t lastRing = std::max({cx - minCellX, maxCellX - cx, cy - minCellY, maxCellY - cy});
+
+    for (int64_t r = firstRing; r <= lastRing; ++r) {
+        if (r > 0 && best.size() == k) {
+            // Everything in ring r lies outside the square covered by rings 0..r-1
+            double reach = std::min({point.x - (cx - r + 1) * cellSize, (cx + r) * cellSize - point.x,
+                                     point.y - (cy - r + 1) * cellSize, (cy + r) * cellSize - point.y});
+            if (reach > 0.0 && best.front().first <= reach * reach) {
+                break;
+            }
+        }
+        if (r == 0) {
+            scanCell(cx, cy);
+            continue;
+        }
+        scanRow(cy - r, cx - r, cx + r);
+        scanRow(cy + r, cx - r, cx + r);
+        scanColumn(cx - r, cy - r + 1, cy + r - 1);
+        scanColumn(cx + r, cy - r + 1, cy + r - 1);
+    }
+
+    std::sort_heap(best.begin(), best.end());
+    result.reserve(best.size());
+    for (const auto& candidate : best) {
+        result.push_back({candidate.second, std::sqrt(candidate.first)});
+    }
+    return result;
+}
@@ -0,0 +1,96 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "GeoPoint.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * One result of a nearest-neighbour query
+ */
+struct Neighbor {
+    int id;
+    double distance; // Miles from the query point
+};
+
+/**
+ * SpatialIndex - Uniform grid over driver positions
+ * Space is cut into square cells; each occupied cell keeps a small array of
+ * the IDs and positions inside it. Moving within a cell is an in-place write
+ * and moving across cells is a swap-remove plus append, so position updates
+ * stay O(1). Nearest queries scan rings of cells outward from the query
+ * point and stop as soon as no unscanned cell can hold a closer entry.
+ * Not synchronized - RideSharingSystem guards it with its dispatch lock.
+ */
+class SpatialIndex {
+private:
+    struct Item {
+        int id;
+        GeoPoint point;
+    };
+
+    struct Entry {
+        uint64_t cell = 0;
+        uint32_t slot = 0;
+        bool present = false;
+    };
+
+    double cellSize;
+    std::unordered_map<uint64_t, std::vector<Item>> cells;
+    std::vector<Entry> entries; // Indexed by ID (IDs are small and dense)
+    size_t count = 0;
+
+    // Bounding box of every cell ever occupied, limits how far rings expand
+    int32_t minCellX = 0;
+    int32_t maxCellX = 0;
+    int32_t minCellY = 0;
+    int32_t maxCellY = 0;
+
+    int32_t cellCoord(double value) const;
+    static uint64_t cellKey(int32_t cx, int32_t cy);
+    void removeFromCell(const Entry& entry);
+
+public:
+    /**
+     * @param cellMiles Cell edge length; roughly the typical gap between neighbours works best
+     */
+    explicit SpatialIndex(double cellMiles = 0.5);
+
+    /**
+     * Add an entry or move it to a new position
+     * @param id Non-negative entry ID
+     * @param point New position
+     */
+    void update(int id, GeoPoint point);
+
+    /**
+     * Remove an entry
+     * @param id Entry ID
+     * @return True if the entry was present
+     */
+    bool remove(int id);
+
+    /**
+     * Check whether an entry is indexed
+     * @param id Entry ID
+     * @return True if present
+     */
+    bool contains(int id) const {
+        return id >= 0 && static_cast<size_t>(id) < entries.size() && entries[id].present;
+    }
+
+    /**
+     * Find the k entries closest to a point
+     * @param point Query position
+     * @param k Maximum number of results
+     * @return Up to k entries, closest first
+     */
+    std::vector<Neighbor> nearest(GeoPoint point, size_t k) const;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+#endif // SPATIAL_INDEX_H
@@ -0,0 +1,111 @@
+#include "StatsEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+namespace {
+
+struct ChunkResult {
+    double revenue = 0.0;
+    double distance = 0.0;
+    size_t typeCounts[RIDE_TYPE_COUNT] = {};
+};
+
+// Nearest-rank percentile over an array that nth_element may reorder
+double percentile(std::vector<double>& values, double fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * values.size()));
+    size_t index = (rank > 0) ? rank - 1 : 0;
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+} // namespace
+
+void StatsEngine::capture(const RideStore& store) {
+    types.assign(store.getTypes().begin(), store.getTypes().end());
+    distances.assign(store.getDistances().begin(), store.getDistances().end());
+    fares.assign(store.getFares().begin(), store.getFares().end());
+    driverIDs.assign(store.getDriverIDs().begin(), store.getDriverIDs().end());
+}
+
+RideStats StatsEngine::compute(const RideStore& store, int maxDriverID) {
+    std::vector<double> distanceCopy;
+    return computeColumns(store.getTypes().data(), store.getDistances().data(), store.getFares().data(),
+                          store.getDriverIDs().data(), store.size(), maxDriverID, distanceCopy, true);
+}
+
+RideStats StatsEngine::computeCaptured(int maxDriverID) {
+    // The captured distances are a private copy, so the percentiles reorder them in place
+    return computeColumns(types.data(), distances.data(), fares.data(), driverIDs.data(), types.size(),
+                          maxDriverID, distances, false);
+}
+
+RideStats StatsEngine::computeColumns(const RideType* typeColumn, const double* distanceColumn,
+                                      const double* fareColumn, const int* driverColumn, size_t rows,
+                                      int maxDriverID, std::vector<double>& percentileDistances,
+                                      bool copyDistances) {
+    RideStats stats;
+    stats.rideCount = rows;
+    stats.driverRevenue.assign(static_cast<size_t>(std::max(maxDriverID, 0)) + 1, 0.0);
+    if (rows == 0) {
+        return stats;
+    }
+
+    size_t chunkCount = (rows + CHUNK_ROWS - 1) / CHUNK_ROWS;
+    std::vector<ChunkResult> chunks(chunkCount);
+    if (copyDistances) {
+        percentileDistances.resize(rows);
+    }
+    double* distanceCopy = copyDistances ? percentileDistances.data() : nullptr;
+
+    // Per-driver revenue is accumulated as integer micro-dollars, which makes
+    // the concurrent sums exact and independent of execution order
+    size_t driverSlots = stats.driverRevenue.size();
+    std::unique_ptr<std::atomic<int64_t>[]> driverMicros(new std::atomic<int64_t>[driverSlots]);
+    for (size_t i = 0; i < driverSlots; ++i) {
+        driverMicros[i].store(0, std::memory_order_relaxed);
+    }
+
+    auto processChunk = [&](size_t chunk) {
+        size_t begin = chunk * CHUNK_ROWS;
+        size_t end = std::min(begin + CHUNK_ROWS, rows);
+        ChunkResult& result = chunks[chunk];
+        for (size_t row = begin; row < end; ++row) {
+            result.revenue += fareColumn[row];
+            result.distance += distanceColumn[row];
+            result.typeCounts[static_cast<size_t>(typeColumn[row])]++;
+            if (distanceCopy) {
+                distanceCopy[row] = distanceColumn[row];
+            }
+            size_t driver = static_cast<size_t>(driverColumn[row]);
+            if (driver < driverSlots) {
+                driverMicros[driver].fetch_add(std::llround(fareColumn[row] * 1e6), std::memory_order_relaxed);
+            }
+        }
+    };
+
+    if (chunkCount == 1) {
+        processChunk(0);
+    } else {
+        pool.parallelFor(chunkCount, processChunk);
+    }
+
+    // Deterministic reduction in chunk order
+    for (const ChunkResult& chunk : chunks) {
+        stats.totalRevenue += chunk.revenue;
+        stats.totalDistance += chunk.distance;
+        for (size_t t = 0; t < RIDE_TYPE_COUNT; ++t) {
+            stats.typeCounts[t] += chunk.typeCounts[t];
+        }
+    }
+    for (size_t i = 0; i < driverSlots; ++i) {
+        stats.driverRevenue[i] = driverMicros[i].load(std::memory_order_relaxed) / 1e6;
+    }
+
+    stats.distanceP50 = percentile(percentileDistances, 0.50);
+    stats.distanceP90 = percentile(percentileDistances, 0.90);
+    stats.distanceP99 = percentile(percentileDistances, 0.99);
+    return stats;
+}
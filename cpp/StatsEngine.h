@@ -0,0 +1,90 @@
+#ifndef STATS_ENGINE_H
+#define STATS_ENGINE_H
+
+#include "RideStore.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * Result of one statistics pass over the ride store
+ */
+struct RideStats {
+    size_t rideCount = 0;
+    double totalRevenue = 0.0;
+    size_t typeCounts[RIDE_TYPE_COUNT] = {};
+    double totalDistance = 0.0;
+    double distanceP50 = 0.0;  // Nearest-rank distance percentiles
+    double distanceP90 = 0.0;
+    double distanceP99 = 0.0;
+    std::vector<double> driverRevenue; // Indexed by driver ID
+
+    size_t count(RideType type) const { return typeCounts[static_cast<size_t>(type)]; }
+};
+
+/**
+ * StatsEngine - Parallel, fused statistics over the columnar ride store
+ * Rows are split into fixed-size chunks that are processed on a thread pool.
+ * Each chunk computes revenue, type counts, distance totals and per-driver
+ * sums in a single pass; partial results are then reduced in chunk order.
+ * Chunk boundaries do not depend on the thread count, so the result is
+ * identical no matter how many threads ran the pass.
+ */
+class StatsEngine {
+private:
+    ThreadPool pool;
+    // Columns copied by capture(), reused across passes
+    std::vector<RideType> types;
+    std::vector<double> distances; // Reordered by the percentile selection
+    std::vector<double> fares;
+    std::vector<int> driverIDs;
+    
+    /**
+     * One fused pass over column arrays
+     * @param rows Rows in every column
+     * @param maxDriverID Largest driver ID (sizes the per-driver table)
+     * @param percentileDistances Distances the percentiles are selected from (reordered)
+     * @param copyDistances Fill percentileDistances during the pass; false if it already
+     *        holds the distance column
+     * @return Aggregated statistics
+     */
+    RideStats computeColumns(const RideType* typeColumn, const double* distanceColumn, const double* fareColumn,
+                             const int* driverColumn, size_t rows, int maxDriverID,
+                             std::vector<double>& percentileDistances, bool copyDistances);
+
+public:
+    // Rows per chunk; stores smaller than this are processed on the caller
+    static constexpr size_t CHUNK_ROWS = 64 * 1024;
+
+    /**
+     * @param threadCount Worker threads (0 = one per hardware thread)
+     */
+    explicit StatsEngine(size_t threadCount = 0) : pool(threadCount) {}
+
+    /**
+     * Compute statistics for every ride in the store
+     * @param store Ride store to scan
+     * @param maxDriverID Largest driver ID (sizes the per-driver table)
+     * @return Aggregated statistics
+     */
+    RideStats compute(const RideStore& store, int maxDriverID);
+    
+    /**
+     * Copy the columns a pass reads, so the store can change while it runs
+     * Only this step needs the store's lock; it is a few sequential copies,
+     * cheap next to the pass
+     * @param store Ride store to copy from
+     */
+    void capture(const RideStore& store);
+    
+    /**
+     * Compute statistics over the rides copied by the last capture()
+     * @param maxDriverID Largest driver ID (sizes the per-driver table)
+     * @return Aggregated statistics
+     */
+    RideStats computeCaptured(int maxDriverID);
+
+    size_t concurrency() const { return pool.concurrency(); }
+};
+
+#endif // STATS_ENGINE_H
@@ -0,0 +1,180 @@
+#include "SurgeEngine.h"
+#include <algorithm>
+#include <cmath>
+
+SurgeEngine::SurgeEngine(const SurgePolicy& surgePolicy)
+    : policy(surgePolicy),
+      bucketMillis(std::max<int64_t>(1, surgePolicy.windowMillis / static_cast<int64_t>(WINDOW_BUCKETS))) {}
+
+int32_t SurgeEngine::zoneCoord(double value) const {
+    double cell = std::floor(value / policy.zoneMiles);
+    if (std::isnan(cell)) {
+        return 0; // Same guard as SpatialIndex::cellCoord: NaN slips past the clamps
+    }
+    return static_cast<int32_t>(std::min(std::max(cell, static_cast<double>(INT32_MIN)),
+                                         static_cast<double>(INT32_MAX)));
+}
+
+uint64_t SurgeEngine::zoneKey(GeoPoint point) const {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(zoneCoord(point.x))) << 32) |
+           static_cast<uint32_t>(zoneCoord(point.y));
+}
+
+uint32_t SurgeEngine::windowCount(const Zone& zone, int64_t bucket) const {
+    if (bucket <= zone.latest) {
+        return zone.windowRequests;
+    }
+    if (bucket - zone.latest >= static_cast<int64_t>(WINDOW_BUCKETS)) {
+        return 0;
+    }
+    uint32_t count = zone.windowRequests;
+    for (int64_t expired = zone.latest + 1; expired <= bucket; ++expired) {
+        count -= zone.buckets[static_cast<size_t>(expired) % WINDOW_BUCKETS];
+    }
+    return count;
+}
+
+void SurgeEngine::advance(Zone& zone, int64_t bucket) {
+    if (bucket <= zone.latest) {
+        return; // Slightly late timestamps count in the newest bucket
+    }
+    if (bucket - zone.latest >= static_cast<int64_t>(WINDOW_BUCKETS)) {
+        std::fill(std::begin(zone.buckets), std::end(zone.buckets), 0);
+        zone.windowRequests = 0;
+    } else {
+        for (int64_t expired = zone.latest + 1; expired <= bucket; ++expired) {
+            uint32_t& slot = zone.buckets[static_cast<size_t>(expired) % WINDOW_BUCKETS];
+            zone.windowRequests -= slot;
+            slot = 0;
+        }
+    }
+    zone.latest = bucket;
+}
+
+uint16_t SurgeEngine::surgePercent(uint32_t requests, uint32_t idleDrivers) const {
+    double perDriver = static_cast<double>(requests) / std::max<uint32_t>(idleDrivers, 1);
+    if (perDriver <= policy.threshold) {
+        return 100;
+    }
+    double multiplier = std::min(policy.maxMultiplier, 1.0 + policy.sensitivity * (perDriver - policy.threshold));
+    // Round down to the step (the epsilon keeps exact multiples from slipping a step)
+    double steps = std::floor((multiplier - 1.0) / policy.step + 1e-9);
+    long percent = std::lround((1.0 + steps * policy.step) * 100.0);
+    return static_cast<uint16_t>(std::min<long>(std::max<long>(percent, 100), UINT16_MAX));
+}
+
+void SurgeEngine::addIdle(GeoPoint point) {
+    zones[zoneKey(point)].idleDrivers++;
+}
+
+void SurgeEngine::removeIdle(GeoPoint point) {
+    auto it = zones.find(zoneKey(point));
+    if (it != zones.end() && it->second.idleDrivers > 0) {
+        it->second.idleDrivers--;
+    }
+}
+
+void SurgeEngine::setPolicy(const SurgePolicy& surgePolicy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool regrid = surgePolicy.zoneMiles != policy.zoneMiles || surgePolicy.windowMillis != policy.windowMillis;
+    policy = surgePolicy;
+    if (!regrid) {
+        return;
+    }
+    bucketMillis = std::max<int64_t>(1, policy.windowMillis / static_cast<int64_t>(WINDOW_BUCKETS));
+    zones.clear();
+    for (const DriverPosition& driver : drivers) {
+        if (driver.idle) {
+            addIdle(driver.point);
+        }
+    }
+}
+
+SurgePolicy SurgeEngine::getPolicy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return policy;
+}
+
+uint16_t SurgeEngine::quote(GeoPoint pickup, int64_t now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Zone& zone = zones[zoneKey(pickup)];
+    int64_t bucket = now / bucketMillis;
+    advance(zone, bucket);
+    zone.buckets[static_cast<size_t>(zone.latest) % WINDOW_BUCKETS]++;
+    zone.windowRequests++;
+    return surgePercent(zone.windowRequests, zone.idleDrivers);
+}
+
+void SurgeEngine::recordRequest(GeoPoint pickup, int64_t now) {
+    quote(pickup, now);
+}
+
+ZoneDemand SurgeEngine::zone(GeoPoint point, int64_t now) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    ZoneDemand demand;
+    demand.zoneX = zoneCoord(point.x);
+    demand.zoneY = zoneCoord(point.y);
+    auto it = zones.find(zoneKey(point));
+    if (it != zones.end()) {
+        demand.requests = windowCount(it->second, now / bucketMillis);
+        demand.idleDrivers = it->second.idleDrivers;
+    }
+    demand.surgePercent = surgePercent(demand.requests + 1, demand.idleDrivers);
+    return demand;
+}
+
+std::vector<ZoneDemand> SurgeEngine::surgingZones(int64_t now) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<ZoneDemand> result;
+    int64_t bucket = now / bucketMillis;
+    for (const auto& entry : zones) {
+        ZoneDemand demand;
+        demand.zoneX = static_cast<int32_t>(static_cast<uint32_t>(entry.first >> 32));
+        demand.zoneY = static_cast<int32_t>(static_cast<uint32_t>(entry.first));
+        demand.requests = windowCount(entry.second, bucket);
+        demand.idleDrivers = entry.second.idleDrivers;
+        demand.surgePercent = surgePercent(demand.requests + 1, demand.idleDrivers);
+        if (demand.surgePercent > 100) {
+            result.push_back(demand);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const ZoneDemand& a, const ZoneDemand& b) {
+        if (a.surgePercent != b.surgePercent) {
+            return a.surgePercent > b.surgePercent;
+        }
+        return a.zoneX < b.zoneX || (a.zoneX == b.zoneX && a.zoneY < b.zoneY);
+    });
+    return result;
+}
+
+void SurgeEngine::setDriverIdle(int driverID, GeoPoint point) {
+    if (driverID < 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t slot = static_cast<size_t>(driverID);
+    if (slot >= drivers.size()) {
+        drivers.resize(std::max(slot + 1, drivers.size() * 2));
+    }
+    DriverPosition& driver = drivers[slot];
+    if (driver.idle) {
+        if (zoneKey(driver.point) == zoneKey(point)) {
+            driver.point = point; // Moved within its zone
+            return;
+        }
+        removeIdle(driver.point);
+    }
+    addIdle(point);
+    driver.point = point;
+    driver.idle = true;
+}
+
+void SurgeEngine::setDriverBusy(int driverID) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t slot = static_cast<size_t>(driverID);
+    if (driverID < 0 || slot >= drivers.size() || !drivers[slot].idle) {
+        return;
+    }
+    removeIdle(drivers[slot].point);
+    drivers[slot].idle = false;
+}
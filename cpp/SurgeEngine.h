@@ -0,0 +1,141 @@
+#ifndef SURGE_ENGINE_H
+#define SURGE_ENGINE_H
+
+#include "GeoPoint.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * How demand and supply turn into a surge multiplier
+ * Surge starts once a zone has more than `threshold` recent requests per
+ * idle driver and grows by `sensitivity` for every request per driver
+ * beyond that, rounded down to `step` and capped at `maxMultiplier`.
+ */
+struct SurgePolicy {
+    double zoneMiles = 2.0;               // Edge length of a square pricing zone
+    int64_t windowMillis = 5 * 60 * 1000; // Requests are counted over this sliding window
+    double threshold = 2.0;               // Requests per idle driver absorbed without surging
+    double sensitivity = 0.25;            // Multiplier added per request per driver above the threshold
+    double maxMultiplier = 3.0;
+    double step = 0.1;                    // Quoted multipliers are multiples of this
+};
+
+/**
+ * Demand, supply and current surge of one zone
+ */
+struct ZoneDemand {
+    int32_t zoneX = 0;          // Zone grid coordinates (position / zoneMiles, rounded down)
+    int32_t zoneY = 0;
+    uint32_t requests = 0;      // Requests within the sliding window
+    uint32_t idleDrivers = 0;   // Drivers open for matching in the zone right now
+    uint16_t surgePercent = 100; // Multiplier a request would be quoted now, in percent
+
+    double multiplier() const { return surgePercent / 100.0; }
+};
+
+/**
+ * SurgeEngine - Per-zone demand tracking and surge quotes
+ * The plane is cut into square zones. Each zone keeps its request count as
+ * a sliding window of WINDOW_BUCKETS sub-buckets with a running sum, and
+ * the number of idle drivers inside it, updated as drivers move, become
+ * available or are matched. Quoting a request records it and prices it from
+ * those two numbers, so it costs one hash lookup and at most WINDOW_BUCKETS
+ * bucket resets - O(1) however many rides, drivers or zones there are.
+ *
+ * Thread safety: all operations are serialized by an internal mutex, a leaf
+ * lock (RideSharingSystem updates supply while holding its dispatch lock).
+ */
+class SurgeEngine {
+public:
+    static constexpr size_t WINDOW_BUCKETS = 10;
+
+private:
+    struct Zone {
+        int64_t latest = -1;                   // Newest bucket index counted so far
+        uint32_t buckets[WINDOW_BUCKETS] = {}; // Requests per sub-bucket, ring indexed
+        uint32_t windowRequests = 0;           // Sum of the live buckets
+        uint32_t idleDrivers = 0;
+    };
+
+    struct DriverPosition {
+        GeoPoint point;
+        bool idle = false; // Counted in the zone of point
+    };
+
+    SurgePolicy policy;
+    int64_t bucketMillis;
+    std::unordered_map<uint64_t, Zone> zones;
+    std::vector<DriverPosition> drivers; // Indexed by driver ID
+    mutable std::mutex mutex;
+
+    int32_t zoneCoord(double value) const;
+    uint64_t zoneKey(GeoPoint point) const;
+    // Requests still inside the window at a bucket index, without changing the zone
+    uint32_t windowCount(const Zone& zone, int64_t bucket) const;
+    // Slide the window forward to a bucket index, clearing buckets that fell out
+    void advance(Zone& zone, int64_t bucket);
+    uint16_t surgePercent(uint32_t requests, uint32_t idleDrivers) const;
+    void addIdle(GeoPoint point);
+    void removeIdle(GeoPoint point);
+
+public:
+    explicit SurgeEngine(const SurgePolicy& surgePolicy = SurgePolicy());
+
+    /**
+     * Replace the policy; idle drivers are re-counted under the new zones
+     * Request history is kept unless the zone size or window changed
+     * @param surgePolicy New policy
+     */
+    void setPolicy(const SurgePolicy& surgePolicy);
+
+    SurgePolicy getPolicy() const;
+
+    /**
+     * Count a ride request in its pickup zone and quote its surge
+     * @param pickup Pickup position
+     * @param now Request time (ms since epoch)
+     * @return Surge multiplier in percent (100 = none), including this request
+     */
+    uint16_t quote(GeoPoint pickup, int64_t now);
+
+    /**
+     * Count a request that could not be served (no quote, but it is still demand)
+     * @param pickup Pickup position
+     * @param now Request time (ms since epoch)
+     */
+    void recordRequest(GeoPoint pickup, int64_t now);
+
+    /**
+     * Demand, supply and the surge the next request would get, without counting anything
+     * @param point Any position in the zone
+     * @param now Current time (ms since epoch)
+     * @return Zone figures
+     */
+    ZoneDemand zone(GeoPoint point, int64_t now) const;
+
+    /**
+     * Zones currently above 1.0x, highest surge first
+     * Walks every zone - meant for reports, not for dispatch
+     * @param now Current time (ms since epoch)
+     * @return Surging zones
+     */
+    std::vector<ZoneDemand> surgingZones(int64_t now) const;
+
+    /**
+     * Count a driver as idle at a position (adds or moves it)
+     * @param driverID Non-negative driver ID
+     * @param point Driver position
+     */
+    void setDriverIdle(int driverID, GeoPoint point);
+
+    /**
+     * Stop counting a driver as idle (matched, offline or unknown position)
+     * @param driverID Driver ID
+     */
+    void setDriverBusy(int driverID);
+};
+
+#endif // SURGE_ENGINE_H
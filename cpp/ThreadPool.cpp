@@ -0,0 +1,87 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(size_t threadCount) : stopping(false) {
+    if (threadCount == 0) {
+        size_t hardware = std::thread::hardware_concurrency();
+        threadCount = (hardware > 1) ? hardware - 1 : 0;
+    }
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskReady.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    // Shared loop state outlives this call if a helper starts late
+    struct LoopState {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> finished{0};
+        std::mutex doneMutex;
+        std::condition_variable done;
+    };
+    auto state = std::make_shared<LoopState>();
+    size_t total = count;
+
+    auto runTasks = [state, total, &body]() {
+        size_t completed = 0;
+        size_t index;
+        while ((index = state->next.fetch_add(1)) < total) {
+            body(index);
+            completed++;
+        }
+        if (completed > 0 && state->finished.fetch_add(completed) + completed == total) {
+            std::lock_guard<std::mutex> lock(state->doneMutex);
+            state->done.notify_all();
+        }
+    };
+
+    size_t helpers = std::min(workers.size(), count - 1);
+    if (helpers > 0) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < helpers; ++i) {
+                tasks.emplace_back(runTasks);
+            }
+        }
+        taskReady.notify_all();
+    }
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(state->doneMutex);
+    state->done.wait(lock, [&]() { return state->finished.load() == total; });
+}
@@ -0,0 +1,57 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * ThreadPool - Fixed set of worker threads for data-parallel loops
+ * The calling thread takes part in parallelFor, so a pool with zero
+ * workers simply runs every task inline
+ */
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    bool stopping;
+
+    void workerLoop();
+
+public:
+    /**
+     * Start the worker threads
+     * @param threadCount Number of workers (0 = hardware concurrency - 1)
+     */
+    explicit ThreadPool(size_t threadCount = 0);
+
+    /**
+     * Stop and join all workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Run body(i) for every i in [0, count) across the pool and wait
+     * Indices are handed out dynamically, so callers must not rely on
+     * which thread runs which index
+     * @param count Number of tasks
+     * @param body Task function
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    /**
+     * Number of threads that run tasks, including the caller
+     */
+    size_t concurrency() const { return workers.size() + 1; }
+};
+
+#endif // THREAD_POOL_H
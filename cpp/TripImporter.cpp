@@ -0,0 +1,606 @@
+#include "TripImporter.h"
+#include "Logger.h"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const size_t BLOCK_SIZE = 1 << 20;
+const size_t MAX_REPORTED_ERRORS = 10;
+
+const char* const COLUMN_NAMES[] = {"type", "pickup", "dropoff", "distance", "driver", "rider"};
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && isSpace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && isSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool equalsIgnoreCase(std::string_view text, const char* name) {
+    size_t length = std::strlen(name);
+    if (text.size() != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        char c = text[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+        if (c != name[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void appendUtf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+}
+
+bool parseHex4(std::string_view text, size_t pos, uint32_t& code) {
+    if (pos + 4 > text.size()) {
+        return false;
+    }
+    code = 0;
+    for (size_t i = pos; i < pos + 4; ++i) {
+        char c = text[i];
+        code <<= 4;
+        if (c >= '0' && c <= '9') {
+            code |= static_cast<uint32_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            code |= static_cast<uint32_t>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            code |= static_cast<uint32_t>(c - 'A' + 10);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseNumber(std::string_view text, double& value) {
+    static const double POWERS[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    size_t i = 0;
+    size_t n = text.size();
+    bool negative = false;
+    if (i < n && (text[i] == '-' || text[i] == '+')) {
+        negative = text[i] == '-';
+        ++i;
+    }
+
+    // Up to 18 significant digits are kept exactly; any further digit forces the slow path
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    bool truncated = false;
+    for (; i < n && text[i] >= '0' && text[i] <= '9'; ++i) {
+        anyDigit = true;
+        if (mantissa < 100000000000000000ULL) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(text[i] - '0');
+        } else {
+            truncated = true;
+            exponent++;
+        }
+    }
+    if (i < n && text[i] == '.') {
+        for (++i; i < n && text[i] >= '0' && text[i] <= '9'; ++i) {
+            anyDigit = true;
+            if (mantissa < 100000000000000000ULL) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(text[i] - '0');
+                exponent--;
+            } else {
+                truncated = true;
+            }
+        }
+    }
+    if (!anyDigit) {
+        return false;
+    }
+    if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+        ++i;
+        bool negativeExponent = false;
+        if (i < n && (text[i] == '-' || text[i] == '+')) {
+            negativeExponent = text[i] == '-';
+            ++i;
+        }
+        int written = 0;
+        bool exponentDigit = false;
+        for (; i < n && text[i] >= '0' && text[i] <= '9'; ++i) {
+            exponentDigit = true;
+            written = std::min(written * 10 + (text[i] - '0'), 100000);
+        }
+        if (!exponentDigit) {
+            return false;
+        }
+        exponent += negativeExponent ? -written : written;
+    }
+    if (i != n) {
+        return false;
+    }
+
+    // Exact mantissa and power of ten give a correctly rounded result in one operation
+    if (!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / POWERS[-exponent] : result * POWERS[exponent];
+        value = negative ? -result : result;
+        return true;
+    }
+    char copy[64];
+    if (n >= sizeof(copy)) {
+        return false;
+    }
+    std::memcpy(copy, text.data(), n);
+    copy[n] = '\0';
+    value = std::strtod(copy, nullptr);
+    return std::isfinite(value);
+}
+
+TripImporter::TripImporter(RideSharingSystem& rideSystem, size_t batchRides)
+    : system(rideSystem), batchSize(batchRides > 0 ? batchRides : 1), batch(batchSize),
+      batchTypes(batchSize) {
+    for (int& column : columns) {
+        column = -1;
+    }
+}
+
+bool TripImporter::importFile(const std::string& path, Format format) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        LOG_ERROR("Cannot open trip log: " << path);
+        return false;
+    }
+    return importStream(in, format);
+}
+
+bool TripImporter::importStream(std::istream& in, Format format) {
+    auto start = std::chrono::steady_clock::now();
+    active = format;
+    haveHeader = false;
+
+    // Lines are cut out of a large block; a partial last line moves to the front for the next read
+    std::vector<char> block(BLOCK_SIZE);
+    size_t filled = 0;
+    bool ok = true;
+    while (ok) {
+        in.read(block.data() + filled, static_cast<std::streamsize>(block.size() - filled));
+        size_t got = static_cast<size_t>(in.gcount());
+        stats.bytes += got;
+        filled += got;
+
+        size_t consumed = 0;
+        while (ok) {
+            const char* begin = block.data() + consumed;
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', filled - consumed));
+            if (!newline) {
+                break;
+            }
+            ok = handleLine(std::string_view(begin, static_cast<size_t>(newline - begin)));
+            consumed = static_cast<size_t>(newline - block.data()) + 1;
+        }
+        if (got == 0) {
+            if (ok && consumed < filled) {
+                ok = handleLine(std::string_view(block.data() + consumed, filled - consumed));
+            }
+            break;
+        }
+        std::memmove(block.data(), block.data() + consumed, filled - consumed);
+        filled -= consumed;
+        if (filled == block.size()) {
+            block.resize(block.size() * 2); // A single line longer than the block
+        }
+    }
+    if (in.bad()) {
+        LOG_ERROR("Read error while importing trips");
+        ok = false;
+    }
+    flushBatch();
+
+    stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+bool TripImporter::handleLine(std::string_view line) {
+    stats.lines++;
+    line = trim(line);
+    if (line.empty()) {
+        return true;
+    }
+    unescapedUsed = 0;
+    if (active == Format::Auto) {
+        active = (line.front() == '{') ? Format::Jsonl : Format::Csv;
+    }
+    if (active == Format::Csv && !haveHeader) {
+        haveHeader = parseHeader(line);
+        return haveHeader;
+    }
+
+    Trip trip;
+    const char* error = (active == Format::Csv) ? parseCsv(line, trip) : parseJson(line, trip);
+    if (error) {
+        reject(error);
+        return true;
+    }
+    addTrip(trip);
+    return true;
+}
+
+std::string& TripImporter::scratch() {
+    if (unescapedUsed == unescaped.size()) {
+        unescaped.emplace_back();
+    }
+    std::string& text = unescaped[unescapedUsed++];
+    text.clear();
+    return text;
+}
+
+bool TripImporter::splitCsv(std::string_view line) {
+    fields.clear();
+    size_t pos = 0;
+    while (true) {
+        if (pos < line.size() && line[pos] == '"') {
+            // Quoted field; a doubled quote stands for one quote character
+            size_t begin = ++pos;
+            bool escaped = false;
+            size_t end;
+            while (true) {
+                size_t quote = line.find('"', pos);
+                if (quote == std::string_view::npos) {
+                    return false;
+                }
+                if (quote + 1 < line.size() && line[quote + 1] == '"') {
+                    escaped = true;
+                    pos = quote + 2;
+                    continue;
+                }
+                end = quote;
+                pos = quote + 1;
+                break;
+            }
+            std::string_view field = line.substr(begin, end - begin);
+            if (escaped) {
+                std::string& text = scratch();
+                for (size_t i = 0; i < field.size(); ++i) {
+                    text.push_back(field[i]);
+                    if (field[i] == '"') {
+                        ++i;
+                    }
+                }
+                field = text;
+            }
+            fields.push_back(field);
+            while (pos < line.size() && isSpace(line[pos])) {
+                ++pos;
+            }
+            if (pos == line.size()) {
+                return true;
+            }
+            if (line[pos] != ',') {
+                return false;
+            }
+            ++pos;
+            continue;
+        }
+        size_t comma = line.find(',', pos);
+        if (comma == std::string_view::npos) {
+            fields.push_back(trim(line.substr(pos)));
+            return true;
+        }
+        fields.push_back(trim(line.substr(pos, comma - pos)));
+        pos = comma + 1;
+    }
+}
+
+bool TripImporter::parseHeader(std::string_view line) {
+    if (!splitCsv(line)) {
+        LOG_ERROR("Malformed CSV header");
+        return false;
+    }
+    for (int& column : columns) {
+        column = -1;
+    }
+    for (size_t i = 0; i < fields.size(); ++i) {
+        for (int c = 0; c < COLUMN_COUNT; ++c) {
+            if (equalsIgnoreCase(fields[i], COLUMN_NAMES[c])) {
+                columns[c] = static_cast<int>(i);
+            }
+        }
+    }
+    for (int c = PICKUP; c < COLUMN_COUNT; ++c) {
+        if (columns[c] < 0) {
+            LOG_ERROR("CSV header is missing the " << COLUMN_NAMES[c] << " column");
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* TripImporter::parseCsv(std::string_view line, Trip& trip) {
+    if (!splitCsv(line)) {
+        return "malformed quoting";
+    }
+    for (int column : columns) {
+        if (column >= static_cast<int>(fields.size())) {
+            return "too few fields";
+        }
+    }
+    if (columns[TYPE] >= 0) {
+        trip.type = fields[columns[TYPE]];
+    }
+    trip.pickup = fields[columns[PICKUP]];
+    trip.dropoff = fields[columns[DROPOFF]];
+    trip.driver = fields[columns[DRIVER]];
+    trip.rider = fields[columns[RIDER]];
+    if (!parseNumber(fields[columns[DISTANCE]], trip.distance)) {
+        return "distance is not a number";
+    }
+    return nullptr;
+}
+
+bool TripImporter::parseJsonString(std::string_view line, size_t& pos, std::string_view& value) {
+    // pos is at the opening quote; strings without escapes are returned in place
+    size_t begin = ++pos;
+    size_t end = line.find_first_of("\"\\", begin);
+    if (end == std::string_view::npos) {
+        return false;
+    }
+    if (line[end] == '"') {
+        value = line.substr(begin, end - begin);
+        pos = end + 1;
+        return true;
+    }
+
+    std::string& text = scratch();
+    text.append(line.data() + begin, end - begin);
+    pos = end;
+    while (pos < line.size()) {
+        char c = line[pos++];
+        if (c == '"') {
+            value = text;
+            return true;
+        }
+        if (c != '\\') {
+            text.push_back(c);
+            continue;
+        }
+        if (pos == line.size()) {
+            return false;
+        }
+        char escape = line[pos++];
+        switch (escape) {
+            case '"': text.push_back('"'); break;
+            case '\\': text.push_back('\\'); break;
+            case '/': text.push_back('/'); break;
+            case 'b': text.push_back('\b'); break;
+            case 'f': text.push_back('\f'); break;
+            case 'n': text.push_back('\n'); break;
+            case 'r': text.push_back('\r'); break;
+            case 't': text.push_back('\t'); break;
+            case 'u': {
+                uint32_t code;
+                if (!parseHex4(line, pos, code)) {
+                    return false;
+                }
+                pos += 4;
+                // A high surrogate must be followed by an escaped low surrogate
+                if (code >= 0xD800 && code < 0xDC00) {
+                    uint32_t low;
+                    if (pos + 1 >= line.size() || line[pos] != '\\' || line[pos + 1] != 'u' ||
+                        !parseHex4(line, pos + 2, low) || low < 0xDC00 || low >= 0xE000) {
+                        return false;
+                    }
+                    pos += 6;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(text, code);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+const char* TripImporter::parseJson(std::string_view line, Trip& trip) {
+    size_t pos = 0;
+    auto skipSpaces = [&]() {
+        while (pos < line.size() && isSpace(line[pos])) {
+            ++pos;
+        }
+    };
+
+    if (line[pos] != '{') {
+        return "expected a JSON object";
+    }
+    ++pos;
+    skipSpaces();
+    bool haveDistance = false;
+    unsigned seen = 0;
+    if (pos < line.size() && line[pos] == '}') {
+        ++pos;
+    } else {
+        while (true) {
+            std::string_view name;
+            if (pos >= line.size() || line[pos] != '"' || !parseJsonString(line, pos, name)) {
+                return "malformed JSON key";
+            }
+            skipSpaces();
+            if (pos >= line.size() || line[pos] != ':') {
+                return "malformed JSON object";
+            }
+            ++pos;
+            skipSpaces();
+
+            std::string_view value;
+            bool isString = false;
+            if (pos < line.size() && line[pos] == '"') {
+                if (!parseJsonString(line, pos, value)) {
+                    return "malformed JSON string";
+                }
+                isString = true;
+            } else {
+                // Numbers and literals run to the next delimiter; nested values are not trips
+                size_t begin = pos;
+                while (pos < line.size() && line[pos] != ',' && line[pos] != '}' && !isSpace(line[pos])) {
+                    if (line[pos] == '{' || line[pos] == '[') {
+                        return "nested JSON values are not supported";
+                    }
+                    ++pos;
+                }
+                value = line.substr(begin, pos - begin);
+                if (value.empty()) {
+                    return "malformed JSON value";
+                }
+            }
+
+            for (int c = 0; c < COLUMN_COUNT; ++c) {
+                if (name != COLUMN_NAMES[c]) {
+                    continue;
+                }
+                seen |= 1u << c;
+                switch (c) {
+                    case TYPE: trip.type = value; break;
+                    case PICKUP: trip.pickup = value; break;
+                    case DROPOFF: trip.dropoff = value; break;
+                    case DRIVER: trip.driver = value; break;
+                    case RIDER: trip.rider = value; break;
+                    case DISTANCE:
+                        haveDistance = parseNumber(value, trip.distance);
+                        break;
+                }
+                if (c != DISTANCE && !isString) {
+                    return "expected a JSON string";
+                }
+            }
+
+            skipSpaces();
+            if (pos < line.size() && line[pos] == ',') {
+                ++pos;
+                skipSpaces();
+                continue;
+            }
+            if (pos < line.size() && line[pos] == '}') {
+                ++pos;
+                break;
+            }
+            return "malformed JSON object";
+        }
+    }
+    skipSpaces();
+    if (pos != line.size()) {
+        return "trailing characters after JSON object";
+    }
+    const unsigned required = (1u << PICKUP) | (1u << DROPOFF) | (1u << DISTANCE) | (1u << DRIVER) | (1u << RIDER);
+    if ((seen & required) != required) {
+        return "missing trip fields";
+    }
+    if (!haveDistance) {
+        return "distance is not a number";
+    }
+    return nullptr;
+}
+
+void TripImporter::addTrip(const Trip& trip) {
+    if (trip.driver.empty() || trip.rider.empty()) {
+        reject("missing driver or rider name");
+        return;
+    }
+    if (!(trip.distance >= 0.0)) {
+        reject("negative distance");
+        return;
+    }
+
+    RideType& type = batchTypes[pending];
+    if (trip.type.empty()) {
+        type = RideType::Standard;
+    } else if (!RideSharingSystem::parseRideType(trip.type, type)) {
+        reject("unknown ride type");
+        return;
+    }
+    // Reuse the batch slot's strings so steady-state imports do not allocate
+    RideRequest& request = batch[pending];
+    request.pickup.assign(trip.pickup.data(), trip.pickup.size());
+    request.dropoff.assign(trip.dropoff.data(), trip.dropoff.size());
+    request.distance = trip.distance;
+    request.driver = driverFor(trip.driver);
+    request.rider = riderFor(trip.rider);
+    if (++pending == batchSize) {
+        flushBatch();
+    }
+}
+
+void TripImporter::flushBatch() {
+    if (pending == 0) {
+        return;
+    }
+    for (const auto& ride : system.createRides(batch.data(), batchTypes.data(), pending)) {
+        if (ride) {
+            stats.imported++;
+        } else {
+            stats.rejected++;
+        }
+    }
+    pending = 0;
+}
+
+void TripImporter::reject(const char* reason) {
+    stats.rejected++;
+    if (reportedErrors < MAX_REPORTED_ERRORS) {
+        LOG_WARN("Skipping trip on line " << stats.lines << ": " << reason);
+    } else if (reportedErrors == MAX_REPORTED_ERRORS) {
+        LOG_WARN("Further skipped trips are not reported");
+    }
+    reportedErrors++;
+}
+
+Driver* TripImporter::driverFor(std::string_view name) {
+    key.assign(name.data(), name.size());
+    auto it = driversByName.find(key);
+    if (it != driversByName.end()) {
+        return it->second;
+    }
+    Driver* driver = system.addDriver(key);
+    driversByName.emplace(key, driver);
+    return driver;
+}
+
+Rider* TripImporter::riderFor(std::string_view name) {
+    key.assign(name.data(), name.size());
+    auto it = ridersByName.find(key);
+    if (it != ridersByName.end()) {
+        return it->second;
+    }
+    Rider* rider = system.addRider(key);
+    ridersByName.emplace(key, rider);
+    return rider;
+}
@@ -0,0 +1,126 @@
+#ifndef TRIP_IMPORTER_H
+#define TRIP_IMPORTER_H
+
+#include "RideSharingSystem.h"
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Counters reported after an import
+ */
+struct ImportStats {
+    size_t lines = 0;     // Lines read, including the CSV header and blank lines
+    size_t imported = 0;  // Rides created
+    size_t rejected = 0;  // Malformed lines and rides createRides refused
+    size_t bytes = 0;
+    double seconds = 0.0;
+
+    double tripsPerSecond() const { return seconds > 0.0 ? imported / seconds : 0.0; }
+    double megabytesPerSecond() const { return seconds > 0.0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0; }
+};
+
+/**
+ * TripImporter - Streams a trip log into a RideSharingSystem
+ * Input is read in large blocks and split into lines in place; fields are
+ * string_views into the block, so parsing allocates nothing per trip.
+ * Parsed trips fill a reusable batch of RideRequests that is committed
+ * through createRides (one fare-kernel pass and one log lock per batch).
+ * Ride types are resolved straight from the field view, once per trip.
+ *
+ * Accepted formats, one trip per line:
+ * - CSV with a header naming the columns type, pickup, dropoff, distance,
+ *   driver and rider (type is optional and defaults to "standard"; other
+ *   columns are ignored; fields may be double-quoted)
+ * - JSONL, one flat object per line with the same keys
+ * Drivers and riders are identified by name and created on first sight.
+ */
+class TripImporter {
+public:
+    enum class Format { Auto, Csv, Jsonl };
+
+private:
+    // Fields of one trip, viewing the current input block
+    struct Trip {
+        std::string_view type;
+        std::string_view pickup;
+        std::string_view dropoff;
+        std::string_view driver;
+        std::string_view rider;
+        double distance = 0.0;
+    };
+
+    enum Column { TYPE, PICKUP, DROPOFF, DISTANCE, DRIVER, RIDER, COLUMN_COUNT };
+
+    RideSharingSystem& system;
+    size_t batchSize;
+    std::vector<RideRequest> batch; // Reused; strings keep their capacity between batches
+    std::vector<RideType> batchTypes; // Type of each batch slot, parsed from the trip field
+    size_t pending = 0;
+    std::unordered_map<std::string, Driver*> driversByName;
+    std::unordered_map<std::string, Rider*> ridersByName;
+    std::string key;                    // Scratch for name lookups
+    std::deque<std::string> unescaped;  // Scratch for fields with escapes (stable addresses)
+    size_t unescapedUsed = 0;
+    std::vector<std::string_view> fields;
+    int columns[COLUMN_COUNT];      // CSV column of each field, -1 if absent
+    Format active = Format::Auto;   // Format of the stream being imported
+    bool haveHeader = false;
+    size_t reportedErrors = 0;
+    ImportStats stats;
+
+    bool handleLine(std::string_view line);
+    bool parseHeader(std::string_view line);
+    bool splitCsv(std::string_view line);
+    const char* parseCsv(std::string_view line, Trip& trip);  // nullptr on success, else the reason
+    const char* parseJson(std::string_view line, Trip& trip);
+    bool parseJsonString(std::string_view line, size_t& pos, std::string_view& value);
+    void addTrip(const Trip& trip);
+    void flushBatch();
+    void reject(const char* reason);
+    std::string& scratch();
+    Driver* driverFor(std::string_view name);
+    Rider* riderFor(std::string_view name);
+
+public:
+    /**
+     * @param rideSystem System that receives the trips
+     * @param batchRides Trips committed per createRides call
+     */
+    explicit TripImporter(RideSharingSystem& rideSystem, size_t batchRides = 4096);
+
+    /**
+     * Import every trip in a file
+     * @param path CSV or JSONL file
+     * @param format Input format (Auto: JSONL if the first character is '{')
+     * @return False if the file cannot be read or a CSV header is unusable
+     */
+    bool importFile(const std::string& path, Format format = Format::Auto);
+
+    /**
+     * Import every trip from a stream
+     * @param in Input stream
+     * @param format Input format (Auto: JSONL if the first character is '{')
+     * @return False if the stream fails or a CSV header is unusable
+     */
+    bool importStream(std::istream& in, Format format = Format::Auto);
+
+    /**
+     * Counters accumulated over every import so far
+     */
+    const ImportStats& getStats() const { return stats; }
+};
+
+/**
+ * Parse a decimal number such as "12.5" or "-3e2" without allocating
+ * @param text Number text, no surrounding spaces
+ * @param value Receives the parsed value
+ * @return True if the whole text is a finite number
+ */
+bool parseNumber(std::string_view text, double& value);
+
+#endif // TRIP_IMPORTER_H
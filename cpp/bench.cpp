@@ -0,0 +1,1201 @@
+#include "RideSharingSystem.h"
+#include "Logger.h"
+#include "FareKernel.h"
+#include "StatsEngine.h"
+#include "DispatchEngine.h"
+#include "TripImporter.h"
+#include "Metrics.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <new>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Benchmarks for the Ride Sharing System hot paths
+ * Run with: make bench (results also go to bench_results.json)
+ *
+ * Every measurement reports ns/op, heap allocations/op and the peak RSS of
+ * its benchmark group. Options:
+ *   --json <file>      Write all measurements as JSON
+ *   --compare <file>   Show the change against a JSON file from an earlier run
+ *   --filter <text>    Run only groups whose name contains the text
+ *   --max-rides <n>    Skip ride counts above n (the largest is 10M)
+ */
+
+// Heap accounting used for memory-per-object measurements
+static std::atomic<size_t> allocatedBytes{0};
+static std::atomic<size_t> allocationCount{0};
+
+void* operator new(size_t size) {
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// Kept out of line so GCC does not flag the inlined free() as mismatched with new
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+/**
+ * Discards std::cout output while in scope so setup logging does not
+ * dominate the measurements
+ */
+class QuietScope {
+private:
+    std::streambuf* saved;
+
+public:
+    QuietScope() : saved(std::cout.rdbuf(nullptr)) {}
+    ~QuietScope() {
+        std::cout.rdbuf(saved);
+        std::cout.clear();
+    }
+};
+
+// Keeps the optimizer from discarding benchmark results
+volatile size_t sink = 0;
+
+/**
+ * Cost of one operation: wall-clock time and heap traffic
+ */
+struct Sample {
+    double ns = 0.0;
+    double allocs = 0.0;
+    double bytes = 0.0;
+
+    // Spread a sample over the items one operation handled (e.g. rides per batch)
+    Sample perItem(size_t items) const {
+        return {ns / items, allocs / items, bytes / items};
+    }
+};
+
+template <typename Func>
+Sample measure(size_t ops, Func&& body) {
+    size_t allocsBefore = allocationCount.load();
+    size_t bytesBefore = allocatedBytes.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        body(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    Sample sample;
+    sample.ns = std::chrono::duration<double, std::nano>(end - start).count() / ops;
+    sample.allocs = static_cast<double>(allocationCount.load() - allocsBefore) / ops;
+    sample.bytes = static_cast<double>(allocatedBytes.load() - bytesBefore) / ops;
+    return sample;
+}
+
+/**
+ * Peak resident set size of the process since the last resetPeakRss()
+ * Linux reads VmHWM; elsewhere the lifetime maximum from getrusage
+ */
+size_t peakRssBytes() {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+        }
+    }
+#endif
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss); // Bytes on macOS
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+/**
+ * Start a new peak RSS window (Linux only; a no-op where unsupported)
+ */
+void resetPeakRss() {
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+/**
+ * One reported measurement, as written to the machine-readable results
+ */
+struct BenchResult {
+    std::string name;
+    size_t n;
+    Sample sample;
+    size_t peakRss;
+};
+
+std::vector<BenchResult> results;
+
+void report(const std::string& name, size_t n, const Sample& sample) {
+    results.push_back({name, n, sample, peakRssBytes()});
+    std::cout << std::left << std::setw(28) << name
+              << " n=" << std::setw(9) << n
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << sample.ns << " ns/op"
+              << std::setprecision(2) << std::setw(10) << sample.allocs << " allocs/op"
+              << std::setw(8) << results.back().peakRss / (1024 * 1024) << " MiB peak" << std::endl;
+}
+
+/**
+ * Compare the original linear find_if scan with the indexed findDriver
+ */
+void benchDriverLookup(size_t driverCount) {
+    std::unique_ptr<RideSharingSystem> system;
+    std::vector<Driver*> drivers; // Same layout the old find_if walked
+    {
+        QuietScope quiet;
+        system = std::make_unique<RideSharingSystem>();
+        drivers.reserve(driverCount);
+        for (size_t i = 0; i < driverCount; ++i) {
+            drivers.push_back(system->addDriver("Driver"));
+        }
+    }
+
+    // Linear scans get fewer iterations so large sizes finish quickly
+    size_t linearOps = std::max<size_t>(100, 20000000 / driverCount);
+    size_t indexOps = 10000000;
+    uint64_t seed = 88172645463325252ULL;
+    auto nextID = [&]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return static_cast<int>(seed % driverCount) + 1;
+    };
+
+    Sample linear = measure(linearOps, [&](size_t) {
+        int id = nextID();
+        auto it = std::find_if(drivers.begin(), drivers.end(),
+                               [id](const Driver* driver) {
+                                   return driver->getDriverID() == id;
+                               });
+        sink = sink + ((it != drivers.end()) ? 1 : 0);
+    });
+    report("findDriver/linear", driverCount, linear);
+
+    Sample indexed = measure(indexOps, [&](size_t) {
+        sink = sink + (system->findDriver(nextID()) ? 1 : 0);
+    });
+    report("findDriver/index", driverCount, indexed);
+}
+
+/**
+ * Compare one createRide call per ride with a single createRides batch
+ */
+void benchRideCreation(size_t rideCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    std::vector<RideRequest> requests;
+    std::unique_ptr<RideSharingSystem> single;
+    std::unique_ptr<RideSharingSystem> batch;
+    {
+        QuietScope quiet;
+        single = std::make_unique<RideSharingSystem>();
+        batch = std::make_unique<RideSharingSystem>();
+        for (int i = 0; i < 100; ++i) {
+            single->addDriver("Driver");
+            single->addRider("Rider");
+            batch->addDriver("Driver");
+            batch->addRider("Rider");
+        }
+    }
+    
+    static const char* types[] = {"standard", "premium", "economy"};
+    for (size_t i = 0; i < rideCount; ++i) {
+        int driverID = static_cast<int>(i % 100) + 1;
+        int riderID = static_cast<int>((i * 7) % 100) + 1;
+        requests.push_back({types[i % 3], "Downtown", "Airport", 5.0 + (i % 20),
+                            batch->findDriver(driverID), batch->findRider(riderID)});
+    }
+    
+    Sample perRide = measure(rideCount, [&](size_t i) {
+        const RideRequest& request = requests[i];
+        single->createRide(request.rideType, request.pickup, request.dropoff, request.distance,
+                           single->findDriver(request.driver->getDriverID()),
+                           single->findRider(request.rider->getRiderID()));
+    });
+    report("createRide/single", rideCount, perRide);
+    
+    Sample batched = measure(1, [&](size_t) { sink = sink + batch->createRides(requests).size(); });
+    report("createRides/batch", rideCount, batched.perItem(rideCount));
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Ride type names resolved through the registry's perfect hash versus the
+ * string comparison chain createRide used before
+ */
+void benchRideTypeParse(size_t lookups) {
+    static const std::string names[] = {"standard", "premium", "economy", "scooter"};
+    auto chain = [](const std::string& name, RideType& type) {
+        if (name == "standard") {
+            type = RideType::Standard;
+        } else if (name == "premium") {
+            type = RideType::Premium;
+        } else if (name == "economy") {
+            type = RideType::Economy;
+        } else {
+            return false;
+        }
+        return true;
+    };
+    RideType type = RideType::Custom;
+    Sample chained = measure(lookups, [&](size_t i) {
+        sink = sink + (chain(names[i & 3], type) ? static_cast<size_t>(type) : 0);
+    });
+    report("rideType/if-chain", lookups, chained);
+    Sample hashed = measure(lookups, [&](size_t i) {
+        sink = sink + (RideSharingSystem::parseRideType(names[i & 3], type) ? static_cast<size_t>(type) : 0);
+    });
+    report("rideType/perfect-hash", lookups, hashed);
+}
+
+/**
+ * Heap bytes per ride object, using a few thousand distinct location names
+ */
+void benchRideMemory(size_t rideCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    const size_t locationCount = 4000;
+    std::vector<std::string> locations;
+    for (size_t i = 0; i < locationCount; ++i) {
+        locations.push_back("Location #" + std::to_string(i) + " - Metro Area");
+    }
+    std::vector<std::shared_ptr<Ride>> rides;
+    rides.reserve(rideCount);
+
+    Sample created = measure(rideCount, [&](size_t i) {
+        rides.push_back(std::make_shared<StandardRide>(static_cast<int>(i),
+                                                       locations[i % locationCount],
+                                                       locations[(i * 31) % locationCount],
+                                                       5.0));
+    });
+    report("ride/memory", rideCount, created);
+    std::cout << "  (" << std::setprecision(0) << created.bytes << " bytes/ride, sizeof(StandardRide)="
+              << sizeof(StandardRide) << ")" << std::endl;
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Ride objects from the general heap (the previous make_shared) versus the
+ * type-segregated pools, then location text in std::strings versus the arena
+ * Run one variant alone (--filter ride-alloc-pool or ride-alloc-heap) for a clean peak RSS.
+ */
+void benchRideAllocation(size_t rideCount, bool pooled) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    LocationPool locations(pooled ? StringStorage::Arena : StringStorage::Heap);
+    Sample interned = measure(rideCount, [&](size_t i) {
+        locations.intern("Location #" + std::to_string(i) + " - Greater Metro Area");
+    });
+    report(pooled ? "ride-alloc/intern-arena" : "ride-alloc/intern-heap", rideCount, interned);
+    
+    std::vector<std::shared_ptr<Ride>> rides;
+    rides.reserve(rideCount);
+    size_t poolBefore = ridePoolStats().reservedBytes;
+    Sample created = measure(rideCount, [&](size_t i) {
+        int id = static_cast<int>(i);
+        if (pooled) {
+            rides.push_back(allocatePooled<StandardRide>(id, "Alloc A", "Alloc B", 5.0));
+        } else {
+            rides.push_back(std::make_shared<StandardRide>(id, "Alloc A", "Alloc B", 5.0));
+        }
+    });
+    report(pooled ? "ride-alloc/pooled" : "ride-alloc/make_shared", rideCount, created);
+    // Heap blocks also carry malloc's 8-byte header, rounded to 16 bytes
+    double bytesPerRide = pooled
+        ? static_cast<double>(ridePoolStats().reservedBytes - poolBefore) / rideCount
+        : (std::ceil((created.bytes + 8) / 16)) * 16;
+    std::cout << "  (" << std::setprecision(0) << bytesPerRide << " bytes/ride)" << std::endl;
+    
+    Sample released = measure(1, [&](size_t) { rides.clear(); });
+    report(pooled ? "ride-alloc/pooled-free" : "ride-alloc/make_shared-free", rideCount,
+           released.perItem(rideCount));
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Compare per-ride virtual fare() calls with the batch fare kernel
+ */
+void benchFareComputation(size_t rideCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    std::vector<std::shared_ptr<Ride>> rides;
+    std::vector<double> distances;
+    std::vector<RideType> types;
+    rides.reserve(rideCount);
+    for (size_t i = 0; i < rideCount; ++i) {
+        RideType type = static_cast<RideType>(i % 3);
+        double distance = 1.0 + (i % 40) * 0.5;
+        rides.push_back(makeRide(type, static_cast<int>(i), "Downtown", "Airport", distance));
+        distances.push_back(distance);
+        types.push_back(type);
+    }
+    std::vector<double> fares(rideCount);
+    const size_t passes = 20;
+
+    Sample virtualNs = measure(passes, [&](size_t) {
+        double total = 0.0;
+        for (const auto& ride : rides) {
+            total += ride->fare();
+        }
+        sink = sink + static_cast<size_t>(total);
+    }).perItem(rideCount);
+    report("fare/virtual", rideCount, virtualNs);
+
+    Sample kernelNs = measure(passes, [&](size_t) {
+        FareKernel::computeFares(distances.data(), types.data(), fares.data(), rideCount);
+        sink = sink + static_cast<size_t>(fares[rideCount / 2]);
+    }).perItem(rideCount);
+    report(std::string("fare/kernel-") + FareKernel::implementation(), rideCount, kernelNs);
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Compare the statistics pass on one thread with the full worker pool
+ */
+void benchStats(size_t rideCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    RideStore store;
+    store.reserve(rideCount);
+    for (size_t i = 0; i < rideCount; ++i) {
+        auto ride = makeRide(static_cast<RideType>(i % 3), static_cast<int>(i + 1),
+                             "Downtown", "Airport", 1.0 + (i % 40) * 0.5);
+        store.append(*ride, static_cast<int>(i % 1000) + 1, 1);
+    }
+    const size_t passes = 10;
+
+    StatsEngine single(1);
+    Sample singleNs = measure(passes, [&](size_t) {
+        sink = sink + single.compute(store, 1000).rideCount;
+    }).perItem(rideCount);
+    report("stats/1-thread", rideCount, singleNs);
+
+    StatsEngine pool;
+    Sample poolNs = measure(passes, [&](size_t) {
+        sink = sink + pool.compute(store, 1000).rideCount;
+    }).perItem(rideCount);
+    report("stats/" + std::to_string(pool.concurrency()) + "-threads", rideCount, poolNs);
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Aggregate createRide throughput with 1..N dispatcher threads sharing one system
+ * Reported as wall-clock ns per ride across all threads (lower is better)
+ */
+void benchConcurrentDispatch(size_t ridesPerThread) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    size_t maxThreads = std::max<size_t>(4, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        std::unique_ptr<RideSharingSystem> system;
+        {
+            QuietScope quiet;
+            system = std::make_unique<RideSharingSystem>();
+            for (int i = 0; i < 1000; ++i) {
+                system->addDriver("Driver");
+                system->addRider("Rider");
+            }
+        }
+        
+        Sample run = measure(1, [&](size_t) {
+            std::vector<std::thread> dispatchers;
+            for (size_t t = 0; t < threads; ++t) {
+                dispatchers.emplace_back([&system, t, ridesPerThread]() {
+                    static const char* types[] = {"standard", "premium", "economy"};
+                    for (size_t i = 0; i < ridesPerThread; ++i) {
+                        int id = static_cast<int>((t * 131 + i) % 1000) + 1;
+                        system->createRide(types[i % 3], "Downtown", "Airport", 5.0 + (i % 20),
+                                           system->findDriver(id), system->findRider(id));
+                    }
+                });
+            }
+            for (auto& dispatcher : dispatchers) {
+                dispatcher.join();
+            }
+        });
+        
+        size_t total = threads * ridesPerThread;
+        report("dispatch/" + std::to_string(threads) + "-threads", total, run.perItem(total));
+    }
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Position updates and nearest-driver matching with many moving drivers
+ */
+void benchSpatialMatching(size_t driverCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    const double areaMiles = 30.0;
+    unsigned seed = 42;
+    auto next = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<double>((seed >> 8) % 1000000) / 1000000.0;
+    };
+    
+    std::unique_ptr<RideSharingSystem> system;
+    std::vector<GeoPoint> positions;
+    Rider* rider;
+    {
+        QuietScope quiet;
+        system = std::make_unique<RideSharingSystem>();
+        for (size_t i = 0; i < driverCount; ++i) {
+            positions.push_back({next() * areaMiles, next() * areaMiles});
+            system->addDriver("Driver", 5.0, positions.back());
+        }
+        rider = system->addRider("Rider");
+    }
+    
+    const size_t ops = 200000;
+    Sample updateNs = measure(ops, [&](size_t i) {
+        size_t index = i % driverCount;
+        GeoPoint& point = positions[index];
+        point.x = std::min(areaMiles, std::max(0.0, point.x + (next() - 0.5) * 0.2));
+        point.y = std::min(areaMiles, std::max(0.0, point.y + (next() - 0.5) * 0.2));
+        system->updateDriverLocation(static_cast<int>(index) + 1, point);
+    });
+    report("driver/update-location", driverCount, updateNs);
+    
+    Sample nearestNs = measure(ops, [&](size_t) {
+        auto drivers = system->findNearestDrivers({next() * areaMiles, next() * areaMiles}, 1);
+        sink = sink + drivers.size();
+    });
+    report("driver/nearest-grid", driverCount, nearestNs);
+    
+    // What matching costs without the index
+    Sample linearNs = measure(200, [&](size_t) {
+        GeoPoint query = {next() * areaMiles, next() * areaMiles};
+        double best = 1e300;
+        size_t bestIndex = 0;
+        for (size_t d = 0; d < positions.size(); ++d) {
+            double d2 = squaredDistance(query, positions[d]);
+            if (d2 < best) {
+                best = d2;
+                bestIndex = d;
+            }
+        }
+        sink = sink + bestIndex;
+    });
+    report("driver/nearest-linear", driverCount, linearNs);
+    
+    // Full request: match, create the ride, release the driver again
+    Sample requestNs = measure(ops, [&](size_t) {
+        auto ride = system->requestRide(rider, "Downtown", {next() * areaMiles, next() * areaMiles},
+                                        "Airport", 5.0);
+        system->setDriverAvailable(system->getRideStore().getDriverIDs().back(), true);
+        sink = sink + static_cast<size_t>(ride->getRideID());
+    });
+    report("requestRide/match+create", driverCount, requestNs);
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Batched dispatch versus greedy nearest-driver matching on the same requests
+ * Reports the assignment solve time per batch and total pickup miles of both
+ */
+void benchBatchDispatch(size_t batchSize) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    // Peak load: only a few more drivers than requests, about 20 drivers per square mile
+    const size_t driverCount = batchSize + batchSize / 5;
+    const double areaMiles = std::sqrt(driverCount / 20.0);
+    unsigned seed = 99;
+    auto next = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<double>((seed >> 8) % 1000000) / 1000000.0;
+    };
+    
+    std::unique_ptr<RideSharingSystem> greedySystem;
+    std::unique_ptr<RideSharingSystem> batchSystem;
+    std::vector<GeoPoint> pickups;
+    Rider* greedyRider;
+    Rider* batchRider;
+    {
+        QuietScope quiet;
+        greedySystem = std::make_unique<RideSharingSystem>();
+        batchSystem = std::make_unique<RideSharingSystem>();
+        for (size_t i = 0; i < driverCount; ++i) {
+            GeoPoint location = {next() * areaMiles, next() * areaMiles};
+            greedySystem->addDriver("Driver", 5.0, location);
+            batchSystem->addDriver("Driver", 5.0, location);
+        }
+        greedyRider = greedySystem->addRider("Rider");
+        batchRider = batchSystem->addRider("Rider");
+        for (size_t i = 0; i < batchSize; ++i) {
+            pickups.push_back({next() * areaMiles, next() * areaMiles});
+        }
+    }
+    
+    double greedyMiles = 0.0;
+    for (const GeoPoint& pickup : pickups) {
+        if (greedySystem->requestRide(greedyRider, "Downtown", pickup, "Airport", 5.0)) {
+            GeoPoint location;
+            greedySystem->findDriver(greedySystem->getRideStore().getDriverIDs().back())->getLocation(location);
+            greedyMiles += distanceBetween(pickup, location);
+        }
+    }
+    
+    DispatchEngine engine(*batchSystem);
+    for (const GeoPoint& pickup : pickups) {
+        engine.submit({batchRider, "Downtown", pickup, "Airport", 5.0});
+    }
+    Sample dispatched = measure(1, [&](size_t) { engine.dispatch(); });
+    DispatchStats stats = engine.lastBatch();
+    
+    report("dispatch/batch", batchSize, dispatched.perItem(batchSize));
+    std::cout << "  (" << std::fixed << std::setprecision(1) << stats.solveMicros << " us/solve"
+              << ", greedy=" << std::setprecision(2) << greedyMiles << "mi"
+              << " batch=" << stats.pickupMiles << "mi"
+              << ", " << std::setprecision(1) << 100.0 * (greedyMiles - stats.pickupMiles) / greedyMiles
+              << "% less, matched " << stats.matched << ")" << std::endl;
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Snapshot save, startup load and first-lookup materialization cost
+ * Load is reported per ride; lookups are the first findDriver of each driver
+ */
+void benchSnapshot(size_t rideCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    const size_t people = std::max<size_t>(1, rideCount / 10);
+    const std::string path = "bench_snapshot.bin";
+    {
+        std::unique_ptr<RideSharingSystem> system;
+        std::vector<RideRequest> requests;
+        {
+            QuietScope quiet;
+            system = std::make_unique<RideSharingSystem>();
+            std::vector<Driver*> drivers;
+            std::vector<Rider*> riders;
+            for (size_t i = 0; i < people; ++i) {
+                drivers.push_back(system->addDriver("Driver " + std::to_string(i), 4.5,
+                                                    {static_cast<double>(i % 300) * 0.1,
+                                                     static_cast<double>(i / 300) * 0.1}));
+                riders.push_back(system->addRider("Rider " + std::to_string(i)));
+            }
+            static const char* types[] = {"standard", "premium", "economy"};
+            for (size_t i = 0; i < rideCount; ++i) {
+                requests.push_back({types[i % 3], "Zone " + std::to_string(i % 500),
+                                    "Zone " + std::to_string((i * 7) % 500), 1.0 + (i % 40) * 0.5,
+                                    drivers[(i * 31) % people], riders[(i * 17) % people]});
+            }
+            system->createRides(requests);
+        }
+        Sample saveNs = measure(1, [&](size_t) { sink = sink + system->saveSnapshot(path); });
+        report("snapshot/save", rideCount, saveNs.perItem(rideCount));
+    }
+
+    RideSharingSystem loaded;
+    Sample loadNs = measure(1, [&](size_t) { sink = sink + loaded.loadSnapshot(path); });
+    report("snapshot/load", rideCount, loadNs.perItem(rideCount));
+    std::cout << "  (startup load " << std::fixed << std::setprecision(2) << loadNs.ns / 1e6 << " ms)" << std::endl;
+    Sample lookupNs = measure(people, [&](size_t i) {
+        sink = sink + loaded.findDriver(static_cast<int>(i) + 1)->getRideCount();
+    });
+    report("snapshot/first-lookup", people, lookupNs);
+    std::remove(path.c_str());
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Journaled createRide throughput for each fsync policy with 1, 4 and 32 callers
+ * Reported as wall-clock ns per event and events per second
+ */
+void benchJournal(size_t eventCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    const std::string path = "bench_journal.log";
+    const std::pair<SyncPolicy, const char*> policies[] = {
+        {SyncPolicy::Always, "always"}, {SyncPolicy::Group, "group"},
+        {SyncPolicy::Periodic, "periodic"}, {SyncPolicy::None, "none"}};
+    for (const auto& policy : policies) {
+        for (size_t threads : {1, 4, 32}) {
+            std::remove(path.c_str());
+            JournalOptions options;
+            options.sync = policy.first;
+            // Durable policies block each caller on fsync, so give them fewer events
+            bool blocking = policy.first == SyncPolicy::Always || policy.first == SyncPolicy::Group;
+            size_t perThread = (blocking ? eventCount / 100 : eventCount) / threads;
+            auto system = std::make_unique<RideSharingSystem>();
+            system->openJournal(path, options);
+            Driver* driver = system->addDriver("Driver");
+            Rider* rider = system->addRider("Rider");
+
+            Sample run = measure(1, [&](size_t) {
+                std::vector<std::thread> callers;
+                for (size_t t = 0; t < threads; ++t) {
+                    callers.emplace_back([&system, driver, rider, perThread]() {
+                        for (size_t i = 0; i < perThread; ++i) {
+                            system->createRide("standard", "Downtown", "Airport", 5.0, driver, rider);
+                        }
+                    });
+                }
+                for (auto& caller : callers) {
+                    caller.join();
+                }
+                system.reset(); // Includes the final flush of buffered policies
+            });
+
+            size_t total = threads * perThread;
+            Sample event = run.perItem(total);
+            report(std::string("journal/") + policy.second + "-" + std::to_string(threads) + "-threads",
+                   total, event);
+            std::cout << "  (" << std::fixed << std::setprecision(0) << 1e9 / event.ns << " events/s)" << std::endl;
+        }
+    }
+    std::remove(path.c_str());
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * End-to-end trip import from CSV and JSONL files (read, parse, createRides)
+ * Reported per trip, plus trips/s and MB/s as the CLI prints them
+ */
+void benchImport(size_t tripCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    const size_t people = std::max<size_t>(1, tripCount / 100);
+    static const char* types[] = {"standard", "premium", "economy"};
+    for (bool json : {false, true}) {
+        const std::string path = json ? "bench_trips.jsonl" : "bench_trips.csv";
+        {
+            std::ofstream out(path, std::ios::binary);
+            if (!json) {
+                out << "type,pickup,dropoff,distance,driver,rider\n";
+            }
+            char line[256];
+            for (size_t i = 0; i < tripCount; ++i) {
+                const char* format = json
+                    ? "{\"type\":\"%s\",\"pickup\":\"Zone %zu\",\"dropoff\":\"Zone %zu\","
+                      "\"distance\":%.1f,\"driver\":\"Driver %zu\",\"rider\":\"Rider %zu\"}\n"
+                    : "%s,Zone %zu,Zone %zu,%.1f,Driver %zu,Rider %zu\n";
+                int length = std::snprintf(line, sizeof(line), format, types[i % 3], i % 500, (i * 7) % 500,
+                                           1.0 + (i % 40) * 0.5, (i * 31) % people, (i * 17) % people);
+                out.write(line, length);
+            }
+        }
+        RideSharingSystem system;
+        TripImporter importer(system);
+        Sample run = measure(1, [&](size_t) { sink = sink + importer.importFile(path); });
+        const ImportStats& stats = importer.getStats();
+        report(json ? "import/jsonl" : "import/csv", tripCount, run.perItem(tripCount));
+        std::cout << "  (" << std::fixed << std::setprecision(0) << stats.tripsPerSecond() << " trips/s, "
+                  << std::setprecision(1) << stats.megabytesPerSecond() << " MB/s)" << std::endl;
+        std::remove(path.c_str());
+    }
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * createRide, lookups, earnings and the stats report against a system of rideCount rides
+ * The system is built by the measured createRide calls; people scale with the ride count
+ */
+void benchSystemOps(size_t rideCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    const size_t people = std::max<size_t>(10, rideCount / 10);
+    std::unique_ptr<RideSharingSystem> system;
+    std::vector<Driver*> drivers;
+    std::vector<Rider*> riders;
+    {
+        QuietScope quiet;
+        system = std::make_unique<RideSharingSystem>();
+        for (size_t i = 0; i < people; ++i) {
+            drivers.push_back(system->addDriver("Driver " + std::to_string(i)));
+            riders.push_back(system->addRider("Rider " + std::to_string(i)));
+        }
+    }
+    
+    static const char* types[] = {"standard", "premium", "economy"};
+    Sample created = measure(rideCount, [&](size_t i) {
+        auto ride = system->createRide(types[i % 3], "Downtown", "Airport", 1.0 + (i % 40) * 0.5,
+                                       drivers[(i * 31) % people], riders[(i * 17) % people]);
+        sink = sink + (ride ? 1 : 0);
+    });
+    report("system/createRide", rideCount, created);
+    
+    uint64_t seed = 88172645463325252ULL;
+    auto nextID = [&]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return static_cast<int>(seed % people) + 1;
+    };
+    const size_t lookups = 1000000;
+    Sample driverLookup = measure(lookups, [&](size_t) {
+        sink = sink + (system->findDriver(nextID()) ? 1 : 0);
+    });
+    report("system/findDriver", rideCount, driverLookup);
+    Sample riderLookup = measure(lookups, [&](size_t) {
+        sink = sink + (system->findRider(nextID()) ? 1 : 0);
+    });
+    report("system/findRider", rideCount, riderLookup);
+    Sample earnings = measure(lookups, [&](size_t) {
+        sink = sink + static_cast<size_t>(drivers[nextID() - 1]->getTotalEarnings());
+    });
+    report("system/getTotalEarnings", rideCount, earnings);
+    
+    // Rolling windows read buckets, not rides, so their cost is flat in rideCount
+    Sample window15m = measure(100000, [&](size_t) {
+        sink = sink + system->recentActivity(15 * RideTimeSeries::MINUTE_MILLIS).requestCount();
+    });
+    report("system/recentActivity-15m", rideCount, window15m);
+    Sample window24h = measure(10000, [&](size_t) {
+        sink = sink + system->recentActivity(24 * RideTimeSeries::HOUR_MILLIS).requestCount();
+    });
+    report("system/recentActivity-24h", rideCount, window24h);
+    
+    Sample displayed;
+    {
+        QuietScope quiet;
+        displayed = measure(rideCount >= 1000000 ? 3 : 100, [&](size_t) { system->displaySystemStats(); });
+    }
+    report("system/displaySystemStats", rideCount, displayed);
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Leaderboard upkeep and queries against re-sorting every driver per query
+ */
+void benchLeaderboard(size_t driverCount) {
+    Leaderboard board;
+    std::vector<double> earnings(driverCount);
+    std::vector<size_t> rides(driverCount);
+    uint64_t seed = 88172645463325252ULL;
+    auto next = [&]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    };
+    for (size_t id = 0; id < driverCount; ++id) {
+        earnings[id] = static_cast<double>(next() % 100000) / 100.0;
+        rides[id] = next() % 500;
+        board.update(static_cast<int>(id), earnings[id], rides[id], 4.0 + (id % 10) / 10.0);
+    }
+    board.top(LeaderboardMetric::Earnings, 1);
+    
+    // A ride lands on a random driver; queries every 1000 rides apply the queued moves
+    Sample updated = measure(1000000, [&](size_t i) {
+        size_t id = next() % driverCount;
+        earnings[id] += 12.5;
+        board.update(static_cast<int>(id), earnings[id], ++rides[id], 4.0 + (id % 10) / 10.0);
+        if (i % 1000 == 999) {
+            sink = sink + board.top(LeaderboardMetric::Earnings, 1).size();
+        }
+    });
+    report("leaderboard/update", driverCount, updated);
+    Sample top = measure(100000, [&](size_t) {
+        sink = sink + board.top(LeaderboardMetric::Earnings, 10).size();
+    });
+    report("leaderboard/top10", driverCount, top);
+    Sample ranked = measure(1000000, [&](size_t) {
+        sink = sink + board.rank(LeaderboardMetric::Earnings, static_cast<int>(next() % driverCount));
+    });
+    report("leaderboard/rank", driverCount, ranked);
+    
+    std::vector<std::pair<double, int>> scratch(driverCount);
+    Sample scanned = measure(driverCount >= 1000000 ? 20 : 1000, [&](size_t) {
+        for (size_t id = 0; id < driverCount; ++id) {
+            scratch[id] = {-earnings[id], static_cast<int>(id)};
+        }
+        std::partial_sort(scratch.begin(), scratch.begin() + std::min<size_t>(10, driverCount), scratch.end());
+        sink = sink + static_cast<size_t>(scratch[0].second);
+    });
+    report("leaderboard/top10-scan", driverCount, scanned);
+}
+
+/**
+ * Surge quotes and supply updates with drivers spread over many zones
+ */
+void benchSurge(size_t driverCount) {
+    SurgeEngine engine;
+    const double span = 200.0; // 100 x 100 zones of 2 miles
+    uint64_t seed = 88172645463325252ULL;
+    auto next = [&]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    };
+    auto randomPoint = [&]() {
+        return GeoPoint{static_cast<double>(next() % 20000) / 20000.0 * span,
+                        static_cast<double>(next() % 20000) / 20000.0 * span};
+    };
+    for (size_t id = 0; id < driverCount; ++id) {
+        engine.setDriverIdle(static_cast<int>(id), randomPoint());
+    }
+    
+    // Requests arrive 1 ms apart, so the window slides while quoting
+    int64_t now = 1700000000000LL;
+    Sample quoted = measure(1000000, [&](size_t) {
+        sink = sink + engine.quote(randomPoint(), ++now);
+    });
+    report("surge/quote", driverCount, quoted);
+    Sample moved = measure(1000000, [&](size_t) {
+        int id = static_cast<int>(next() % driverCount);
+        if (next() % 4 == 0) {
+            engine.setDriverBusy(id);
+        } else {
+            engine.setDriverIdle(id, randomPoint());
+        }
+    });
+    report("surge/supply-update", driverCount, moved);
+    Sample listed = measure(100, [&](size_t) { sink = sink + engine.surgingZones(now).size(); });
+    report("surge/surgingZones", driverCount, listed);
+}
+
+/**
+ * Filter queries through the secondary indexes against a scan of the ride
+ * store columns, plus the one-off index build on the first query
+ */
+void benchQueries(size_t rideCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    const size_t people = std::max<size_t>(10, rideCount / 100);
+    RideSharingSystem system;
+    {
+        QuietScope quiet;
+        std::vector<Driver*> drivers;
+        std::vector<Rider*> riders;
+        for (size_t i = 0; i < people; ++i) {
+            drivers.push_back(system.addDriver("Driver " + std::to_string(i)));
+            riders.push_back(system.addRider("Rider " + std::to_string(i)));
+        }
+        static const char* types[] = {"standard", "premium", "economy"};
+        std::vector<RideRequest> requests;
+        for (size_t i = 0; i < rideCount; ++i) {
+            requests.push_back({types[i % 3], "Zone " + std::to_string(i % 500),
+                                "Zone " + std::to_string((i * 7) % 500), 1.0 + (i % 40) * 0.5,
+                                drivers[(i * 31) % people], riders[(i * 17) % people]});
+        }
+        system.createRides(requests);
+    }
+    
+    RideQuery premiumOver10; // "premium rides from Zone 42 over 10 miles"
+    premiumOver10.type(RideType::Premium);
+    premiumOver10.pickup = "Zone 42";
+    premiumOver10.minDistance = 10.0;
+    RideQuery driverShortRides;
+    driverShortRides.driverID = 7;
+    driverShortRides.maxDistance = 5.0;
+    RideQuery exactDistance;
+    exactDistance.minDistance = 7.0;
+    exactDistance.maxDistance = 7.0;
+    exactDistance.dropoff = "Zone 7";
+    
+    Sample built = measure(1, [&](size_t) { sink = sink + system.queryRides(premiumOver10).rideIDs.size(); });
+    report("query/first-build", rideCount, built.perItem(rideCount));
+    
+    const RideStore& store = system.getRideStore();
+    uint32_t zone42;
+    LocationPool::global().find("Zone 42", zone42);
+    Sample scanned = measure(rideCount >= 1000000 ? 5 : 100, [&](size_t) {
+        size_t matched = 0;
+        for (size_t row = 0; row < store.size(); ++row) {
+            matched += store.getTypes()[row] == RideType::Premium && store.getPickupIDs()[row] == zone42 &&
+                       store.getDistances()[row] >= 10.0;
+        }
+        sink = sink + matched;
+    });
+    report("query/column-scan", rideCount, scanned);
+    Sample located = measure(1000, [&](size_t) { sink = sink + system.queryRides(premiumOver10).rideIDs.size(); });
+    report("query/type+pickup+distance", rideCount, located);
+    Sample driven = measure(1000, [&](size_t) { sink = sink + system.queryRides(driverShortRides).rideIDs.size(); });
+    report("query/driver+distance", rideCount, driven);
+    Sample ranged = measure(1000, [&](size_t) { sink = sink + system.queryRides(exactDistance).rideIDs.size(); });
+    report("query/distance+dropoff", rideCount, ranged);
+    
+    // Upkeep once built: every ride lands in four posting lists, a bitmap and the distance index
+    Driver* driver = system.findDriver(1);
+    Rider* rider = system.findRider(1);
+    Sample maintained = measure(100000, [&](size_t i) {
+        sink = sink + (system.createRide(RideType::Standard, "Zone 1", "Zone 2", 1.0 + (i % 97) * 0.25, driver,
+                                         rider) ? 1 : 0);
+    });
+    report("query/indexed-createRide", rideCount, maintained);
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Driver and rider history reports: the previous per-line std::endl output
+ * against the buffered report writer on a stream, on a file descriptor and
+ * in pages of 1000 rides. Output goes to /dev/null; reported per ride.
+ */
+void benchReports(size_t rideCount) {
+    Logger::instance().setLevel(LogLevel::Warn);
+    RideSharingSystem system;
+    Driver* driver;
+    Rider* rider;
+    std::vector<std::shared_ptr<Ride>> rides;
+    {
+        QuietScope quiet;
+        driver = system.addDriver("Report Driver", 4.5, {1.0, 2.0});
+        rider = system.addRider("Report Rider");
+        static const char* types[] = {"standard", "premium", "economy"};
+        std::vector<RideRequest> requests;
+        for (size_t i = 0; i < rideCount; ++i) {
+            requests.push_back({types[i % 3], "Zone " + std::to_string(i % 500),
+                                "Zone " + std::to_string((i * 7) % 500), 1.0 + (i % 40) * 0.5, driver, rider});
+        }
+        rides = system.createRides(requests);
+    }
+    
+    std::ofstream devNull("/dev/null");
+    Sample perLine = measure(1, [&](size_t) {
+        devNull << "\n=== Driver Information ===" << std::endl;
+        devNull << "Driver ID: " << driver->getDriverID() << std::endl;
+        for (const auto& ride : rides) {
+            devNull << "Ride " << ride->getRideID() << ": " << ride->getPickupLocation() << " → "
+                    << ride->getDropoffLocation() << " ($" << std::fixed << std::setprecision(2)
+                    << ride->computeFare() << ")" << std::endl;
+        }
+    });
+    report("report/driver-endl", rideCount, perLine.perItem(rideCount));
+    Sample streamed = measure(1, [&](size_t) {
+        ReportWriter out(devNull);
+        sink = sink + driver->writeInfo(out).listed;
+    });
+    report("report/driver-stream", rideCount, streamed.perItem(rideCount));
+    
+    int fd = open("/dev/null", O_WRONLY);
+    Sample direct = measure(1, [&](size_t) {
+        ReportWriter out(fd);
+        sink = sink + driver->writeInfo(out).listed;
+    });
+    report("report/driver-fd", rideCount, direct.perItem(rideCount));
+    Sample paged = measure(1, [&](size_t) {
+        ReportWriter out(fd);
+        ReportPage page;
+        page.limit = 1000;
+        for (ReportCursor cursor = driver->writeInfo(out, page); cursor.hasMore();) {
+            cursor = driver->writeRides(out, cursor.next);
+        }
+    });
+    report("report/driver-fd-pages", rideCount, paged.perItem(rideCount));
+    Sample history = measure(1, [&](size_t) {
+        ReportWriter out(fd);
+        sink = sink + rider->writeHistory(out).listed;
+    });
+    report("report/rider-history-fd", rideCount, history.perItem(rideCount));
+    close(fd);
+    Logger::instance().setLevel(LogLevel::Info);
+}
+
+/**
+ * Instrumentation overhead: counter increments and timed scopes, sampled and exact
+ */
+void benchMetrics(size_t ops) {
+    Counter counter;
+    Sample counted = measure(ops, [&](size_t) { counter.add(); });
+    sink = sink + counter.value();
+    report("metrics/counter-add", ops, counted);
+    
+    Histogram sampled;
+    Sample sampledTimer = measure(ops, [&](size_t) { LatencyTimer timer(sampled); });
+    report("metrics/timer-sampled", ops, sampledTimer);
+    
+    Histogram exact(1);
+    Sample exactTimer = measure(ops, [&](size_t) { LatencyTimer timer(exact); });
+    report("metrics/timer-every-call", ops, exactTimer);
+    
+    const size_t threads = 4;
+    Sample contended = measure(1, [&](size_t) {
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&counter, &sampled, ops]() {
+                for (size_t i = 0; i < ops; ++i) {
+                    LatencyTimer timer(sampled);
+                    counter.add();
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    });
+    report("metrics/counter+timer-4-threads", threads * ops, contended.perItem(threads * ops));
+}
+
+/**
+ * Write every measurement as JSON, one benchmark object per line
+ */
+bool writeResults(const std::string& path) {
+    std::ofstream out(path);
+    out << "{\"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        out << "  {\"name\": \"" << result.name << "\", \"n\": " << result.n << std::fixed
+            << std::setprecision(3) << ", \"ns_per_op\": " << result.sample.ns
+            << ", \"allocs_per_op\": " << result.sample.allocs
+            << ", \"bytes_per_op\": " << result.sample.bytes
+            << ", \"peak_rss_bytes\": " << result.peakRss << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]}\n";
+    return static_cast<bool>(out);
+}
+
+/**
+ * Numeric field of one benchmark line written by writeResults
+ */
+double resultField(const std::string& line, const std::string& key) {
+    size_t pos = line.find("\"" + key + "\": ");
+    return pos == std::string::npos ? 0.0 : std::strtod(line.c_str() + pos + key.size() + 4, nullptr);
+}
+
+/**
+ * Print the change of every measurement against an earlier results file
+ * Slower by more than 10% or more allocations per op is flagged
+ */
+bool compareResults(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Cannot read baseline " << path << std::endl;
+        return false;
+    }
+    std::unordered_map<std::string, std::pair<double, double>> baseline; // name@n -> ns, allocs
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t begin = line.find("\"name\": \"");
+        if (begin == std::string::npos) {
+            continue;
+        }
+        begin += 9;
+        std::string name = line.substr(begin, line.find('"', begin) - begin);
+        std::string key = name + "@" + std::to_string(static_cast<size_t>(resultField(line, "n")));
+        baseline[key] = {resultField(line, "ns_per_op"), resultField(line, "allocs_per_op")};
+    }
+    
+    std::cout << "\n======================================" << std::endl;
+    std::cout << "COMPARED WITH " << path << std::endl;
+    std::cout << "======================================" << std::endl;
+    size_t regressions = 0;
+    for (const BenchResult& result : results) {
+        auto it = baseline.find(result.name + "@" + std::to_string(result.n));
+        if (it == baseline.end() || it->second.first <= 0.0) {
+            continue;
+        }
+        double change = 100.0 * (result.sample.ns - it->second.first) / it->second.first;
+        bool regressed = change > 10.0 || result.sample.allocs > it->second.second + 0.005;
+        regressions += regressed ? 1 : 0;
+        std::cout << std::left << std::setw(28) << result.name << " n=" << std::setw(9) << result.n
+                  << std::right << std::fixed << std::setprecision(1) << std::setw(8) << change << "% time"
+                  << std::setprecision(2) << std::setw(8) << result.sample.allocs - it->second.second
+                  << " allocs/op" << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+    std::cout << regressions << " regression(s)" << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string jsonPath;
+    std::string baselinePath;
+    std::string filter;
+    size_t maxRides = 10000000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (arg == "--compare" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--max-rides" && i + 1 < argc) {
+            maxRides = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--json <file>] [--compare <file>]"
+                      << " [--filter <text>] [--max-rides <n>]" << std::endl;
+            return 1;
+        }
+    }
+    
+    std::cout << "======================================" << std::endl;
+    std::cout << "RIDE SHARING SYSTEM - BENCHMARKS" << std::endl;
+    std::cout << "======================================" << std::endl;
+    
+    // Groups run in order; each starts a fresh peak RSS window
+    std::vector<std::pair<std::string, std::function<void()>>> groups;
+    for (size_t n : {1000, 100000, 1000000}) {
+        groups.emplace_back("findDriver", [n]() { benchDriverLookup(n); });
+    }
+    for (size_t n : {1000, 100000, 1000000}) {
+        groups.emplace_back("createRide", [n]() { benchRideCreation(n); });
+    }
+    groups.emplace_back("ride-type", []() { benchRideTypeParse(10000000); });
+    for (size_t n : {1000, 1000000, 10000000}) {
+        if (n <= maxRides) {
+            groups.emplace_back("system", [n]() { benchSystemOps(n); });
+        }
+    }
+    for (size_t n : {1000, 100000, 1000000}) {
+        groups.emplace_back("leaderboard", [n]() { benchLeaderboard(n); });
+    }
+    for (size_t n : {1000, 100000}) {
+        groups.emplace_back("surge", [n]() { benchSurge(n); });
+    }
+    for (size_t n : {1000, 200000}) {
+        groups.emplace_back("report", [n]() { benchReports(n); });
+    }
+    for (size_t n : {10000, 1000000}) {
+        if (n <= maxRides) {
+            groups.emplace_back("query", [n]() { benchQueries(n); });
+        }
+    }
+    groups.emplace_back("metrics", []() { benchMetrics(10000000); });
+    groups.emplace_back("memory", []() { benchRideMemory(1000000); });
+    groups.emplace_back("ride-alloc-pool", []() { benchRideAllocation(1000000, true); });
+    groups.emplace_back("ride-alloc-heap", []() { benchRideAllocation(1000000, false); });
+    for (size_t n : {1000, 1000000, 10000000}) {
+        if (n <= maxRides) {
+            groups.emplace_back("fare", [n]() { benchFareComputation(n); });
+        }
+    }
+    groups.emplace_back("stats", []() { benchStats(1000000); });
+    groups.emplace_back("dispatch", []() { benchConcurrentDispatch(200000); });
+    groups.emplace_back("spatial", []() { benchSpatialMatching(100000); });
+    for (size_t n : {10, 100, 1000, 10000}) {
+        groups.emplace_back("batch-dispatch", [n]() { benchBatchDispatch(n); });
+    }
+    groups.emplace_back("snapshot", []() { benchSnapshot(1000000); });
+    groups.emplace_back("journal", []() { benchJournal(200000); });
+    groups.emplace_back("import", []() { benchImport(1000000); });
+    
+    for (const auto& group : groups) {
+        if (group.first.find(filter) != std::string::npos) {
+            resetPeakRss();
+            group.second();
+        }
+    }
+    
+    if (!jsonPath.empty()) {
+        if (!writeResults(jsonPath)) {
+            std::cerr << "Cannot write " << jsonPath << std::endl;
+            return 1;
+        }
+        std::cout << "\nResults written to " << jsonPath << std::endl;
+    }
+    if (!baselinePath.empty() && !compareResults(baselinePath)) {
+        return 1;
+    }
+    return 0;
+}
@@ -1,8 +1,14 @@
 #include "RideSharingSystem.h"
+#include "TripImporter.h"
+#include "Logger.h"
 #include <iostream>
 #include <string>
 #include <chrono>
 #include <thread>
+#include <fstream>
+#include <algorithm>
+#include <iomanip>
+#include <limits>
 
 /**
  * CLI Application for Ride Sharing System
@@ -10,17 +16,34 @@
  */
 
 void printHeader(const std::string& title) {
+    Logger::instance().flush(); // Queued log records print before the header
     std::cout << "\n" << std::string(50, '=') << std::endl;
     std::cout << title << std::endl;
     std::cout << std::string(50, '=') << std::endl;
 }
 
 void pauseForDemo() {
+    Logger::instance().flush();
     std::cout << "\n[Press Enter to continue...]" << std::endl;
     std::cin.get();
 }
 
+/**
+ * Read "x y" coordinates from the console
+ * @param point Receives the coordinates
+ * @return False if the input was not two finite numbers (the line is skipped)
+ */
+bool readPoint(GeoPoint& point) {
+    if (!(std::cin >> point.x >> point.y)) {
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        return false;
+    }
+    return isFinite(point);
+}
+
 void displayMenu() {
+    Logger::instance().flush();
     std::cout << "\n=== RIDE SHARING SYSTEM CLI ===" << std::endl;
     std::cout << "1. Add Driver" << std::endl;
     std::cout << "2. Add Rider" << std::endl;
@@ -31,6 +54,10 @@ void displayMenu() {
     std::cout << "7. System Statistics" << std::endl;
     std::cout << "8. Run Demo (All Features)" << std::endl;
     std::cout << "9. Exit" << std::endl;
+    std::cout << "10. View Metrics" << std::endl;
+    std::cout << "11. Export Metrics (Prometheus)" << std::endl;
+    std::cout << "12. Complete Ride" << std::endl;
+    std::cout << "13. Driver Leaderboard" << std::endl;
     std::cout << "Enter your choice: ";
 }
 
@@ -39,6 +66,7 @@ void runInteractiveMode(RideSharingSystem& system) {
     std::string name, pickup, dropoff, rideType, payment;
     double distance, rating;
     int driverID, riderID;
+    GeoPoint location;
     
     while (true) {
         displayMenu();
@@ -51,7 +79,12 @@ void runInteractiveMode(RideSharingSystem& system) {
                 std::getline(std::cin, name);
                 std::cout << "Enter initial rating (1-5): ";
                 std::cin >> rating;
-                system.addDriver(name, rating);
+                std::cout << "Enter current location (x y, miles): ";
+                if (!readPoint(location)) {
+                    std::cout << "Invalid coordinates!" << std::endl;
+                } else if (!system.addDriver(name, rating, location)) {
+                    std::cout << "Could not add the driver!" << std::endl;
+                }
                 break;
             }
             case 2: {
@@ -63,7 +96,11 @@ void runInteractiveMode(RideSharingSystem& system) {
                 break;
             }
             case 3: {
-                std::cout << "Enter ride type (standard/premium/economy): ";
+                std::cout << "Enter ride type (";
+                for (const RideTypeInfo& info : RIDE_TYPES) {
+                    std::cout << (&info == RIDE_TYPES ? "" : "/") << info.name;
+                }
+                std::cout << "): ";
                 std::getline(std::cin, rideType);
                 std::cout << "Enter pickup location: ";
                 std::getline(std::cin, pickup);
@@ -71,14 +108,25 @@ void runInteractiveMode(RideSharingSystem& system) {
                 std::getline(std::cin, dropoff);
                 std::cout << "Enter distance (miles): ";
                 std::cin >> distance;
-                std::cout << "Enter driver ID: ";
+                std::cout << "Enter driver ID (0 = nearest available): ";
                 std::cin >> driverID;
                 std::cout << "Enter rider ID: ";
                 std::cin >> riderID;
                 
-                Driver* driver = system.findDriver(driverID);
                 Rider* rider = system.findRider(riderID);
+                if (driverID == 0) {
+                    std::cout << "Enter pickup coordinates (x y, miles): ";
+                    if (!readPoint(location)) {
+                        std::cout << "Invalid coordinates!" << std::endl;
+                    } else if (!rider) {
+                        std::cout << "Invalid rider ID!" << std::endl;
+                    } else if (!system.requestRide(rider, pickup, location, dropoff, distance, rideType)) {
+                        std::cout << "Could not match the ride request!" << std::endl;
+                    }
+                    break;
+                }
                 
+                Driver* driver = system.findDriver(driverID);
                 if (driver && rider) {
                     system.createRide(rideType, pickup, dropoff, distance, driver, rider);
                 } else {
@@ -120,6 +168,27 @@ void runInteractiveMode(RideSharingSystem& system) {
             case 9:
                 std::cout << "Thank you for using Ride Sharing System!" << std::endl;
                 return;
+            case 10:
+                system.displayMetrics();
+                break;
+            case 11: {
+                std::cout << "Enter output file (e.g. metrics.prom): ";
+                std::string path;
+                std::getline(std::cin, path);
+                system.exportMetrics(path);
+                break;
+            }
+            case 12: {
+                std::cout << "Enter Ride ID: ";
+                int rideID;
+                std::cin >> rideID;
+                std::cin.ignore();
+                system.completeRide(rideID);
+                break;
+            }
+            case 13:
+                system.displayLeaderboard();
+                break;
             default:
                 std::cout << "Invalid choice! Please try again." << std::endl;
         }
@@ -130,33 +199,33 @@ void runInteractiveMode(RideSharingSystem& system) {
 
 void runAutomatedDemo(RideSharingSystem& system) {
     printHeader("AUTOMATED DEMO - RIDE SHARING SYSTEM");
-    std::cout << "[LOG] Starting comprehensive demonstration of OOP principles..." << std::endl;
+    LOG_INFO("Starting comprehensive demonstration of OOP principles...");
     
     // Step 1: Creating Drivers (Encapsulation)
     printHeader("STEP 1: CREATING DRIVERS (ENCAPSULATION)");
-    std::cout << "[LOG] Demonstrating encapsulation with Driver class..." << std::endl;
+    LOG_INFO("Demonstrating encapsulation with Driver class...");
     
     Driver* driver1 = system.addDriver("John Smith", 4.8);
     Driver* driver2 = system.addDriver("Maria Garcia", 4.9);
     Driver* driver3 = system.addDriver("David Chen", 4.7);
     
-    std::cout << "[LOG] Drivers created successfully with encapsulated data members" << std::endl;
+    LOG_INFO("Drivers created successfully with encapsulated data members");
     pauseForDemo();
     
     // Step 2: Creating Riders (Encapsulation)
     printHeader("STEP 2: CREATING RIDERS (ENCAPSULATION)");
-    std::cout << "[LOG] Demonstrating encapsulation with Rider class..." << std::endl;
+    LOG_INFO("Demonstrating encapsulation with Rider class...");
     
     Rider* rider1 = system.addRider("Alice Johnson", "Credit Card");
     Rider* rider2 = system.addRider("Bob Wilson", "PayPal");
     Rider* rider3 = system.addRider("Carol Brown", "Apple Pay");
     
-    std::cout << "[LOG] Riders created with private data members accessible only through methods" << std::endl;
+    LOG_INFO("Riders created with private data members accessible only through methods");
     pauseForDemo();
     
     // Step 3: Creating Different Types of Rides (Inheritance & Polymorphism)
     printHeader("STEP 3: CREATING RIDES (INHERITANCE & POLYMORPHISM)");
-    std::cout << "[LOG] Demonstrating inheritance with different ride types..." << std::endl;
+    LOG_INFO("Demonstrating inheritance with different ride types...");
     
     // Create various types of rides to show inheritance
     auto ride1 = system.createRide("standard", "Downtown", "Airport", 15.5, driver1, rider1);
@@ -165,7 +234,7 @@ void runAutomatedDemo(RideSharingSystem& system) {
     auto ride4 = system.createRide("premium", "City Center", "Suburbs", 22.7, driver1, rider2);
     auto ride5 = system.createRide("standard", "Train Station", "Hospital", 6.3, driver2, rider1);
     
-    std::cout << "[LOG] Different ride types created, showing inheritance hierarchy" << std::endl;
+    LOG_INFO("Different ride types created, showing inheritance hierarchy");
     pauseForDemo();
     
     // Step 4: Demonstrating Polymorphism
@@ -174,7 +243,7 @@ void runAutomatedDemo(RideSharingSystem& system) {
     
     // Step 5: Show Individual Driver Information
     printHeader("STEP 5: DRIVER INFORMATION (ENCAPSULATION)");
-    std::cout << "[LOG] Accessing encapsulated driver data through public methods..." << std::endl;
+    LOG_INFO("Accessing encapsulated driver data through public methods...");
     
     driver1->getDriverInfo();
     driver2->getDriverInfo();
@@ -184,7 +253,7 @@ void runAutomatedDemo(RideSharingSystem& system) {
     
     // Step 6: Show Individual Rider Information
     printHeader("STEP 6: RIDER INFORMATION (ENCAPSULATION)");
-    std::cout << "[LOG] Accessing encapsulated rider data through public methods..." << std::endl;
+    LOG_INFO("Accessing encapsulated rider data through public methods...");
     
     rider1->viewRides();
     rider2->viewRides();
@@ -194,11 +263,11 @@ void runAutomatedDemo(RideSharingSystem& system) {
     
     // Step 7: Update Driver Ratings (Encapsulation)
     printHeader("STEP 7: UPDATING DRIVER RATINGS (ENCAPSULATION)");
-    std::cout << "[LOG] Demonstrating controlled access to private data..." << std::endl;
+    LOG_INFO("Demonstrating controlled access to private data...");
     
-    driver1->updateRating(5.0);
-    driver2->updateRating(4.6);
-    driver3->updateRating(4.9);
+    system.updateDriverRating(driver1->getDriverID(), 5.0);
+    system.updateDriverRating(driver2->getDriverID(), 4.6);
+    system.updateDriverRating(driver3->getDriverID(), 4.9);
     
     pauseForDemo();
     
@@ -207,7 +276,8 @@ void runAutomatedDemo(RideSharingSystem& system) {
     
     // Step 9: Final Summary
     printHeader("DEMO COMPLETE - OOP PRINCIPLES DEMONSTRATED");
-    std::cout << "[LOG] Successfully demonstrated:" << std::endl;
+    LOG_INFO("Successfully demonstrated:");
+    Logger::instance().flush();
     std::cout << "✓ ENCAPSULATION: Private data members with controlled access" << std::endl;
     std::cout << "✓ INHERITANCE: Base Ride class with derived classes" << std::endl;
     std::cout << "✓ POLYMORPHISM: Virtual methods called on base class pointers" << std::endl;
@@ -216,11 +286,71 @@ void runAutomatedDemo(RideSharingSystem& system) {
     std::cout << "• Smart pointers for memory management" << std::endl;
     std::cout << "• Comprehensive logging system" << std::endl;
     std::cout << "• Interactive CLI interface" << std::endl;
-    std::cout << "\n[LOG] Ride Sharing System demo completed successfully!" << std::endl;
+    std::cout << std::endl;
+    LOG_INFO("Ride Sharing System demo completed successfully!");
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Optional persistent state: --snapshot <file> loads it (if present) and saves on exit;
+    // --journal <file> replays it and records every change until the next snapshot;
+    // --import <file> loads a CSV/JSONL trip log in batch mode instead of showing the menu;
+    // --arena-strings packs location names into large blocks (for many distinct locations)
+    std::string snapshotPath;
+    std::string journalPath;
+    std::string importPath;
+    JournalOptions journalOptions;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--snapshot" && i + 1 < argc) {
+            snapshotPath = argv[++i];
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journalPath = argv[++i];
+        } else if (arg == "--import" && i + 1 < argc) {
+            importPath = argv[++i];
+        } else if (arg == "--journal-sync" && i + 1 < argc && parseSyncPolicy(argv[i + 1], journalOptions.sync)) {
+            ++i;
+        } else if (arg == "--arena-strings") {
+            LocationPool::configureGlobal(StringStorage::Arena);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--snapshot <file>] [--journal <file>]"
+                      << " [--journal-sync always|group|periodic|none] [--import <trips.csv|trips.jsonl>]"
+                      << " [--arena-strings]" << std::endl;
+            return 1;
+        }
+    }
+    
     RideSharingSystem system;
+    if (!snapshotPath.empty() && std::ifstream(snapshotPath).good() && !system.loadSnapshot(snapshotPath)) {
+        Logger::instance().flush();
+        return 1;
+    }
+    if (!journalPath.empty() && !system.openJournal(journalPath, journalOptions)) {
+        Logger::instance().flush();
+        return 1;
+    }
+    Logger::instance().flush();
+    
+    if (!importPath.empty()) {
+        // Per-ride info records would dominate a bulk import; warnings and errors still print
+        LogLevel level = Logger::instance().getLevel();
+        Logger::instance().setLevel(std::max(level, LogLevel::Warn));
+        TripImporter importer(system);
+        bool imported = importer.importFile(importPath);
+        Logger::instance().setLevel(level);
+        Logger::instance().flush();
+        
+        const ImportStats& stats = importer.getStats();
+        std::cout << "Imported " << stats.imported << " trips (" << stats.rejected << " rejected) from "
+                  << importPath << " in " << std::fixed << std::setprecision(2) << stats.seconds << " s ("
+                  << std::setprecision(0) << stats.tripsPerSecond() << " trips/s, "
+                  << std::setprecision(1) << stats.megabytesPerSecond() << " MB/s)" << std::endl;
+        if (!imported || (!snapshotPath.empty() && !system.saveSnapshot(snapshotPath))) {
+            Logger::instance().flush();
+            return 1;
+        }
+        Logger::instance().flush();
+        return 0;
+    }
     
     std::cout << "Welcome to the C++ Ride Sharing System!" << std::endl;
     std::cout << "Choose mode:" << std::endl;
@@ -242,5 +372,10 @@ int main() {
         }
     }
     
+    if (!snapshotPath.empty() && !system.saveSnapshot(snapshotPath)) {
+        Logger::instance().flush();
+        return 1;
+    }
+    Logger::instance().flush();
     return 0;
 }
@@ -1,7 +1,35 @@
 #include "RideSharingSystem.h"
+#include "Logger.h"
+#include "FareKernel.h"
+#include "DispatchEngine.h"
+#include "TripImporter.h"
+#include "Metrics.h"
+#include <climits>
+#include <cstring>
+#include <cmath>
 #include <iostream>
+#include <cstdio>
 #include <cassert>
+#include <limits>
 #include <memory>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <sstream>
+#include <fstream>
+
+/**
+ * Ride type defined outside the built-in closed set
+ * Exercises the virtual fallback for extension subclasses
+ */
+class BikeRide : public Ride {
+public:
+    BikeRide(int id, std::string_view pickup, std::string_view dropoff, double dist)
+        : Ride(id, pickup, dropoff, dist) {}
+    double fare() const override { return 1.0 + getDistance(); }
+};
 
 /**
  * Basic test suite for the Ride Sharing System
@@ -14,6 +42,7 @@ private:
     int testsFailed = 0;
     
     void runTest(const std::string& testName, bool result) {
+        Logger::instance().flush(); // Keep log lines next to the test that produced them
         std::cout << "Testing " << testName << "... ";
         if (result) {
             std::cout << "PASSED" << std::endl;
@@ -56,7 +85,7 @@ public:
         
         // Add a ride
         auto ride = std::make_shared<StandardRide>(1, "A", "B", 5.0);
-        driver.addRide(ride);
+        driver.addRide(*ride);
         runTest("Ride added to driver", driver.getRideCount() == 1);
         runTest("Driver earnings", driver.getTotalEarnings() == 12.5);
         
@@ -77,7 +106,7 @@ public:
         
         // Request a ride
         auto ride = std::make_shared<PremiumRide>(1, "X", "Y", 8.0);
-        rider.requestRide(ride);
+        rider.requestRide(*ride);
         runTest("Ride requested", rider.getRideCount() == 1);
         runTest("Rider spending", rider.getTotalSpending() == 36.0); // 2.5 * 8 * 1.8
         
@@ -131,6 +160,1816 @@ public:
         runTest("Find rider by ID", foundRider == rider);
     }
     
+    void testRideStore() {
+        std::cout << "\n=== Testing Columnar Ride Store ===" << std::endl;
+        
+        RideSharingSystem system;
+        Driver* driver = system.addDriver("Store Driver");
+        Rider* rider = system.addRider("Store Rider");
+        
+        system.createRide("standard", "Airport", "Downtown", 10.0, driver, rider);
+        system.createRide("premium", "Downtown", "Airport", 10.0, driver, rider);
+        system.createRide("economy", "Airport", "Mall", 10.0, driver, rider);
+        
+        const RideStore& store = system.getRideStore();
+        runTest("Store row count", store.size() == 3);
+        runTest("Store type tags", store.getTypes()[1] == RideType::Premium);
+        runTest("Store fare column", store.getFares()[2] == 17.5);
+        runTest("Store total revenue", store.totalRevenue() == 87.5);
+        runTest("Shared location ID", store.getPickupIDs()[0] == store.getDropoffIDs()[1]);
+        
+        auto view = store.makeRide(1);
+        runTest("Ride view from row", view->getRideID() == 2 && view->fare() == 45.0);
+    }
+    
+    void testIdIndex() {
+        std::cout << "\n=== Testing ID Index ===" << std::endl;
+        
+        Driver first(1, "First");
+        Driver second(2, "Second");
+        Driver sparse(1000000, "Sparse");
+        
+        IdIndex<Driver> index;
+        index.insert(1, &first);
+        index.insert(2, &second);
+        index.insert(1000000, &sparse);
+        
+        runTest("Dense ID lookup", index.find(2) == &second);
+        runTest("Sparse ID lookup", index.find(1000000) == &sparse);
+        runTest("Missing ID lookup", index.find(3) == nullptr && index.find(-1) == nullptr);
+        runTest("Index size", index.size() == 3);
+        
+        runTest("Erase dense ID", index.erase(2) && index.find(2) == nullptr);
+        runTest("Erase sparse ID", index.erase(1000000) && index.find(1000000) == nullptr);
+        runTest("Erase missing ID", !index.erase(2));
+        runTest("Remaining entry intact", index.find(1) == &first && index.size() == 1);
+        index.insert(INT_MAX, &sparse);
+        runTest("Largest ID lookup", index.find(INT_MAX) == &sparse && index.erase(INT_MAX));
+        
+        RideSharingSystem system;
+        for (int i = 0; i < 100; ++i) {
+            system.addDriver("Driver");
+            system.addRider("Rider");
+        }
+        runTest("System driver lookup", system.findDriver(57)->getDriverID() == 57);
+        runTest("System rider lookup", system.findRider(100)->getRiderID() == 100);
+        runTest("System unknown ID", system.findDriver(101) == nullptr && system.findRider(0) == nullptr);
+    }
+    
+    void testBatchCreation() {
+        std::cout << "\n=== Testing Batch Ride Creation ===" << std::endl;
+        
+        RideSharingSystem system;
+        Driver* driverA = system.addDriver("Batch Driver A");
+        Driver* driverB = system.addDriver("Batch Driver B");
+        Rider* rider = system.addRider("Batch Rider");
+        
+        std::vector<RideRequest> requests = {
+            {"standard", "A", "B", 10.0, driverA, rider},
+            {"premium", "B", "C", 10.0, driverB, rider},
+            {"luxury", "C", "D", 10.0, driverA, rider},
+            {"economy", "D", "E", 10.0, driverA, nullptr},
+            {"economy", "E", "F", 10.0, driverA, rider}
+        };
+        auto rides = system.createRides(requests);
+        
+        runTest("Batch result size", rides.size() == requests.size());
+        runTest("Unknown type rejected", rides[2] == nullptr);
+        runTest("Missing rider rejected", rides[3] == nullptr);
+        runTest("Batch ride IDs sequential", rides[0]->getRideID() == 1 && rides[4]->getRideID() == 3);
+        runTest("Batch ride types", rides[1]->getType() == RideType::Premium &&
+                                    rides[4]->getType() == RideType::Economy);
+        runTest("Driver assignments", driverA->getRideCount() == 2 && driverB->getRideCount() == 1);
+        runTest("Rider history", rider->getRideCount() == 3);
+        runTest("Batch store revenue", system.getRideStore().totalRevenue() == 87.5);
+        
+        auto single = system.createRide("standard", "X", "Y", 1.0, driverB, rider);
+        runTest("IDs continue after batch", single->getRideID() == 4);
+    }
+    
+    void testRunningTotals() {
+        std::cout << "\n=== Testing Running Totals ===" << std::endl;
+        
+        RideSharingSystem system;
+        Driver* driver = system.addDriver("Totals Driver");
+        Rider* rider = system.addRider("Totals Rider");
+        
+        system.createRide("standard", "A", "B", 10.0, driver, rider);
+        auto premium = system.createRide("premium", "B", "C", 10.0, driver, rider);
+        auto economy = system.createRide("economy", "C", "D", 10.0, driver, rider);
+        
+        const RideTotals& totals = driver->getTotals();
+        runTest("Driver running total", driver->getTotalEarnings() == 87.5);
+        runTest("Rider running total", rider->getTotalSpending() == 87.5);
+        runTest("Per-type counts", totals.count(RideType::Premium) == 1 && totals.count() == 3);
+        runTest("Per-type fares", totals.total(RideType::Economy) == 17.5);
+        
+        system.repriceRide(premium->getRideID(), 20.0);
+        runTest("Re-priced ride fare", premium->fare() == 90.0);
+        runTest("Driver total after re-price", driver->getTotalEarnings() == 132.5);
+        runTest("Rider total after re-price", rider->getTotalSpending() == 132.5);
+        runTest("Store after re-price", system.getRideStore().totalRevenue() == 132.5);
+        
+        // Many odd re-pricings must not leave rounding drift behind
+        for (int i = 1; i <= 1000; ++i) {
+            system.repriceRide(premium->getRideID(), 0.1 * i + 0.037);
+        }
+        system.repriceRide(premium->getRideID(), 10.0);
+        runTest("Totals exact after repeated re-pricing", driver->getTotalEarnings() == 87.5);
+        
+        runTest("Cancel ride", system.cancelRide(economy->getRideID()));
+        runTest("Driver total after cancel", driver->getTotalEarnings() == 70.0 &&
+                                             driver->getRideCount() == 2);
+        runTest("Rider total after cancel", rider->getTotalSpending() == 70.0 &&
+                                            rider->getTotals().count(RideType::Economy) == 0);
+        runTest("Store after cancel", system.getRideStore().size() == 2);
+        runTest("Cancel unknown ride", !system.cancelRide(economy->getRideID()));
+    }
+    
+    void testTypeDispatch() {
+        std::cout << "\n=== Testing Ride Type Dispatch ===" << std::endl;
+        
+        StandardRide standard(1, "A", "B", 12.3);
+        PremiumRide premium(2, "A", "B", 12.3);
+        EconomyRide economy(3, "A", "B", 12.3);
+        BikeRide bike(4, "A", "B", 3.0);
+        
+        runTest("Built-in type tags", standard.getType() == RideType::Standard &&
+                                      premium.getType() == RideType::Premium &&
+                                      economy.getType() == RideType::Economy);
+        runTest("Extension type tag", bike.getType() == RideType::Custom);
+        runTest("Inline fare matches virtual", standard.computeFare() == standard.fare() &&
+                                               premium.computeFare() == premium.fare() &&
+                                               economy.computeFare() == economy.fare());
+        runTest("Extension fare via virtual", bike.computeFare() == 4.0);
+        runTest("Static fare policy", rideFare(RideType::Premium, 10.0) == 45.0);
+        
+        Driver driver(1, "Dispatch Driver");
+        driver.addRide(BikeRide(5, "A", "B", 2.0));
+        driver.addRide(EconomyRide(6, "A", "B", 10.0));
+        runTest("Extension ride totals", driver.getTotalEarnings() == 20.5 &&
+                                         driver.getTotals().count(RideType::Custom) == 1);
+    }
+    
+    void testFareKernel() {
+        std::cout << "\n=== Testing Batch Fare Kernel (" << FareKernel::implementation()
+                  << ") ===" << std::endl;
+        
+        // Odd length exercises the scalar tail after the vector loop
+        const size_t count = 1003;
+        std::vector<double> distances(count);
+        std::vector<RideType> types(count);
+        uint64_t seed = 12345;
+        for (size_t i = 0; i < count; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            distances[i] = static_cast<double>(seed >> 11) / 9007199254740992.0 * 250.0;
+            types[i] = static_cast<RideType>((seed >> 7) % RIDE_TYPE_COUNT);
+        }
+        distances[0] = 0.0;
+        distances[1] = 1e-310;  // Subnormal
+        distances[2] = 1e300;   // Overflows to infinity for premium
+        types[2] = RideType::Premium;
+        distances[3] = -4.0;    // Below the minimum fare
+        types[3] = RideType::Standard;
+        
+        std::vector<double> fares(count);
+        FareKernel::computeFares(distances.data(), types.data(), fares.data(), count);
+        
+        bool bitExact = true;
+        double scalarSum = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            double expected = rideFare(types[i], distances[i]);
+            scalarSum += expected;
+            bitExact = bitExact && std::memcmp(&expected, &fares[i], sizeof(double)) == 0;
+        }
+        runTest("Kernel matches scalar bit for bit", bitExact);
+        
+        double kernelSum = FareKernel::sumFares(distances.data(), types.data(), count);
+        runTest("Kernel sum matches scalar sum", std::memcmp(&kernelSum, &scalarSum, sizeof(double)) == 0);
+        
+        PremiumRide premium(1, "A", "B", 8.2);
+        double single = 0.0;
+        RideType premiumType = RideType::Premium;
+        double premiumDistance = premium.getDistance();
+        FareKernel::computeFares(&premiumDistance, &premiumType, &single, 1);
+        runTest("Kernel matches virtual fare", single == premium.fare());
+        
+        RideTable table;
+        Driver driver(1, "Kernel Driver", 5.0, &table);
+        for (auto ride : std::vector<std::shared_ptr<Ride>>{std::make_shared<PremiumRide>(2, "A", "B", 8.2),
+                                                            std::make_shared<EconomyRide>(3, "A", "B", 12.0),
+                                                            std::make_shared<BikeRide>(4, "A", "B", 2.0)}) {
+            table.insert(ride);
+            driver.addRide(*ride);
+        }
+        double before = driver.getTotalEarnings();
+        driver.recomputeTotals();
+        runTest("Recomputed totals unchanged", driver.getTotalEarnings() == before &&
+                                              driver.getTotals().count() == 3);
+    }
+    
+    void testRideTypeRegistry() {
+        std::cout << "\n=== Testing Ride Type Registry ===" << std::endl;
+        
+        // Resolved at compile time through the perfect hash
+        static_assert(findRideType("premium")->type == RideType::Premium, "premium resolves at compile time");
+        static_assert(rideFare(RideType::Economy, 10.0) == EconomyRide::fareFor(10.0), "constexpr fare policy");
+        
+        bool namesResolve = true;
+        bool factoriesMatch = true;
+        for (const RideTypeInfo& info : RIDE_TYPES) {
+            const RideTypeInfo* found = findRideType(info.name);
+            namesResolve = namesResolve && found == &info && rideTypeInfo(info.type) == &info &&
+                           rideTypeLabel(info.type) == info.label;
+            auto ride = makeRide(info.type, 1, "A", "B", 7.5);
+            factoriesMatch = factoriesMatch && ride && ride->getType() == info.type &&
+                             ride->fare() == info.policy.fareFor(7.5) && ride->computeFare() == ride->fare();
+        }
+        runTest("Every registered name resolves", namesResolve);
+        runTest("Registry factories build their type", factoriesMatch);
+        runTest("Near-miss names rejected", !findRideType("") && !findRideType("Standard") &&
+                                            !findRideType("standar") && !findRideType("standardx") &&
+                                            !findRideType("scooter"));
+        runTest("Custom has no registry row", !rideTypeInfo(RideType::Custom) &&
+                                              rideTypeLabel(RideType::Custom) == "Custom" &&
+                                              !makeRide(RideType::Custom, 1, "A", "B", 1.0));
+        
+        constexpr FarePolicy floored = {2.0, 1.5, 5.0};
+        runTest("Minimum fare floors short trips", floored.fareFor(1.0) == 5.0 && floored.fareFor(10.0) == 30.0);
+        
+        RideType parsed = RideType::Custom;
+        std::string_view field = "economy,12.5"; // Parsed straight from a view into a larger buffer
+        runTest("Parse from a string view", RideSharingSystem::parseRideType(field.substr(0, 7), parsed) &&
+                                           parsed == RideType::Economy &&
+                                           !RideSharingSystem::parseRideType(field, parsed));
+        
+        RideSharingSystem system;
+        Driver* driver = system.addDriver("Registry Driver");
+        Rider* rider = system.addRider("Registry Rider");
+        auto typed = system.createRide(RideType::Premium, "A", "B", 10.0, driver, rider);
+        auto custom = system.createRide(RideType::Custom, "A", "B", 10.0, driver, rider);
+        RideRequest requests[] = {{"", "A", "B", 2.0, driver, rider}, {"", "B", "A", 3.0, driver, rider}};
+        RideType types[] = {RideType::Economy, RideType::Custom};
+        auto batch = system.createRides(requests, types, 2);
+        runTest("Typed overloads skip parsing", typed && typed->getType() == RideType::Premium && !custom &&
+                                                batch[0] && batch[0]->getType() == RideType::Economy && !batch[1] &&
+                                                system.getMetrics().value("ride_requests_rejected") == 2);
+    }
+    
+    void testStatsEngine() {
+        std::cout << "\n=== Testing Parallel Statistics Engine ===" << std::endl;
+        
+        // Enough rows for several chunks
+        Logger::instance().setLevel(LogLevel::Warn);
+        RideStore store;
+        const size_t rows = 3 * StatsEngine::CHUNK_ROWS + 123;
+        double serialRevenue = 0.0;
+        double driverTwoRevenue = 0.0;
+        for (size_t i = 0; i < rows; ++i) {
+            auto ride = makeRide(static_cast<RideType>(i % 3), static_cast<int>(i + 1),
+                                 "A", "B", 1.0 + (i % 100));
+            int driverID = static_cast<int>(i % 5) + 1;
+            store.append(*ride, driverID, 1);
+            serialRevenue += ride->fare();
+            if (driverID == 2) {
+                driverTwoRevenue += ride->fare();
+            }
+        }
+        Logger::instance().setLevel(LogLevel::Info);
+        
+        StatsEngine single(1);
+        StatsEngine parallel(4);
+        RideStats a = single.compute(store, 5);
+        RideStats b = parallel.compute(store, 5);
+        
+        runTest("Stats ride count", a.rideCount == rows);
+        runTest("Stats type counts", a.count(RideType::Standard) + a.count(RideType::Premium) +
+                                     a.count(RideType::Economy) == rows);
+        runTest("Stats revenue close to serial", std::abs(a.totalRevenue - serialRevenue) < 1e-6 * serialRevenue);
+        runTest("Deterministic across thread counts", a.totalRevenue == b.totalRevenue &&
+                                                      a.driverRevenue == b.driverRevenue &&
+                                                      a.distanceP90 == b.distanceP90);
+        runTest("Per-driver revenue", std::abs(a.driverRevenue[2] - driverTwoRevenue) < 0.01);
+        runTest("Distance percentiles", a.distanceP50 == 50.0 && a.distanceP99 == 99.0);
+        RideStats again = parallel.compute(store, 5);
+        runTest("Reused engine repeats its result", again.totalRevenue == b.totalRevenue &&
+                                                    again.distanceP50 == b.distanceP50 &&
+                                                    again.driverRevenue == b.driverRevenue);
+        
+        RideSharingSystem system;
+        Driver* driver = system.addDriver("Stats Driver");
+        Rider* rider = system.addRider("Stats Rider");
+        system.createRide("standard", "A", "B", 10.0, driver, rider);
+        system.createRide("premium", "A", "B", 20.0, driver, rider);
+        RideStats small = system.computeStats();
+        runTest("System stats revenue", small.totalRevenue == 115.0);
+        runTest("System stats per driver", small.driverRevenue[1] == 115.0);
+        
+        // Stats run on a copy of the columns, so each pass sees one consistent log while rides keep arriving
+        Logger::instance().setLevel(LogLevel::Warn);
+        std::atomic<bool> creating{true};
+        std::thread creator([&]() {
+            for (int i = 0; i < 20000; ++i) {
+                system.createRide(i % 2 ? "economy" : "standard", "A", "B", 1.0 + i % 9, driver, rider);
+            }
+            creating.store(false);
+        });
+        bool consistent = true;
+        size_t passes = 0;
+        do {
+            RideStats pass = system.computeStats();
+            consistent = consistent && pass.count(RideType::Standard) + pass.count(RideType::Premium) +
+                                               pass.count(RideType::Economy) == pass.rideCount &&
+                         std::abs(pass.driverRevenue[1] - pass.totalRevenue) < 1e-6;
+            passes++;
+        } while (creating.load());
+        creator.join();
+        Logger::instance().setLevel(LogLevel::Info);
+        runTest("Stats consistent during dispatch", consistent && passes > 0 &&
+                                                    system.computeStats().rideCount == 20002);
+    }
+    
+    void testConcurrentDispatch() {
+        std::cout << "\n=== Testing Concurrent Dispatch ===" << std::endl;
+        
+        Logger::instance().setLevel(LogLevel::Warn);
+        RideSharingSystem system;
+        const int driverCount = 8;
+        for (int i = 0; i < driverCount; ++i) {
+            system.addDriver("Shared Driver");
+            system.addRider("Shared Rider");
+        }
+        
+        // Dispatchers share drivers and riders and look them up while others write
+        const int threadCount = 4;
+        const int ridesPerThread = 2000;
+        std::vector<std::thread> dispatchers;
+        for (int t = 0; t < threadCount; ++t) {
+            dispatchers.emplace_back([&system, t]() {
+                for (int i = 0; i < ridesPerThread; ++i) {
+                    int id = (t + i) % driverCount + 1;
+                    const char* type = (i % 3 == 0) ? "standard" : (i % 3 == 1) ? "premium" : "economy";
+                    system.createRide(type, "Hub", "Stop", 1.0 + i % 10,
+                                      system.findDriver(id), system.findRider(id));
+                    if (i % 100 == 0) {
+                        system.addDriver("Late Driver");
+                    }
+                }
+            });
+        }
+        for (auto& dispatcher : dispatchers) {
+            dispatcher.join();
+        }
+        Logger::instance().setLevel(LogLevel::Info);
+        
+        const RideStore& store = system.getRideStore();
+        const size_t expected = static_cast<size_t>(threadCount * ridesPerThread);
+        bool sequential = store.size() == expected;
+        for (size_t row = 0; sequential && row < store.size(); ++row) {
+            sequential = store.getRideIDs()[row] == static_cast<int>(row) + 1;
+        }
+        runTest("Every ride logged once in ID order", sequential);
+        
+        double earnings = 0.0;
+        size_t assigned = 0;
+        for (int id = 1; id <= driverCount; ++id) {
+            earnings += system.findDriver(id)->getTotalEarnings();
+            assigned += system.findDriver(id)->getRideCount();
+        }
+        runTest("Driver rides match log", assigned == expected);
+        runTest("Driver earnings match log", std::abs(earnings - store.totalRevenue()) < 1e-6);
+        runTest("Drivers added concurrently", system.findDriver(driverCount + threadCount * 20) != nullptr);
+    }
+    
+    void testConcurrentRideChanges() {
+        std::cout << "\n=== Testing Concurrent Assign, Re-price and Cancel ===" << std::endl;
+        
+        // Re-prices and cancels race the rides they target; misses are logged errors
+        Logger::instance().setLevel(LogLevel::Off);
+        RideSharingSystem system;
+        const int partyCount = 6;
+        for (int i = 0; i < partyCount; ++i) {
+            system.addDriver("Busy Driver");
+            system.addRider("Busy Rider");
+        }
+        
+        const int ridesPerCreator = 3000;
+        const int creatorCount = 2;
+        const int totalRides = ridesPerCreator * creatorCount;
+        const int changerCount = 3;
+        std::atomic<bool> creating{true};
+        std::atomic<int> ready{0};
+        std::atomic<int> newest{1};
+        std::vector<std::thread> changers;
+        // Target the newest rides and the IDs just past them, so changes land while those rides are being logged
+        for (int t = 0; t < changerCount; ++t) {
+            changers.emplace_back([&system, &creating, &ready, &newest, t]() {
+                ready.fetch_add(1);
+                for (int i = 0; creating.load(); ++i) {
+                    int rideID = std::max(1, newest.load() + (i + t) % 4 - 2);
+                    if (t == 0 && i % 3 == 0) {
+                        system.cancelRide(rideID);
+                    } else {
+                        system.repriceRide(rideID, 0.5 + i % 11);
+                    }
+                }
+            });
+        }
+        std::vector<std::thread> creators;
+        for (int t = 0; t < creatorCount; ++t) {
+            creators.emplace_back([&system, &ready, &newest, t]() {
+                while (ready.load() < changerCount) {
+                    std::this_thread::yield();
+                }
+                for (int i = 0; i < ridesPerCreator; i += 10) {
+                    // Batches take the kernel fare path, single rides the per-ride one
+                    std::vector<RideRequest> batch;
+                    for (int k = 0; k < 5; ++k) {
+                        int id = (t + i + k) % partyCount + 1;
+                        batch.push_back({"premium", "Hub", "Stop", 1.3 + (i + k) % 7,
+                                         system.findDriver(id), system.findRider(id)});
+                    }
+                    newest.store(system.createRides(batch).back()->getRideID());
+                    for (int k = 5; k < 10; ++k) {
+                        int id = (t + i + k) % partyCount + 1;
+                        newest.store(system.createRide("economy", "Hub", "Stop", 2.7 + (i + k) % 5,
+                                                       system.findDriver(id), system.findRider(id))->getRideID());
+                    }
+                }
+            });
+        }
+        for (auto& creator : creators) {
+            creator.join();
+        }
+        creating.store(false);
+        for (auto& changer : changers) {
+            changer.join();
+        }
+        // Creation can outrun the changers, so make sure both kinds of change are counted
+        for (int k = 0; k < 2; ++k) {
+            newest.store(system.createRide("standard", "Hub", "Stop", 4.0, system.findDriver(1),
+                                           system.findRider(1))->getRideID());
+        }
+        system.repriceRide(newest.load() - 1, 12.5);
+        system.cancelRide(newest.load());
+        Logger::instance().setLevel(LogLevel::Info);
+        
+        RideStats stats = system.computeStats();
+        double earnings = 0.0;
+        double spending = 0.0;
+        size_t driverRides = 0;
+        size_t riderRides = 0;
+        bool perDriver = true;
+        for (int id = 1; id <= partyCount; ++id) {
+            const Driver* driver = system.findDriver(id);
+            earnings += driver->getTotalEarnings();
+            spending += system.findRider(id)->getTotalSpending();
+            driverRides += driver->getRideCount();
+            riderRides += system.findRider(id)->getRideCount();
+            double logged = static_cast<size_t>(id) < stats.driverRevenue.size() ? stats.driverRevenue[id] : 0.0;
+            perDriver = perDriver && std::abs(driver->getTotalEarnings() - logged) < 1e-6;
+        }
+        const RideStore& store = system.getRideStore();
+        runTest("Rides re-priced and cancelled", store.size() < static_cast<size_t>(totalRides + 2) &&
+                                                 system.getMetrics().value("rides_repriced") > 0);
+        runTest("Driver and rider ride counts match log", driverRides == store.size() && riderRides == store.size());
+        runTest("Driver earnings match stats", std::abs(earnings - stats.totalRevenue) < 1e-6 &&
+                                               std::abs(earnings - store.totalRevenue()) < 1e-6);
+        runTest("Rider spending matches stats", std::abs(spending - stats.totalRevenue) < 1e-6);
+        runTest("Per-driver earnings match stats", perDriver);
+    }
+    
+    void testSpatialMatching() {
+        std::cout << "\n=== Testing Spatial Driver Matching ===" << std::endl;
+        
+        // Grid queries agree with a brute-force scan
+        SpatialIndex grid(1.0);
+        std::vector<GeoPoint> points;
+        unsigned seed = 12345;
+        auto next = [&seed]() {
+            seed = seed * 1103515245u + 12345u;
+            return static_cast<double>((seed >> 8) % 20000) / 1000.0; // 0..20 miles
+        };
+        for (int id = 0; id < 2000; ++id) {
+            points.push_back({next(), next()});
+            grid.update(id, points.back());
+        }
+        for (int id = 0; id < 2000; id += 3) {
+            points[id] = {next(), next()};
+            grid.update(id, points[id]);
+        }
+        for (int id = 1; id < 2000; id += 7) {
+            grid.remove(id);
+        }
+        
+        bool matchesBruteForce = true;
+        for (int q = 0; q < 50; ++q) {
+            GeoPoint query = {next() * 1.2 - 2.0, next() * 1.2 - 2.0};
+            std::vector<double> expected;
+            for (int id = 0; id < 2000; ++id) {
+                if (id % 7 != 1) {
+                    expected.push_back(distanceBetween(query, points[id]));
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+            auto found = grid.nearest(query, 5);
+            matchesBruteForce = matchesBruteForce && found.size() == 5;
+            for (size_t i = 0; matchesBruteForce && i < found.size(); ++i) {
+                matchesBruteForce = std::abs(found[i].distance - expected[i]) < 1e-12;
+            }
+        }
+        runTest("Grid k-nearest matches brute force", matchesBruteForce);
+        runTest("Grid size after removals", grid.size() == 2000 - 286 && !grid.contains(8));
+        
+        RideSharingSystem system;
+        Driver* near = system.addDriver("Near Driver", 4.5, {1.0, 1.0});
+        Driver* far = system.addDriver("Far Driver", 4.5, {8.0, 8.0});
+        Driver* idle = system.addDriver("No Location Driver");
+        Rider* rider = system.addRider("Matched Rider");
+        
+        auto first = system.requestRide(rider, "Corner", {0.0, 0.0}, "Office", 3.0);
+        runTest("Nearest driver assigned", first && near->getRideCount() == 1);
+        runTest("Matched driver busy", !near->isAvailable());
+        runTest("Ride keeps pickup point", first->hasPickupPoint() && first->getPickupPoint().x == 0.0);
+        
+        auto second = system.requestRide(rider, "Corner", {0.0, 0.0}, "Office", 3.0, "premium");
+        runTest("Next nearest driver assigned", second && far->getRideCount() == 1 &&
+                                                second->getType() == RideType::Premium);
+        runTest("No driver left", system.requestRide(rider, "Corner", {0.0, 0.0}, "Office", 3.0) == nullptr);
+        runTest("Driver without location unmatched", idle->getRideCount() == 0);
+        
+        system.setDriverAvailable(near->getDriverID(), true);
+        system.updateDriverLocation(far->getDriverID(), {0.5, 0.5});
+        system.setDriverAvailable(far->getDriverID(), true);
+        auto nearest = system.findNearestDrivers({0.0, 0.0}, 2);
+        runTest("Moved driver found first", nearest.size() == 2 && nearest[0] == far && nearest[1] == near);
+        
+        // Non-finite coordinates are rejected before they reach the grid
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        const double inf = std::numeric_limits<double>::infinity();
+        runTest("NaN driver location rejected", system.addDriver("Lost Driver", 4.0, {nan, 1.0}) == nullptr);
+        runTest("NaN driver move rejected", !system.updateDriverLocation(near->getDriverID(), {1.0, nan}) &&
+                                            system.findNearestDrivers({0.0, 0.0}, 1)[0] == far);
+        auto unreachable = system.requestRide(rider, "Nowhere", {inf, 0.0}, "Office", 3.0);
+        runTest("Infinite pickup request rejected", !unreachable && near->isAvailable() && far->isAvailable());
+        runTest("NaN pickup ride rejected", system.createRide(RideType::Standard, "Nowhere", {nan, nan}, "Office", 3.0,
+                                                              near, rider) == nullptr);
+        runTest("Grid clamps NaN to a cell", [&]() {
+            SpatialIndex nanGrid(1.0);
+            nanGrid.update(1, {nan, nan});
+            return nanGrid.contains(1);
+        }());
+    }
+    
+    void testInvalidDistances() {
+        std::cout << "\n=== Testing Distance Validation ===" << std::endl;
+        
+        Logger::instance().setLevel(LogLevel::Off);
+        RideSharingSystem system;
+        Driver* driver = system.addDriver("Checked Driver", 4.0, {0.0, 0.0});
+        Rider* rider = system.addRider("Checked Rider");
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        const double inf = std::numeric_limits<double>::infinity();
+        
+        bool singlesRejected = true;
+        for (double distance : {nan, inf, -inf, -1.0, MAX_RIDE_DISTANCE * 2}) {
+            singlesRejected = singlesRejected &&
+                              !system.createRide("standard", "A", "B", distance, driver, rider) &&
+                              !system.createRide(RideType::Premium, "A", {0.0, 0.0}, "B", distance, driver, rider) &&
+                              !system.requestRide(rider, "A", {0.0, 0.0}, "B", distance);
+        }
+        runTest("Invalid distances rejected", singlesRejected && driver->isAvailable() &&
+                                              driver->getRideCount() == 0 &&
+                                              system.getMetrics().value("ride_requests_rejected") == 15);
+        
+        auto batch = system.createRides({{"standard", "A", "B", 2.0, driver, rider},
+                                         {"standard", "A", "B", nan, driver, rider},
+                                         {"economy", "A", "B", -3.0, driver, rider},
+                                         {"premium", "A", "B", 0.0, driver, rider}});
+        runTest("Invalid batch requests rejected one by one",
+                batch.size() == 4 && batch[0] && !batch[1] && !batch[2] && batch[3] &&
+                driver->getRideCount() == 2 && system.getMetrics().value("ride_requests_rejected") == 17);
+        
+        double earnings = driver->getTotalEarnings();
+        runTest("Invalid re-price rejected", !system.repriceRide(batch[0]->getRideID(), nan) &&
+                                             !system.repriceRide(batch[0]->getRideID(), -2.0) &&
+                                             batch[0]->getDistance() == 2.0 &&
+                                             driver->getTotalEarnings() == earnings &&
+                                             system.repriceRide(batch[0]->getRideID(), 4.0));
+        Logger::instance().setLevel(LogLevel::Info);
+    }
+    
+    void testDispatchEngine() {
+        std::cout << "\n=== Testing Batched Dispatch ===" << std::endl;
+        
+        // Solver agrees with exhaustive search on small sparse instances
+        unsigned seed = 7;
+        auto next = [&seed](unsigned bound) {
+            seed = seed * 1103515245u + 12345u;
+            return (seed >> 8) % bound;
+        };
+        bool optimal = true;
+        for (int trial = 0; trial < 200 && optimal; ++trial) {
+            size_t rows = 1 + next(5);
+            size_t columns = 1 + next(5);
+            std::vector<std::vector<double>> cost(rows, std::vector<double>(columns, -1.0));
+            std::vector<CandidateEdge> edges;
+            for (size_t r = 0; r < rows; ++r) {
+                for (size_t c = 0; c < columns; ++c) {
+                    if (next(3) != 0) {
+                        cost[r][c] = next(1000) / 100.0;
+                        edges.push_back({static_cast<uint32_t>(r), static_cast<uint32_t>(c), cost[r][c]});
+                    }
+                }
+            }
+            const double unassigned = 100.0;
+            
+            // Exhaustive: every row tries each free column or stays unmatched
+            std::vector<bool> used(columns, false);
+            std::function<double(size_t)> best = [&](size_t r) -> double {
+                if (r == rows) {
+                    return 0.0;
+                }
+                double result = unassigned + best(r + 1);
+                for (size_t c = 0; c < columns; ++c) {
+                    if (cost[r][c] >= 0.0 && !used[c]) {
+                        used[c] = true;
+                        result = std::min(result, cost[r][c] + best(r + 1));
+                        used[c] = false;
+                    }
+                }
+                return result;
+            };
+            
+            std::vector<int> assignment = solveAssignment(rows, columns, edges, unassigned);
+            double total = 0.0;
+            std::vector<bool> taken(columns, false);
+            for (size_t r = 0; r < rows; ++r) {
+                if (assignment[r] < 0) {
+                    total += unassigned;
+                    continue;
+                }
+                size_t c = static_cast<size_t>(assignment[r]);
+                optimal = optimal && cost[r][c] >= 0.0 && !taken[c];
+                taken[c] = true;
+                total += cost[r][c];
+            }
+            optimal = optimal && std::abs(total - best(0)) < 1e-9;
+        }
+        runTest("Assignment solver optimal", optimal);
+        
+        // Greedy would give the first request the nearer driver and send the
+        // second one three miles; the batch assignment does better
+        RideSharingSystem system;
+        Driver* west = system.addDriver("West Driver", 4.8, {0.0, 0.0});
+        Driver* east = system.addDriver("East Driver", 4.8, {2.0, 0.0});
+        Rider* rider = system.addRider("Batch Rider");
+        
+        DispatchEngine engine(system, std::chrono::milliseconds(60000));
+        engine.submit({rider, "Market", {0.9, 0.0}, "Park", 4.0});
+        engine.submit({rider, "Harbor", {-1.0, 0.0}, "Park", 6.0, "economy"});
+        engine.submit({rider, "Harbor", {-1.0, 0.0}, "Park", 6.0});
+        runTest("Invalid request rejected", !engine.submit({rider, "A", {0.0, 0.0}, "B", 1.0, "luxury"}));
+        runTest("Window not elapsed", engine.poll().empty() && engine.pendingCount() == 3);
+        
+        auto rides = engine.dispatch();
+        DispatchStats stats = engine.lastBatch();
+        runTest("Batch matched both drivers", rides.size() == 2 && stats.matched == 2);
+        runTest("Batch minimizes pickup miles", std::abs(stats.pickupMiles - 2.1) < 1e-9);
+        runTest("Crossed assignment", east->getRideCount() == 1 && west->getRideCount() == 1 &&
+                                      rides[0]->hasPickupPoint());
+        runTest("Unmatched request stays queued", engine.pendingCount() == 1 && !east->isAvailable());
+    }
+    
+    void testSnapshot() {
+        std::cout << "\n=== Testing Snapshot Save/Load ===" << std::endl;
+        const std::string path = "test_snapshot.bin";
+        
+        double savedEarnings;
+        double savedSpending;
+        RideStats savedStats;
+        {
+            RideSharingSystem system;
+            Driver* located = system.addDriver("Located Driver", 4.5, {2.0, 3.0});
+            Driver* plain = system.addDriver("Plain Driver", 4.0);
+            Rider* alice = system.addRider("Alice", "PayPal");
+            Rider* bob = system.addRider("Bob");
+            system.createRide("standard", "Downtown", "Airport", 10.0, plain, alice);
+            system.createRide("premium", "Mall", "Harbor", 4.0, plain, bob);
+            system.createRide("economy", "Airport", "Downtown", 6.0, plain, alice);
+            auto picked = system.requestRide(bob, "Corner", {1.0, 1.0}, "Office", 3.0);
+            system.setDriverAvailable(located->getDriverID(), true);
+            system.cancelRide(2);
+            savedEarnings = plain->getTotalEarnings();
+            savedSpending = alice->getTotalSpending();
+            savedStats = system.computeStats();
+            runTest("Snapshot saved", picked && system.saveSnapshot(path));
+        }
+        
+        RideSharingSystem loaded;
+        runTest("Snapshot loaded", loaded.loadSnapshot(path));
+        runTest("Second load rejected", !loaded.loadSnapshot(path));
+        RideStats stats = loaded.computeStats();
+        runTest("Stats available before materialization",
+                stats.rideCount == savedStats.rideCount &&
+                std::abs(stats.totalRevenue - savedStats.totalRevenue) < 1e-9);
+        
+        Driver* plain = loaded.findDriver(2);
+        Rider* alice = loaded.findRider(1);
+        runTest("Driver materialized on lookup", plain && plain->getName() == "Plain Driver" &&
+                                                 plain->getRating() == 4.0 && plain->getRideCount() == 2);
+        runTest("Driver totals restored", std::abs(plain->getTotalEarnings() - savedEarnings) < 1e-9);
+        runTest("Rider materialized on lookup", alice && alice->getPaymentMethod() == "PayPal" &&
+                                                std::abs(alice->getTotalSpending() - savedSpending) < 1e-9);
+        runTest("Lookup returns the same object", loaded.findDriver(2) == plain);
+        runTest("Unknown ID still missing", !loaded.findDriver(99) && !loaded.findRider(0));
+        
+        Driver* located = loaded.findDriver(1);
+        GeoPoint location;
+        runTest("Location and availability restored", located && located->getLocation(location) &&
+                                                      location.x == 2.0 && located->isAvailable());
+        
+        // Ride 4 came from requestRide, so it carries a pickup point
+        Rider* bob = loaded.findRider(2);
+        runTest("Rider rides restored", bob && bob->getRideCount() == 1);
+        auto nearest = loaded.findNearestDrivers({0.0, 0.0}, 1);
+        runTest("Available driver matchable after load", nearest.size() == 1 && nearest[0] == located);
+        
+        double before = plain->getTotalEarnings();
+        loaded.repriceRide(3, 8.0);
+        runTest("Re-price after load", std::abs(plain->getTotalEarnings() - (before + 2.0 * Ride::BASE_RATE * EconomyRide::ECONOMY_DISCOUNT)) < 1e-9 &&
+                                       std::abs(loaded.computeStats().totalRevenue -
+                                                (savedStats.totalRevenue + 2.0 * Ride::BASE_RATE * EconomyRide::ECONOMY_DISCOUNT)) < 1e-9);
+        
+        // New objects continue from the saved counters
+        Driver* fresh = loaded.addDriver("Fresh Driver");
+        auto ride = loaded.createRide("standard", "Downtown", "Harbor", 2.0, fresh, alice);
+        runTest("Counters continue", fresh->getDriverID() == 3 && ride->getRideID() == 5);
+        
+        // Forged headers: counts whose section sizes wrap around, and driver IDs out of order
+        auto forged = [&path](long offset, const void* bytes, size_t size) {
+            RideSharingSystem source;
+            source.addDriver("First Driver");
+            source.addDriver("Second Driver");
+            source.addRider("Only Rider");
+            source.saveSnapshot(path);
+            FILE* file = std::fopen(path.c_str(), "r+b");
+            std::fseek(file, offset, SEEK_SET);
+            std::fwrite(bytes, size, 1, file);
+            std::fclose(file);
+            RideSharingSystem target;
+            return !target.loadSnapshot(path) && !target.findDriver(1);
+        };
+        const long driverCountOffset = 32; // After magic, version, byte order and the three ID counters
+        const long sectionTableOffset = 72;
+        // 40-byte records: 2 + 2^62 drivers wrap to the size of 2, and so does their start table
+        const uint64_t wrappingCount = 2 + (uint64_t(1) << 62);
+        bool wrapRejected = forged(driverCountOffset, &wrappingCount, sizeof(wrappingCount));
+        uint64_t driverSection = 0;
+        FILE* image = std::fopen(path.c_str(), "rb");
+        std::fseek(image, sectionTableOffset, SEEK_SET); // Drivers is the first section
+        bool readTable = std::fread(&driverSection, sizeof(driverSection), 1, image) == 1;
+        std::fclose(image);
+        const int32_t repeatedID = 1; // Second driver claims the first one's ID
+        bool orderRejected = readTable && forged(static_cast<long>(driverSection + sizeof(SnapshotDriver)),
+                                                 &repeatedID, sizeof(repeatedID));
+        runTest("Forged snapshot headers rejected", sizeof(SnapshotDriver) == 40 && wrapRejected && orderRejected);
+        
+        // A file that is not a snapshot is rejected without touching the system
+        FILE* garbage = std::fopen(path.c_str(), "wb");
+        std::fputs("not a snapshot, just some text long enough to cover a header", garbage);
+        for (int i = 0; i < 64; ++i) {
+            std::fputs("padding padding padding ", garbage);
+        }
+        std::fclose(garbage);
+        RideSharingSystem empty;
+        runTest("Corrupt snapshot rejected", !empty.loadSnapshot(path) && !empty.findDriver(1));
+        runTest("Missing snapshot rejected", !empty.loadSnapshot("test_snapshot_missing.bin"));
+        std::remove(path.c_str());
+    }
+    
+    void testJournal() {
+        std::cout << "\n=== Testing Write-Ahead Journal ===" << std::endl;
+        const std::string path = "test_journal.log";
+        std::remove(path.c_str());
+        JournalOptions options;
+        options.commitWindow = std::chrono::microseconds(500);
+        
+        double savedEarnings;
+        size_t fileSize;
+        {
+            RideSharingSystem system;
+            runTest("Journal opened", system.openJournal(path, options));
+            Driver* located = system.addDriver("Located Driver", 4.0, {1.0, 2.0});
+            Driver* plain = system.addDriver("Plain Driver", 4.5);
+            Rider* rider = system.addRider("Journal Rider", "PayPal");
+            system.createRide("standard", "Downtown", "Airport", 10.0, plain, rider);
+            system.createRide("premium", "Mall", "Harbor", 4.0, plain, rider);
+            system.createRides({{"economy", "Airport", "Downtown", 6.0, plain, rider},
+                                {"standard", "Harbor", "Mall", 3.0, plain, rider}});
+            system.requestRide(rider, "Corner", {0.0, 0.0}, "Office", 2.0);
+            system.updateDriverRating(plain->getDriverID(), 3.0);
+            system.repriceRide(1, 12.0);
+            system.cancelRide(2);
+            runTest("Live system unaffected", located->getRideCount() == 1 && plain->getRideCount() == 3 &&
+                                              system.getMetrics().value("journal_commit_failures") == 0);
+            savedEarnings = plain->getTotalEarnings();
+        }
+        
+        {
+            RideSharingSystem replayed;
+            runTest("Journal replayed", replayed.openJournal(path, options));
+            Driver* plain = replayed.findDriver(2);
+            Driver* located = replayed.findDriver(1);
+            Rider* rider = replayed.findRider(1);
+            GeoPoint location;
+            runTest("Drivers and riders restored", plain && located && rider &&
+                                                   rider->getPaymentMethod() == "PayPal" &&
+                                                   located->getLocation(location) && location.y == 2.0);
+            runTest("Rating restored", plain && plain->getRating() == 3.75);
+            runTest("Rides, re-price and cancel restored",
+                    plain && plain->getRideCount() == 3 && rider->getRideCount() == 4 &&
+                    std::abs(plain->getTotalEarnings() - savedEarnings) < 1e-9 &&
+                    replayed.getRideStore().size() == 4);
+            runTest("Matched ride restored", located && located->getRideCount() == 1 &&
+                                             replayed.getRideStore().getRideIDs().back() == 5);
+            Driver* fresh = replayed.addDriver("After Replay");
+            runTest("Counters continue after replay", fresh->getDriverID() == 3);
+        }
+        
+        // A record torn by a crash is cut off; everything before it survives
+        {
+            FILE* file = std::fopen(path.c_str(), "ab");
+            std::fseek(file, 0, SEEK_END);
+            fileSize = static_cast<size_t>(std::ftell(file));
+            std::fputs("\x40\x03partial", file);
+            std::fclose(file);
+            RideSharingSystem recovered;
+            bool opened = recovered.openJournal(path, options);
+            runTest("Torn tail recovered", opened && recovered.findDriver(3) &&
+                                           recovered.getRideStore().size() == 4);
+        }
+        FILE* file = std::fopen(path.c_str(), "rb");
+        std::fseek(file, 0, SEEK_END);
+        runTest("Torn tail truncated", static_cast<size_t>(std::ftell(file)) == fileSize);
+        std::fclose(file);
+        std::remove(path.c_str());
+        
+        // Concurrent callers under every policy; durable ones share fsyncs
+        bool allReplayed = true;
+        for (SyncPolicy policy : {SyncPolicy::Always, SyncPolicy::Group, SyncPolicy::Periodic, SyncPolicy::None}) {
+            options.sync = policy;
+            {
+                RideSharingSystem system;
+                system.openJournal(path, options);
+                Driver* driver = system.addDriver("Busy Driver");
+                Rider* rider = system.addRider("Busy Rider");
+                std::vector<std::thread> threads;
+                for (int t = 0; t < 4; ++t) {
+                    threads.emplace_back([&system, driver, rider]() {
+                        for (int i = 0; i < 50; ++i) {
+                            system.createRide("standard", "A", "B", 1.0, driver, rider);
+                        }
+                    });
+                }
+                for (auto& thread : threads) {
+                    thread.join();
+                }
+            }
+            RideSharingSystem replayed;
+            replayed.openJournal(path, options);
+            allReplayed = allReplayed && replayed.getRideStore().size() == 200 &&
+                          replayed.findDriver(1)->getRideCount() == 200;
+            std::remove(path.c_str());
+        }
+        runTest("Concurrent appends replayed under every policy", allReplayed);
+        
+        // Saving a snapshot empties the journal; the two together restore the state
+        const std::string snapshotPath = "test_journal_snapshot.bin";
+        {
+            RideSharingSystem system;
+            system.openJournal(path, options);
+            Driver* driver = system.addDriver("Snapshot Driver");
+            Rider* rider = system.addRider("Snapshot Rider");
+            system.createRide("standard", "A", "B", 2.0, driver, rider);
+            system.saveSnapshot(snapshotPath);
+            system.createRide("premium", "B", "C", 3.0, driver, rider);
+            system.updateDriverRating(driver->getDriverID(), 4.0);
+        }
+        {
+            RideSharingSystem restored;
+            restored.loadSnapshot(snapshotPath);
+            restored.openJournal(path, options);
+            Driver* driver = restored.findDriver(1);
+            runTest("Snapshot plus journal restore", driver && driver->getRideCount() == 2 &&
+                                                     driver->getRating() == 4.5 &&
+                                                     restored.getRideStore().size() == 2);
+        }
+        std::remove(path.c_str());
+        std::remove(snapshotPath.c_str());
+    }
+    
+    void testRideIDExhaustion() {
+        std::cout << "\n=== Testing Ride ID Exhaustion ===" << std::endl;
+        const std::string path = "test_exhaustion.log";
+        std::remove(path.c_str());
+        
+        // A journal whose last ride sits just below the top of the ID space
+        {
+            auto journal = Journal::open(path, JournalOptions(), {});
+            JournalEvent event;
+            event.type = JournalEventType::AddDriver;
+            event.id = 1;
+            event.name = "Last Driver";
+            event.value = 5.0;
+            journal->append(event);
+            event.type = JournalEventType::AddRider;
+            event.name = "Last Rider";
+            event.paymentMethod = "Card";
+            journal->append(event);
+            event.type = JournalEventType::CreateRide;
+            event.id = INT_MAX - 2;
+            event.pickup = "A";
+            event.dropoff = "B";
+            event.driverID = 1;
+            event.riderID = 1;
+            event.value = 5.0;
+            journal->append(event);
+            journal->flush();
+        }
+        
+        RideSharingSystem system;
+        runTest("High ride ID replayed", system.openJournal(path) && system.getRideStore().size() == 1);
+        Driver* driver = system.findDriver(1);
+        Rider* rider = system.findRider(1);
+        auto last = system.createRide(RideType::Standard, "A", "B", 1.0, driver, rider);
+        runTest("Last ride ID issued", last && last->getRideID() == INT_MAX - 1);
+        
+        auto refused = system.createRide(RideType::Standard, "A", "B", 1.0, driver, rider);
+        auto batch = system.createRides({{"standard", "A", "B", 1.0, driver, rider},
+                                         {"premium", "B", "A", 1.0, driver, rider}});
+        runTest("Rides refused once IDs run out", !refused && batch.size() == 2 && !batch[0] && !batch[1]);
+        runTest("Refused rides leave no trace", system.getRideStore().size() == 2 && driver->getRideCount() == 2 &&
+                                                rider->getRideCount() == 2);
+        std::remove(path.c_str());
+    }
+    
+    void testTripImporter() {
+        std::cout << "\n=== Testing Trip Importer ===" << std::endl;
+        double value = 0.0;
+        runTest("Plain numbers parsed", parseNumber("12.5", value) && value == 12.5 &&
+                                        parseNumber("-3e2", value) && value == -300.0 &&
+                                        parseNumber("0.1", value) && value == 0.1);
+        runTest("Long numbers parsed exactly", parseNumber("3.14159265358979323846", value) &&
+                                               value == 3.14159265358979323846);
+        runTest("Malformed numbers rejected", !parseNumber("", value) && !parseNumber("1.2.3", value) &&
+                                              !parseNumber("abc", value) && !parseNumber("1e", value));
+        
+        Logger::instance().setLevel(LogLevel::Error); // Expected skip warnings stay quiet
+        RideSharingSystem system;
+        TripImporter importer(system, 2); // Small batches exercise several flushes
+        std::istringstream csv("Driver,Rider,Pickup,Dropoff,Distance,Type,Notes\r\n"
+                               "Ann,Bob,Downtown,Airport,10,premium,x\r\n"
+                               "Ann,\"Smith, \"\"Jo\"\"\",Mall,Harbor,2.5,,\n"
+                               "\n"
+                               "Ann,Bob,Mall,Harbor,not-a-number,standard,\n"
+                               "Ann,Bob,Mall,Harbor,1,scooter,\n"
+                               "Cy,Bob,Harbor,Mall,4,economy");
+        bool imported = importer.importStream(csv);
+        const ImportStats& stats = importer.getStats();
+        runTest("CSV trips imported", imported && stats.imported == 3 && stats.rejected == 2 &&
+                                      system.getRideStore().size() == 3);
+        Driver* ann = system.findDriver(1);
+        Rider* quoted = system.findRider(2);
+        runTest("Drivers and riders created once per name",
+                ann && ann->getName() == "Ann" && ann->getRideCount() == 2 &&
+                quoted && quoted->getName() == "Smith, \"Jo\"" && system.findDriver(3) == nullptr);
+        runTest("CSV fields mapped by header", system.getRideStore().getTypes()[0] == RideType::Premium &&
+                                               system.getRideStore().getTypes()[1] == RideType::Standard &&
+                                               system.getRideStore().getDistances()[1] == 2.5);
+        
+        std::istringstream jsonl("{\"driver\": \"Ann\", \"rider\": \"Bob\", \"pickup\": \"Caf\\u00e9\", "
+                                 "\"dropoff\": \"Pier\", \"distance\": 3, \"type\": \"economy\", \"tip\": null}\n"
+                                 "{\"driver\": \"Dee\", \"rider\": \"Bob\", \"pickup\": \"A\", \"dropoff\": \"B\", "
+                                 "\"distance\": \"7.25\"}\n"
+                                 "{\"driver\": \"Dee\", \"rider\": \"Bob\", \"pickup\": \"A\"}\n"
+                                 "{\"driver\": \"Dee\", \"rider\": \"Bob\", \"pickup\": \"A\", \"dropoff\": [1]}\n");
+        imported = importer.importStream(jsonl);
+        runTest("JSONL trips imported", imported && stats.imported == 5 && stats.rejected == 4 &&
+                                        ann->getRideCount() == 3);
+        runTest("JSON escapes decoded", system.getRideStore().makeRide(3) &&
+                                        system.getRideStore().makeRide(3)->getPickupLocation() == "Caf\xc3\xa9");
+        
+        std::istringstream badHeader("driver,rider,pickup\nAnn,Bob,Mall\n");
+        runTest("CSV without required columns refused", !importer.importStream(badHeader));
+        Logger::instance().setLevel(LogLevel::Info);
+    }
+    
+    void testMetrics() {
+        std::cout << "\n=== Testing Metrics ===" << std::endl;
+        bool bucketsConsistent = true;
+        for (size_t b = 1; b < Histogram::BUCKET_COUNT; ++b) {
+            uint64_t bound = Histogram::bucketUpperBound(b);
+            bucketsConsistent = bucketsConsistent && bound > Histogram::bucketUpperBound(b - 1) &&
+                                Histogram::bucketFor(bound) == b &&
+                                Histogram::bucketFor(Histogram::bucketUpperBound(b - 1) + 1) == b;
+        }
+        runTest("Histogram buckets contiguous", bucketsConsistent &&
+                                                Histogram::bucketFor(~0ULL) == Histogram::BUCKET_COUNT - 1);
+        
+        Histogram exact(1);
+        for (uint64_t ns = 1; ns <= 1000; ++ns) {
+            exact.record(ns);
+        }
+        HistogramSnapshot snapshot = exact.snapshot();
+        runTest("Histogram quantiles within 3%", snapshot.count == 1000 && snapshot.max == 1000 &&
+                                                 std::abs(static_cast<double>(snapshot.quantile(0.5)) - 500) <= 15 &&
+                                                 std::abs(static_cast<double>(snapshot.quantile(0.99)) - 990) <= 30 &&
+                                                 snapshot.mean() == 500.5);
+        
+        Histogram sampled(64);
+        for (int i = 0; i < 64000; ++i) {
+            LatencyTimer timer(sampled);
+        }
+        uint64_t estimate = sampled.snapshot().count;
+        runTest("Sampled histogram estimates the call count", estimate > 48000 && estimate < 80000);
+        
+        Counter counter;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&counter]() {
+                for (int i = 0; i < 100000; ++i) {
+                    counter.add();
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        runTest("Counter exact under concurrent increments", counter.value() == 400000);
+        
+        RideSharingSystem system;
+        system.getMetrics().setSampleInterval(1);
+        Driver* driver = system.addDriver("Metric Driver");
+        Rider* rider = system.addRider("Metric Rider");
+        system.createRide("standard", "A", "B", 2.0, driver, rider);
+        system.createRide("premium", "B", "C", 3.0, driver, rider);
+        system.createRide("scooter", "C", "D", 1.0, driver, rider);
+        system.createRides({{"economy", "A", "C", 4.0, driver, rider}, {"economy", "C", "A", 4.0, nullptr, rider}});
+        system.requestRide(rider, "Corner", {0.0, 0.0}, "Office", 1.0, "scooter");
+        system.cancelRide(1);
+        for (int i = 0; i < 10; ++i) {
+            system.findRider(1);
+        }
+        system.computeStats();
+        MetricsRegistry& metrics = system.getMetrics();
+        runTest("Ride counters", metrics.value("rides_created") == 3 && metrics.value("ride_requests_rejected") == 3 &&
+                                 metrics.value("rides_cancelled") == 1);
+        runTest("Latency histograms count calls", metrics.value("create_ride") == 3 &&
+                                                  metrics.value("create_rides_batch") == 1 &&
+                                                  metrics.value("find_rider") >= 10 &&
+                                                  metrics.value("stats_query") == 1);
+        runTest("Gauges read live values", metrics.value("rides") == 2 && metrics.value("drivers") == 1 &&
+                                           metrics.value("riders") == 1 &&
+                                           metrics.value("resident_memory_bytes") > 0);
+        
+        std::string text = metrics.renderPrometheus();
+        runTest("Prometheus format", text.find("# TYPE ridesharing_rides_created_total counter\n"
+                                               "ridesharing_rides_created_total 3\n") != std::string::npos &&
+                                     text.find("ridesharing_create_ride_seconds_bucket{le=\"+Inf\"} 3\n") != std::string::npos &&
+                                     text.find("ridesharing_create_ride_seconds_count 3\n") != std::string::npos &&
+                                     text.find("# TYPE ridesharing_rides gauge\nridesharing_rides 2\n") != std::string::npos);
+        const std::string path = "test_metrics.prom";
+        bool written = system.exportMetrics(path);
+        std::ifstream in(path);
+        std::string first;
+        std::getline(in, first);
+        runTest("Metrics exported to file", written && first.compare(0, 7, "# HELP ") == 0);
+        std::remove(path.c_str());
+    }
+    
+    void testRidePool() {
+        std::cout << "\n=== Testing Ride Pool ===" << std::endl;
+        FixedPool pool(24, 8);
+        void* first = pool.allocate();
+        void* second = pool.allocate();
+        pool.deallocate(first);
+        void* reused = pool.allocate();
+        PoolStats stats;
+        pool.addStats(stats);
+        runTest("Freed blocks are reused", reused == first && reused != second &&
+                                           stats.liveBlocks == 2 && stats.chunks == 1);
+        pool.deallocate(second);
+        pool.deallocate(reused);
+        
+        PoolStats before = ridePoolStats();
+        {
+            std::vector<std::shared_ptr<Ride>> rides;
+            for (int i = 0; i < 1000; ++i) {
+                rides.push_back(makeRide(RideType::Premium, i, "Pool A", "Pool B", 5.0));
+            }
+            PoolStats during = ridePoolStats();
+            bool aligned = true;
+            for (const auto& ride : rides) {
+                aligned = aligned && reinterpret_cast<uintptr_t>(ride.get()) % alignof(PremiumRide) == 0;
+            }
+            runTest("Rides come from the pool", during.liveBlocks == before.liveBlocks + 1000 && aligned &&
+                                                rides[999]->fare() == PremiumRide(0, "", "", 5.0).fare());
+        }
+        runTest("Released rides return to the pool", ridePoolStats().liveBlocks == before.liveBlocks);
+        
+        LocationPool arena(StringStorage::Arena);
+        std::string longName(100000, 'x'); // Larger than an arena block
+        uint32_t shortId = arena.intern("Arena Street");
+        uint32_t longId = arena.intern(longName);
+        std::string_view shortView = arena.name(shortId);
+        for (int i = 0; i < 10000; ++i) {
+            arena.intern("Arena location number " + std::to_string(i));
+        }
+        uint32_t found = 0;
+        runTest("Arena names stay stable", arena.name(shortId).data() == shortView.data() &&
+                                           shortView == "Arena Street" && arena.name(longId) == longName &&
+                                           arena.name(arena.intern("Arena location number 9999")) ==
+                                               "Arena location number 9999" &&
+                                           arena.find("Arena location number 5000", found) &&
+                                           arena.name(found) == "Arena location number 5000" &&
+                                           arena.size() == 10002);
+        
+        LocationPool fresh(StringStorage::Arena);
+        uint32_t emptyId = fresh.intern(""); // Before any arena block exists
+        runTest("Empty arena name", fresh.name(emptyId).empty() && fresh.find("", found) && found == emptyId &&
+                                    fresh.name(fresh.intern("After Empty")) == "After Empty");
+    }
+    
+    void testRideTable() {
+        std::cout << "\n=== Testing Ride Table ===" << std::endl;
+        RideTable table;
+        auto ride = std::make_shared<StandardRide>(5000, "A", "B", 2.0);
+        table.insert(ride);
+        runTest("Ride resolved by ID", table.find(5000) == ride.get() && table.get(5000) == ride &&
+                                       table.find(4999) == nullptr && table.find(-1) == nullptr &&
+                                       table.size() == 1);
+        std::shared_ptr<Ride> released = table.release(5000);
+        runTest("Released ride no longer resolves", released == ride && table.find(5000) == nullptr &&
+                                                    !table.release(5000) && table.size() == 0);
+        
+        table.insert(ride);
+        Driver standalone(1, "Table Driver", 5.0, &table);
+        standalone.addRide(*ride);
+        standalone.addRide(StandardRide(4999, "A", "B", 3.0)); // Never stored in the table
+        Logger::instance().setLevel(LogLevel::Off);
+        standalone.recomputeTotals();
+        Logger::instance().setLevel(LogLevel::Info);
+        runTest("Unresolved ride IDs left out of totals", standalone.getTotalEarnings() == ride->fare());
+        
+        RideSharingSystem system;
+        Driver* driver = system.addDriver("Table Driver");
+        Rider* rider = system.addRider("Table Rider");
+        auto first = system.createRide("standard", "A", "B", 2.0, driver, rider);
+        auto second = system.createRide("premium", "B", "C", 3.0, driver, rider);
+        long before = first.use_count();
+        system.createRides({{"economy", "C", "D", 4.0, driver, rider}});
+        runTest("Drivers and riders hold ride IDs", first.use_count() == before &&
+                                                    driver->getRideCount() == 3 && rider->getRideCount() == 3 &&
+                                                    driver->getTotalEarnings() == first->fare() + second->fare() +
+                                                                                 rideFare(RideType::Economy, 4.0));
+        system.cancelRide(second->getRideID());
+        driver->recomputeTotals();
+        rider->recomputeTotals();
+        runTest("Cancelled ride leaves the table", second.use_count() == 1 && driver->getRideCount() == 2 &&
+                                                   driver->getTotalEarnings() == rider->getTotalSpending() &&
+                                                   driver->getTotalEarnings() ==
+                                                       first->fare() + rideFare(RideType::Economy, 4.0));
+    }
+    
+    void testReports() {
+        std::cout << "\n=== Testing Reports ===" << std::endl;
+        
+        bool numbersMatch = true;
+        for (double value : {0.0, 2.005, -0.5, 1234567.891, 1e-9, 17.5}) {
+            for (int precision : {1, 2}) {
+                char expected[64];
+                std::snprintf(expected, sizeof(expected), "%.*f", precision, value);
+                ReportBuffer text;
+                text << fixed(value, precision);
+                numbersMatch = numbersMatch && text.view() == expected;
+            }
+        }
+        ReportBuffer text;
+        text << "ID " << 42 << ' ' << static_cast<size_t>(7) << ' ' << -3L;
+        runTest("Buffer formats like iostream", numbersMatch && text.view() == "ID 42 7 -3");
+        
+        RideSharingSystem system;
+        Driver* driver = system.addDriver("Report Driver");
+        Rider* rider = system.addRider("Report Rider");
+        std::vector<int> ids;
+        for (int i = 1; i <= 5; ++i) {
+            ids.push_back(system.createRide("standard", "A", "B", i, driver, rider)->getRideID());
+        }
+        
+        std::ostringstream viaWrapper;
+        std::streambuf* original = std::cout.rdbuf(viaWrapper.rdbuf());
+        driver->getDriverInfo();
+        rider->viewRides();
+        std::cout.rdbuf(original);
+        std::ostringstream viaWriter;
+        {
+            ReportWriter out(viaWriter);
+            driver->writeInfo(out);
+            rider->writeHistory(out);
+        }
+        char line[96];
+        std::snprintf(line, sizeof(line), "Ride %d: A → B ($%.2f)\n", ids[2], rideFare(RideType::Standard, 3.0));
+        runTest("Wrappers print the full report", viaWrapper.str() == viaWriter.str() &&
+                                                  viaWriter.str().find(line) != std::string::npos &&
+                                                  viaWriter.str().find("Type: Standard Ride\n=== Ride Details") !=
+                                                      std::string::npos);
+        
+        auto countLines = [](const std::string& report, const std::string& prefix) {
+            size_t count = 0;
+            for (size_t pos = report.find(prefix); pos != std::string::npos; pos = report.find(prefix, pos + 1)) {
+                count++;
+            }
+            return count;
+        };
+        std::ostringstream page1;
+        ReportPage first;
+        first.limit = 2;
+        ReportCursor cursor;
+        {
+            ReportWriter out(page1);
+            cursor = driver->writeRides(out, first);
+        }
+        runTest("Offset and limit select a page", countLines(page1.str(), "Ride ") == 2 &&
+                                                  page1.str().rfind("Ride " + std::to_string(ids[0]) + ":", 0) == 0 &&
+                                                  cursor.listed == 2 && cursor.total == 5 && cursor.hasMore() &&
+                                                  cursor.next.offset == 2 && cursor.next.afterRideID == ids[1]);
+        
+        system.cancelRide(ids[0]); // Before the cursor: the following rides move up
+        std::ostringstream page2;
+        {
+            ReportWriter out(page2);
+            cursor = driver->writeRides(out, cursor.next);
+        }
+        runTest("Cursor survives earlier cancellations",
+                countLines(page2.str(), "Ride ") == 2 &&
+                    page2.str().rfind("Ride " + std::to_string(ids[2]) + ":", 0) == 0 && cursor.hasMore() &&
+                    cursor.next.afterRideID == ids[3]);
+        
+        system.cancelRide(ids[3]); // The cursor's own anchor
+        std::ostringstream page3;
+        {
+            ReportWriter out(page3);
+            cursor = driver->writeRides(out, cursor.next);
+        }
+        runTest("Cursor survives a cancelled anchor",
+                page3.str().rfind("Ride " + std::to_string(ids[4]) + ":", 0) == 0 &&
+                    countLines(page3.str(), "Ride ") == 1 && !cursor.hasMore());
+        
+        ReportPage second;
+        second.offset = 1;
+        second.limit = 1;
+        std::ostringstream history;
+        {
+            ReportWriter out(history);
+            cursor = rider->writeHistory(out, second);
+        }
+        runTest("Rider history pages keep absolute numbering",
+                history.str().find("--- Ride 2 ---") != std::string::npos &&
+                    countLines(history.str(), "--- Ride ") == 1 &&
+                    history.str().find("Total Spending: $") != std::string::npos && cursor.total == 3);
+        
+        FILE* file = std::tmpfile();
+        bool wroteBlocks = false;
+        bool fileOk = false;
+        {
+            ReportWriter out(fileno(file));
+            for (int i = 0; i < 20000; ++i) {
+                out << "row " << i << '\n';
+                out.endRecord();
+            }
+            wroteBlocks = out.bytesWritten() >= ReportWriter::BLOCK_BYTES &&
+                          out.bytesWritten() % ReportWriter::BLOCK_BYTES != 0; // Cut at record ends
+            driver->writeInfo(out);
+            fileOk = out.flush();
+        }
+        std::fseek(file, 0, SEEK_END);
+        std::string contents(static_cast<size_t>(std::ftell(file)), '\0');
+        std::rewind(file);
+        contents.resize(std::fread(&contents[0], 1, contents.size(), file));
+        std::fclose(file);
+        std::ostringstream info;
+        {
+            ReportWriter out(info);
+            driver->writeInfo(out);
+        }
+        runTest("File descriptor output in blocks", fileOk && wroteBlocks &&
+                                                    contents.rfind("row 0\nrow 1\n", 0) == 0 &&
+                                                    contents.find("row 19999\n") != std::string::npos &&
+                                                    contents.size() > info.str().size() &&
+                                                    contents.compare(contents.size() - info.str().size(),
+                                                                     std::string::npos, info.str()) == 0);
+        
+        bool failed;
+        {
+            ReportWriter out(-1);
+            out << "lost\n";
+            failed = !out.flush() && !out.good() && out.bytesWritten() == 0;
+        }
+        runTest("Write errors are reported", failed);
+        
+        BikeRide bike(9100, "A", "B", 2.0);
+        ReportBuffer details;
+        bike.writeDetails(details);
+        runTest("Custom rides have no type line", details.view().rfind("=== Ride Details ===\n", 0) == 0);
+    }
+    
+    void testRideQueries() {
+        std::cout << "\n=== Testing Ride Queries ===" << std::endl;
+        Logger::instance().setLevel(LogLevel::Warn);
+        
+        RideSharingSystem system;
+        std::vector<Driver*> drivers;
+        std::vector<Rider*> riders;
+        for (int i = 0; i < 8; ++i) {
+            drivers.push_back(system.addDriver("Query Driver " + std::to_string(i)));
+            riders.push_back(system.addRider("Query Rider " + std::to_string(i)));
+        }
+        static const char* places[] = {"Q-Airport", "Q-Downtown", "Q-Harbor", "Q-Mall", "Q-Stadium"};
+        static const char* types[] = {"standard", "premium", "economy"};
+        auto addRides = [&](int first, int count) {
+            std::vector<RideRequest> requests;
+            for (int i = first; i < first + count; ++i) {
+                requests.push_back({types[i % 3], places[i % 5], places[(i * 3 + 1) % 5], 1.0 + (i * 7 % 25),
+                                    drivers[static_cast<size_t>(i * 5 % 8)], riders[static_cast<size_t>(i % 8)]});
+            }
+            system.createRides(requests);
+        };
+        addRides(0, 400);
+        
+        // Reference answer: every predicate checked against every row of the store
+        auto scan = [&](const RideQuery& query) {
+            const RideStore& store = system.getRideStore();
+            std::vector<int> matched;
+            for (size_t row = 0; row < store.size() && matched.size() < query.limit; ++row) {
+                RideType type = store.getTypes()[row];
+                double distance = store.getDistances()[row];
+                if ((query.types != 0 && !(query.types >> static_cast<unsigned>(type) & 1)) ||
+                    distance < query.minDistance || distance > query.maxDistance ||
+                    (!query.pickup.empty() && store.locationName(store.getPickupIDs()[row]) != query.pickup) ||
+                    (!query.dropoff.empty() && store.locationName(store.getDropoffIDs()[row]) != query.dropoff) ||
+                    (query.driverID != 0 && store.getDriverIDs()[row] != query.driverID) ||
+                    (query.riderID != 0 && store.getRiderIDs()[row] != query.riderID)) {
+                    continue;
+                }
+                matched.push_back(store.getRideIDs()[row]);
+            }
+            return matched;
+        };
+        std::vector<RideQuery> queries;
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+        auto next = [&]() {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            return seed;
+        };
+        for (int i = 0; i < 300; ++i) {
+            RideQuery query;
+            if (next() % 2) {
+                query.type(static_cast<RideType>(next() % 3));
+            }
+            if (next() % 2) {
+                query.minDistance = static_cast<double>(next() % 20);
+                query.maxDistance = query.minDistance + static_cast<double>(next() % 10);
+            }
+            if (next() % 3 == 0) {
+                query.pickup = places[next() % 5];
+            }
+            if (next() % 3 == 0) {
+                query.dropoff = places[next() % 5];
+            }
+            if (next() % 3 == 0) {
+                query.driverID = drivers[next() % 8]->getDriverID();
+            }
+            if (next() % 3 == 0) {
+                query.riderID = riders[next() % 8]->getRiderID();
+            }
+            if (next() % 4 == 0) {
+                query.limit = next() % 10;
+            }
+            queries.push_back(query);
+        }
+        auto allMatch = [&]() {
+            for (const RideQuery& query : queries) {
+                if (system.queryRides(query).rideIDs != scan(query)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        runTest("Queries match a full scan", allMatch());
+        
+        RideQuery premiumFromAirport;
+        premiumFromAirport.type(RideType::Premium);
+        premiumFromAirport.pickup = "Q-Airport";
+        premiumFromAirport.minDistance = 10.0;
+        RideQueryResult answer = system.queryRides(premiumFromAirport);
+        runTest("Premium rides from a location over a distance",
+                !answer.rideIDs.empty() && answer.rideIDs == scan(premiumFromAirport) &&
+                    answer.path == RideAccessPath::Pickup && answer.candidates == 80);
+        
+        RideQuery narrow;
+        narrow.pickup = "Q-Airport";
+        narrow.minDistance = 3.0;
+        narrow.maxDistance = 3.0; // 16 rides, fewer than the 80 picked up there
+        answer = system.queryRides(narrow);
+        runTest("Planner drives from the most selective index",
+                answer.path == RideAccessPath::Distance && answer.candidates == 16 && answer.rideIDs == scan(narrow));
+        
+        RideQuery byRider;
+        byRider.riderID = riders[3]->getRiderID();
+        byRider.driverID = drivers[7]->getDriverID(); // i % 8 == 3 puts every such ride with driver 7
+        byRider.type(RideType::Economy);
+        answer = system.queryRides(byRider);
+        RideQuery everything;
+        everything.limit = 5;
+        RideQueryResult firstFive = system.queryRides(everything);
+        runTest("Postings intersect and bitmaps list all rides",
+                answer.path == RideAccessPath::Driver && answer.rideIDs == scan(byRider) &&
+                    firstFive.path == RideAccessPath::TypeBitmap && firstFive.rideIDs == std::vector<int>{1, 2, 3, 4, 5});
+        
+        RideQuery unknown;
+        unknown.dropoff = "Nowhere Q";
+        RideQuery empty;
+        empty.minDistance = 5.0;
+        empty.maxDistance = 4.0;
+        RideQuery custom;
+        custom.type(RideType::Custom);
+        runTest("Unmatchable predicates answer nothing",
+                system.queryRides(unknown).rideIDs.empty() && system.queryRides(unknown).path == RideAccessPath::None &&
+                    system.queryRides(empty).rideIDs.empty() && system.queryRides(custom).rideIDs.empty());
+        
+        // Changes after the first query are applied to the built indexes
+        addRides(400, 300);
+        for (int rideID = 3; rideID <= 700; rideID += 7) {
+            system.cancelRide(rideID);
+        }
+        for (int rideID = 5; rideID <= 700; rideID += 11) {
+            if ((rideID - 3) % 7 != 0) {
+                system.repriceRide(rideID, 12.5);
+            }
+        }
+        RideQuery repriced;
+        repriced.minDistance = 12.5;
+        repriced.maxDistance = 12.5;
+        runTest("Indexes follow creates, cancels and re-prices",
+                allMatch() && system.queryRides(repriced).rideIDs == scan(repriced) &&
+                    system.queryRides(repriced).rideIDs.size() >= 50);
+        
+        const std::string path = "test_query_snapshot.bin";
+        bool saved = system.saveSnapshot(path);
+        RideSharingSystem loaded;
+        bool restored = loaded.loadSnapshot(path);
+        bool sameAnswers = true;
+        for (const RideQuery& query : queries) {
+            sameAnswers = sameAnswers && loaded.queryRides(query).rideIDs == system.queryRides(query).rideIDs;
+        }
+        std::remove(path.c_str());
+        runTest("Indexes rebuilt after a snapshot load", saved && restored && sameAnswers);
+        Logger::instance().setLevel(LogLevel::Info);
+    }
+    
+    void testTimeSeries() {
+        std::cout << "\n=== Testing Time-Series Analytics ===" << std::endl;
+        const int64_t minute = RideTimeSeries::MINUTE_MILLIS;
+        const int64_t hour = RideTimeSeries::HOUR_MILLIS;
+        const int64_t start = 1700000000000LL / hour * hour; // On an hour boundary
+        RideTimeSeries series;
+        series.recordRequest(RideType::Standard, 10.0, start + 1 * minute);
+        series.recordRequest(RideType::Premium, 20.0, start + 50 * minute);
+        series.recordRequest(RideType::Premium, 30.0, start + 55 * minute);
+        series.recordCompletion(RideType::Premium, start + 58 * minute);
+        series.recordRequest(RideType::Economy, 5.0, 0); // Unknown request time
+        int64_t now = start + 59 * minute + 30000;
+        TimeWindowStats recent = series.window(now, 15 * minute);
+        TimeWindowStats lastHour = series.window(now, hour);
+        runTest("Rolling windows", recent.requestCount() == 2 && recent.revenue() == 50.0 &&
+                                   recent.completionCount(RideType::Premium) == 1 &&
+                                   recent.start == start + 45 * minute &&
+                                   lastHour.requestCount() == 3 && lastHour.requestCount(RideType::Standard) == 1 &&
+                                   lastHour.revenue(RideType::Premium) == 50.0);
+        
+        series.recordReprice(RideType::Premium, 30.0, 33.0, start + 55 * minute);
+        series.recordCancel(RideType::Premium, 20.0, start + 50 * minute, 0);
+        std::vector<TimeWindowStats> minutes = series.series(now, 60, false);
+        runTest("Re-price and cancel adjust their buckets", series.window(now, 15 * minute).revenue() == 33.0 &&
+                                                           series.window(now, 15 * minute).requestCount() == 1 &&
+                                                           minutes.size() == 60 && minutes[1].requestCount() == 1 &&
+                                                           minutes[55].revenue() == 33.0 &&
+                                                           minutes[50].requestCount() == 0);
+        
+        // Two days later the minute ring has wrapped but the hour ring still holds the rides
+        int64_t later = start + 48 * hour + 30 * minute;
+        series.recordRequest(RideType::Economy, 7.0, later);
+        std::vector<TimeWindowStats> hours = series.series(later, 49, true);
+        runTest("Old minutes expire, hours remain", series.window(later, 24 * hour).requestCount() == 1 &&
+                                                    series.window(later, 72 * hour).requestCount() == 3 &&
+                                                    hours.front().start == start &&
+                                                    hours.front().requestCount() == 2 &&
+                                                    hours.back().requestCount(RideType::Economy) == 1);
+        series.recordCancel(RideType::Standard, 10.0, start + 1 * minute, 0);
+        runTest("Cancel outside the minute ring updates hours only",
+                series.window(later, 72 * hour).requestCount() == 2 &&
+                series.window(later, 72 * hour).revenue() == 40.0);
+        
+        RideSharingSystem system;
+        Driver* driver = system.addDriver("Clock Driver");
+        Rider* rider = system.addRider("Clock Rider");
+        int64_t before = wallClockMillis();
+        auto ride = system.createRide("premium", "A", "B", 4.0, driver, rider);
+        system.createRides({{"standard", "B", "C", 2.0, driver, rider}, {"economy", "C", "A", 6.0, driver, rider}});
+        bool completed = system.completeRide(ride->getRideID());
+        bool again = system.completeRide(ride->getRideID());
+        TimeWindowStats activity = system.recentActivity(15 * minute);
+        runTest("Rides carry timestamps", ride->getRequestedAt() >= before &&
+                                          ride->getCompletedAt() >= ride->getRequestedAt() && completed && !again);
+        runTest("System activity matches totals", activity.requestCount() == 3 && activity.completionCount() == 1 &&
+                                                  std::abs(activity.revenue() - system.computeStats().totalRevenue) < 1e-9 &&
+                                                  system.getMetrics().value("rides_completed") == 1);
+        system.cancelRide(ride->getRideID());
+        activity = system.recentActivity(15 * minute);
+        std::vector<TimeWindowStats> perMinute = system.activitySeries(60, false);
+        uint64_t listed = 0;
+        for (const TimeWindowStats& bucket : perMinute) {
+            listed += bucket.requestCount();
+        }
+        runTest("Cancelled ride leaves the window", activity.requestCount() == 2 && activity.completionCount() == 0 &&
+                                                    perMinute.size() == 60 && listed == 2);
+    }
+    
+    void testLeaderboard() {
+        std::cout << "\n=== Testing Driver Leaderboard ===" << std::endl;
+        // Random updates checked against a full sort after each round
+        Leaderboard board;
+        std::vector<double> earnings(2000, -1.0); // Enough keys to split and merge blocks
+        uint32_t state = 12345;
+        auto next = [&state]() { return state = state * 1103515245u + 12345u; };
+        bool consistent = true;
+        for (int round = 0; round < 20; ++round) {
+            for (int i = 0; i < 1000; ++i) {
+                int id = static_cast<int>(next() % earnings.size());
+                if (next() % (round < 10 ? 10 : 2) == 0) { // Later rounds shrink the board
+                    board.remove(id);
+                    earnings[id] = -1.0;
+                } else {
+                    earnings[id] = static_cast<double>(next() % 50); // Frequent ties
+                    board.update(id, earnings[id], 0, 5.0);
+                }
+            }
+            std::vector<LeaderboardEntry> expected;
+            for (size_t id = 0; id < earnings.size(); ++id) {
+                if (earnings[id] >= 0.0) {
+                    expected.push_back({static_cast<int>(id), earnings[id]});
+                }
+            }
+            std::sort(expected.begin(), expected.end(), [](const LeaderboardEntry& a, const LeaderboardEntry& b) {
+                return a.score > b.score || (a.score == b.score && a.driverID < b.driverID);
+            });
+            std::vector<LeaderboardEntry> top = board.top(LeaderboardMetric::Earnings, 10);
+            consistent = consistent && board.size() == expected.size() &&
+                         top.size() == std::min<size_t>(10, expected.size());
+            for (size_t i = 0; consistent && i < top.size(); ++i) {
+                consistent = top[i].driverID == expected[i].driverID && top[i].score == expected[i].score;
+            }
+            for (size_t i = 0; consistent && i < expected.size(); ++i) {
+                consistent = board.rank(LeaderboardMetric::Earnings, expected[i].driverID) == i + 1;
+            }
+        }
+        runTest("Rankings match a full sort", consistent);
+        runTest("Unranked driver has rank 0", board.rank(LeaderboardMetric::Earnings, 5000) == 0 &&
+                                              !board.remove(5000));
+        
+        RideSharingSystem system;
+        Driver* alice = system.addDriver("Alice", 4.0);
+        Driver* bob = system.addDriver("Bob", 4.5);
+        Driver* carol = system.addDriver("Carol", 4.5);
+        Rider* rider = system.addRider("Leaderboard Rider");
+        system.createRide("premium", "A", "B", 10.0, alice, rider);
+        auto bobRide = system.createRide("standard", "B", "C", 2.0, bob, rider);
+        system.createRides({{"economy", "C", "A", 1.0, bob, rider}, {"economy", "A", "C", 1.0, bob, rider}});
+        std::vector<LeaderboardEntry> earners = system.topDrivers(LeaderboardMetric::Earnings, 2);
+        runTest("Rankings follow rides", earners.size() == 2 && earners[0].driverID == alice->getDriverID() &&
+                                         earners[0].score == alice->getTotalEarnings() &&
+                                         system.driverRank(bob->getDriverID(), LeaderboardMetric::RideCount) == 1 &&
+                                         system.driverRank(carol->getDriverID(), LeaderboardMetric::RideCount) == 3);
+        
+        system.updateDriverRating(alice->getDriverID(), 5.0);
+        alice->updateRating(5.0); // Direct updates reach the board too
+        runTest("Rankings follow ratings", system.driverRank(alice->getDriverID(), LeaderboardMetric::Rating) == 1 &&
+                                           system.driverRank(bob->getDriverID(), LeaderboardMetric::Rating) == 2);
+        
+        system.repriceRide(bobRide->getRideID(), 100.0);
+        system.cancelRide(1);
+        runTest("Rankings follow re-pricing and cancellation",
+                system.topDrivers(LeaderboardMetric::Earnings, 1)[0].driverID == bob->getDriverID() &&
+                system.driverRank(alice->getDriverID(), LeaderboardMetric::Earnings) == 2 &&
+                system.driverRank(alice->getDriverID(), LeaderboardMetric::RideCount) == 2 &&
+                system.driverRank(99, LeaderboardMetric::Earnings) == 0);
+        
+        const std::string path = "test_leaderboard_snapshot.bin";
+        bool saved = system.saveSnapshot(path);
+        RideSharingSystem loaded;
+        bool restored = saved && loaded.loadSnapshot(path);
+        std::vector<LeaderboardEntry> loadedTop = loaded.topDrivers(LeaderboardMetric::Earnings, 3);
+        runTest("Snapshot drivers are ranked", restored && loadedTop.size() == 3 &&
+                                               loadedTop[0].driverID == bob->getDriverID() &&
+                                               std::abs(loadedTop[0].score - bob->getTotalEarnings()) < 1e-9);
+        std::remove(path.c_str());
+    }
+
+    void testSurgePricing() {
+        std::cout << "\n=== Testing Surge Pricing ===" << std::endl;
+        // Default policy: 2-mile zones, 5-minute window, surge above 2 requests per idle driver
+        SurgeEngine engine;
+        const int64_t t0 = 1700000000000LL;
+        engine.setDriverIdle(1, {0.5, 0.5});
+        uint16_t quotes[4];
+        for (uint16_t& quote : quotes) {
+            quote = engine.quote({1.0, 1.0}, t0);
+        }
+        runTest("Surge starts above the threshold", quotes[0] == 100 && quotes[1] == 100 &&
+                                                    quotes[2] == 120 && quotes[3] == 150);
+
+        engine.setDriverIdle(2, {1.5, 1.9});
+        engine.setDriverIdle(3, {5.0, 5.0}); // Another zone
+        ZoneDemand demand = engine.zone({0.1, 0.1}, t0);
+        runTest("Idle drivers in the zone damp surge", demand.requests == 4 && demand.idleDrivers == 2 &&
+                                                      demand.surgePercent == 110);
+
+        engine.setDriverIdle(2, {9.0, 9.0}); // Drives away
+        engine.setDriverBusy(1);             // Matched
+        engine.setDriverBusy(1);             // Repeated updates are harmless
+        demand = engine.zone({0.1, 0.1}, t0);
+        runTest("Busy and departed drivers stop counting", demand.idleDrivers == 0 && demand.surgePercent == 170);
+
+        for (int i = 0; i < 20; ++i) {
+            engine.recordRequest({1.0, 1.0}, t0);
+        }
+        std::vector<ZoneDemand> surging = engine.surgingZones(t0);
+        runTest("Surge is capped", engine.zone({1.0, 1.0}, t0).surgePercent == 300 && surging.size() == 1 &&
+                                   surging[0].zoneX == 0 && surging[0].zoneY == 0);
+        runTest("Requests leave the window", engine.zone({1.0, 1.0}, t0 + 270000).requests == 24 &&
+                                             engine.zone({1.0, 1.0}, t0 + 300000).requests == 0 &&
+                                             engine.quote({1.0, 1.0}, t0 + 300000) == 100);
+
+        const std::string journalPath = "test_surge_journal.log";
+        const std::string snapshotPath = "test_surge_snapshot.bin";
+        std::remove(journalPath.c_str());
+        double surgedFare = StandardRide::fareFor(4.0) * 1.2;
+        double revenue;
+        {
+            RideSharingSystem system;
+            system.openJournal(journalPath);
+            Driver* driver = system.addDriver("Surge Driver", 4.5, {0.5, 0.5});
+            system.addDriver("Nearby Driver", 4.5, {0.6, 0.6});
+            Rider* rider = system.addRider("Surge Rider");
+            std::shared_ptr<Ride> last;
+            for (int i = 0; i < 6; ++i) { // Two idle drivers absorb four requests
+                last = system.createRide("standard", "Stadium", {1.0, 1.0}, "Hotel", 4.0, driver, rider);
+            }
+            auto unpriced = system.createRide("standard", "Stadium", "Hotel", 4.0, driver, rider);
+            runTest("Busy zone surges the quote", last->getSurgePercent() == 120 &&
+                                                  std::abs(last->computeFare() - surgedFare) < 1e-9 &&
+                                                  unpriced->getSurgePercent() == 100 &&
+                                                  system.getMetrics().value("rides_surged") == 2);
+
+            system.repriceRide(last->getRideID(), 5.0);
+            double repriced = system.getRideStore().getFares()[5];
+            driver->recomputeTotals();
+            revenue = system.getRideStore().totalRevenue();
+            runTest("Re-pricing keeps the surge", std::abs(repriced - StandardRide::fareFor(5.0) * 1.2) < 1e-9 &&
+                                                  std::abs(driver->getTotalEarnings() - revenue) < 1e-9);
+            runTest("Zone demand is reported", system.zoneDemand({1.0, 1.0}).requests == 6 &&
+                                               system.surgingZones().size() == 1);
+            // A surged ride whose unsurged fare is 0, so the quote cannot be read back from the fare
+            auto parked = system.createRide("standard", "Stadium", {1.0, 1.0}, "Stadium", 0.0, driver, rider);
+            runTest("Zero-distance ride is surged", parked->getSurgePercent() > 100);
+        }
+
+        RideSharingSystem replayed;
+        replayed.openJournal(journalPath);
+        runTest("Journal replays the quote", replayed.getRideStore().getSurgePercents()[5] == 120 &&
+                                             replayed.getRideStore().getSurgePercents()[6] == 100 &&
+                                             std::abs(replayed.getRideStore().totalRevenue() - revenue) < 1e-9);
+
+        bool saved = replayed.saveSnapshot(snapshotPath);
+        RideSharingSystem loaded;
+        bool restored = saved && loaded.loadSnapshot(snapshotPath);
+        restored = restored && loaded.repriceRide(6, 4.0);
+        runTest("Snapshot recovers the surge", restored && loaded.getRideStore().getSurgePercents()[5] == 120 &&
+                                               std::abs(loaded.getRideStore().getFares()[5] - surgedFare) < 1e-9 &&
+                                               std::abs(loaded.findDriver(1)->getTotalEarnings() -
+                                                        loaded.getRideStore().totalRevenue()) < 1e-9);
+        uint16_t parkedSurge = replayed.getRideStore().getSurgePercents()[7];
+        restored = loaded.repriceRide(8, 4.0);
+        runTest("Snapshot stores a quote the fare cannot carry",
+                restored && loaded.getRideStore().getSurgePercents()[7] == parkedSurge &&
+                std::abs(loaded.getRideStore().getFares()[7] - StandardRide::fareFor(4.0) * parkedSurge / 100.0) < 1e-9);
+        
+        // Rewrite the file as version 1: same sections minus SurgePercents, shorter section table
+        std::string image;
+        {
+            std::ifstream in(snapshotPath, std::ios::binary);
+            image.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        const size_t headerBytes = 72; // Section table starts here: offsets[n], then sizes[n]
+        const uint32_t version1 = 1;
+        std::vector<uint64_t> table(2 * Snapshot::SECTION_COUNT);
+        std::memcpy(table.data(), image.data() + headerBytes, table.size() * sizeof(uint64_t));
+        std::memcpy(&image[8], &version1, sizeof(version1));
+        std::memcpy(&image[headerBytes], table.data(), Snapshot::VERSION_1_SECTIONS * sizeof(uint64_t));
+        std::memcpy(&image[headerBytes + Snapshot::VERSION_1_SECTIONS * sizeof(uint64_t)],
+                    table.data() + Snapshot::SECTION_COUNT, Snapshot::VERSION_1_SECTIONS * sizeof(uint64_t));
+        {
+            std::ofstream out(snapshotPath, std::ios::binary | std::ios::trunc);
+            out.write(image.data(), static_cast<std::streamsize>(image.size()));
+        }
+        RideSharingSystem legacy;
+        restored = legacy.loadSnapshot(snapshotPath);
+        runTest("Version 1 snapshot derives the surge", restored &&
+                                                        legacy.getRideStore().getSurgePercents()[5] == 120 &&
+                                                        legacy.getRideStore().getSurgePercents()[7] == 100);
+        std::remove(journalPath.c_str());
+        std::remove(snapshotPath.c_str());
+    }
+
+    void testLocationPool() {
+        std::cout << "\n=== Testing Location Interning ===" << std::endl;
+        
+        LocationPool pool;
+        uint32_t airport = pool.intern("Airport");
+        uint32_t downtown = pool.intern("Downtown");
+        std::string dynamicName = std::string("Air") + "port";
+        
+        runTest("Same name same ID", pool.intern(dynamicName) == airport);
+        runTest("Distinct names distinct IDs", airport != downtown);
+        runTest("Name lookup", pool.name(downtown) == "Downtown");
+        runTest("Pool size", pool.size() == 2);
+        
+        uint32_t found = 0;
+        runTest("Find existing name", pool.find("Downtown", found) && found == downtown);
+        runTest("Find missing name", !pool.find("Harbor", found));
+        
+        for (int i = 0; i < 5000; ++i) {
+            pool.intern("Zone " + std::to_string(i));
+        }
+        runTest("Views stable across growth", pool.name(airport) == "Airport" &&
+                                             pool.name(pool.intern("Zone 4999")) == "Zone 4999");
+        
+        StandardRide first(1, "Interned Pickup", "Interned Dropoff", 1.0);
+        StandardRide second(2, "Interned Dropoff", "Interned Pickup", 1.0);
+        runTest("Rides share location IDs", first.getPickupID() == second.getDropoffID());
+        runTest("Ride location view", first.getDropoffLocation() == "Interned Dropoff");
+        
+        // The name directory covers every 32-bit ID, allocating only what is used
+        ChunkDirectory<std::string_view, 12, 32> directory;
+        const size_t lastID = decltype(directory)::CAPACITY - 1;
+        runTest("Directory starts empty", directory.chunk(0) == nullptr && directory.chunk(lastID) == nullptr);
+        directory.allocate(lastID)[decltype(directory)::offset(lastID)] = "Far";
+        runTest("Directory reaches the last ID", directory.chunk(lastID)[decltype(directory)::offset(lastID)] == "Far");
+        runTest("Directory allocates lazily", directory.chunk(0) == nullptr && directory.chunk(lastID - 4096) == nullptr);
+    }
+    
+    void testLogger() {
+        std::cout << "\n=== Testing Logger ===" << std::endl;
+        
+        Logger& logger = Logger::instance();
+        FILE* capture = std::tmpfile();
+        logger.setOutput(capture);
+        logger.setLevel(LogLevel::Warn);
+        
+        LOG_INFO("filtered out");
+        LOG_WARN("kept " << 42);
+        LOG_ERROR("value " << std::fixed << std::setprecision(2) << 1.5);
+        LOG_INFO("also filtered");
+        logger.flush();
+        
+        std::string captured(256, '\0');
+        std::rewind(capture);
+        captured.resize(std::fread(&captured[0], 1, captured.size(), capture));
+        
+        logger.setOutput(stdout);
+        logger.setLevel(LogLevel::Info);
+        std::fclose(capture);
+        
+        runTest("Runtime level filter", captured.find("filtered") == std::string::npos);
+        runTest("Warn record written", captured.find("[WARN] kept 42\n") != std::string::npos);
+        runTest("Error record formatted", captured.find("[ERROR] value 1.50\n") != std::string::npos);
+        runTest("Records in order", captured.find("[WARN]") < captured.find("[ERROR]"));
+        runTest("Level query", logger.isEnabled(LogLevel::Info) && !logger.isEnabled(LogLevel::Debug));
+    }
+    
     void runAllTests() {
         std::cout << "======================================" << std::endl;
         std::cout << "RIDE SHARING SYSTEM - TEST SUITE" << std::endl;
@@ -141,6 +1980,33 @@ public:
         testRiderFunctionality();
         testPolymorphism();
         testSystemIntegration();
+        testRideStore();
+        testIdIndex();
+        testBatchCreation();
+        testLocationPool();
+        testTypeDispatch();
+        testFareKernel();
+        testRideTypeRegistry();
+        testStatsEngine();
+        testConcurrentDispatch();
+        testConcurrentRideChanges();
+        testSpatialMatching();
+        testInvalidDistances();
+        testDispatchEngine();
+        testSnapshot();
+        testJournal();
+        testRideIDExhaustion();
+        testTripImporter();
+        testMetrics();
+        testRidePool();
+        testRideTable();
+        testReports();
+        testRideQueries();
+        testTimeSeries();
+        testLeaderboard();
+        testSurgePricing();
+        testRunningTotals();
+        testLogger();
         
         std::cout << "\n======================================" << std::endl;
         std::cout << "TEST RESULTS" << std::endl;